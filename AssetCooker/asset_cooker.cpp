@@ -0,0 +1,307 @@
+#include "asset_cooker.h"
+#include "content_hash.h"
+#include "../ConsoleApplication1/mesh_file.h"
+#include "../ConsoleApplication1/mesh_optimizer.h"
+#include "../ConsoleApplication1/mesh_processing.h"
+#include "../ConsoleApplication1/meshlets.h"
+#include "../ConsoleApplication1/obj_parser.h"
+#include "../ConsoleApplication1/texture_file.h"
+#include "../ConsoleApplication1/thread_pool.h"
+#include "../ConsoleApplication1/triangle_bvh.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+static std::string lowercaseExtension(const fs::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension;
+}
+
+static uintmax_t fileSizeOrZero(const fs::path& path) {
+    std::error_code error;
+    uintmax_t size = fs::file_size(path, error);
+    return error ? 0 : size;
+}
+
+static std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    size_t end = text.find_last_not_of(" \t\r");
+    return begin == std::string::npos ? std::string() : text.substr(begin, end - begin + 1);
+}
+
+// File names listed after an OBJ/MTL keyword. Names may contain spaces, so the whole remainder
+// wins when it names an existing file; otherwise it is split on whitespace.
+static std::vector<fs::path> referencedFiles(const fs::path& directory, const std::string& remainder, bool lastTokenOnly) {
+    std::string whole = trim(remainder);
+    if (whole.empty()) {
+        return {};
+    }
+
+    std::error_code error;
+    if (fs::exists(directory / whole, error)) {
+        return { directory / whole };
+    }
+
+    std::vector<fs::path> files;
+    std::istringstream tokens(whole);
+    std::string token;
+    while (tokens >> token) {
+        files.push_back(directory / token);
+    }
+    if (lastTokenOnly && !files.empty()) {
+        // Texture statements put options such as "-bm 0.5" before the file name
+        return { files.back() };
+    }
+    return files;
+}
+
+static void appendUnique(std::vector<fs::path>& paths, const fs::path& path) {
+    fs::path normalized = path.lexically_normal();
+    if (std::find(paths.begin(), paths.end(), normalized) == paths.end()) {
+        paths.push_back(normalized);
+    }
+}
+
+AssetCooker::AssetCooker(const fs::path& inputDirectory, const fs::path& outputDirectory, const Options& options)
+    : inputDirectory(inputDirectory), outputDirectory(outputDirectory), options(options) {}
+
+std::vector<AssetCooker::Job> AssetCooker::collectJobs() const {
+    std::vector<Job> jobs;
+    for (const fs::directory_entry& entry : fs::recursive_directory_iterator(inputDirectory)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+
+        std::string extension = lowercaseExtension(entry.path());
+        fs::path relative = fs::relative(entry.path(), inputDirectory);
+
+        if (extension == ".obj") {
+            jobs.push_back({ AssetType::Mesh, entry.path(), outputDirectory / relative.replace_extension(".mesh") });
+        }
+        else if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga") {
+            jobs.push_back({ AssetType::Texture, entry.path(), outputDirectory / relative.replace_extension(".tex") });
+        }
+    }
+
+    // Directory iteration order is unspecified; keep the output stable between runs
+    std::sort(jobs.begin(), jobs.end(), [](const Job& a, const Job& b) { return a.input < b.input; });
+    return jobs;
+}
+
+std::vector<fs::path> AssetCooker::findInputs(const Job& job) {
+    std::vector<fs::path> inputs = { job.input.lexically_normal() };
+    if (job.type != AssetType::Mesh) {
+        return inputs;
+    }
+
+    std::vector<fs::path> materialFiles;
+    std::ifstream obj(job.input);
+    std::string line;
+    while (std::getline(obj, line)) {
+        if (line.compare(0, 7, "mtllib ") == 0) {
+            for (const fs::path& file : referencedFiles(job.input.parent_path(), line.substr(7), false)) {
+                appendUnique(materialFiles, file);
+            }
+        }
+    }
+
+    std::vector<fs::path> textures;
+    for (const fs::path& materialFile : materialFiles) {
+        appendUnique(inputs, materialFile);
+
+        std::ifstream mtl(materialFile);
+        while (std::getline(mtl, line)) {
+            std::istringstream fields(line);
+            std::string keyword;
+            fields >> keyword;
+            if (keyword.compare(0, 4, "map_") == 0 || keyword == "bump" || keyword == "disp" ||
+                keyword == "decal" || keyword == "refl") {
+                std::string remainder;
+                std::getline(fields, remainder);
+                for (const fs::path& file : referencedFiles(materialFile.parent_path(), remainder, true)) {
+                    appendUnique(textures, file);
+                }
+            }
+        }
+    }
+
+    for (const fs::path& texture : textures) {
+        appendUnique(inputs, texture);
+    }
+    return inputs;
+}
+
+uint64_t AssetCooker::optionsHash(AssetType type) const {
+    // Everything that changes the bytes of an output besides its inputs
+    std::ostringstream description;
+    if (type == AssetType::Mesh) {
+        description << "mesh;format=" << MESH_FILE_VERSION << ";optimize=" << options.optimizeMeshes << ";lods=";
+        for (float ratio : options.lodRatios) {
+            description << ratio << ',';
+        }
+    }
+    else {
+        description << "texture;format=" << TEXTURE_FILE_VERSION;
+    }
+    return hashString(description.str());
+}
+
+std::string AssetCooker::manifestKey(const Job& job) const {
+    return fs::relative(job.output, outputDirectory).generic_string();
+}
+
+AssetManifest::Entry AssetCooker::describe(const Job& job) const {
+    AssetManifest::Entry entry;
+    entry.cookerVersion = COOKER_VERSION;
+    entry.optionsHash = optionsHash(job.type);
+
+    for (const fs::path& input : findInputs(job)) {
+        AssetManifest::Input manifestInput;
+        manifestInput.path = fs::relative(input, inputDirectory).generic_string();
+        if (!hashFile(input, manifestInput.hash)) {
+            manifestInput.hash = AssetManifest::MISSING_INPUT;
+        }
+        entry.inputs.push_back(std::move(manifestInput));
+    }
+    return entry;
+}
+
+AssetCooker::Result AssetCooker::cook(const Job& job, const Options& options, ThreadPool* pool) {
+    Result result;
+    result.job = job;
+    result.inputBytes = fileSizeOrZero(job.input);
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    std::error_code error;
+    fs::create_directories(job.output.parent_path(), error);
+
+    if (job.type == AssetType::Mesh) {
+        MeshData mesh;
+        std::string mtlBasePath = job.input.parent_path().string() + "/";
+        result.success = ObjParser::load(job.input.string(), mtlBasePath, mesh, nullptr, pool);
+        std::ostringstream details;
+        details << std::fixed << std::setprecision(3);
+
+        if (result.success && !options.lodRatios.empty()) {
+            MeshSimplifier::buildLodChain(mesh, options.lodRatios, MeshSimplifier::defaultOptions());
+            details << "LOD tris/error";
+            for (size_t level = 0; level < mesh.lods.size(); ++level) {
+                details << ' ' << mesh.lodIndexCount(level) / 3 << '/' << mesh.lods[level].error;
+            }
+            details << "; ";
+        }
+        if (result.success && options.optimizeMeshes) {
+            MeshOptimizer::CacheStats before = MeshOptimizer::analyzeVertexCache(mesh);
+            MeshOptimizer::optimize(mesh);
+            MeshOptimizer::CacheStats after = MeshOptimizer::analyzeVertexCache(mesh);
+
+            details << "ACMR " << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr << "; ";
+        }
+        if (result.success) {
+            MeshletBuilder::build(mesh);
+            // Jobs already run one per worker, so the hierarchy is built serially
+            TriangleBvh::build(mesh, nullptr);
+            details << mesh.meshlets.size() << " meshlets, " << mesh.bvhNodes.size() << " BVH nodes, " << mesh.materials.size() << " materials";
+        }
+        result.details = details.str();
+        result.success = result.success && MeshFile::write(job.output.string(), mesh);
+    }
+    else {
+        result.success = TextureFile::cook(job.input.string(), job.output.string());
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    result.milliseconds = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+    result.outputBytes = result.success ? fileSizeOrZero(job.output) : 0;
+    return result;
+}
+
+bool AssetCooker::run(ThreadPool& pool) {
+    std::vector<Job> jobs = collectJobs();
+    std::cout << "Cooking " << jobs.size() << " assets from " << inputDirectory.string() << " with "
+        << pool.threadCount() << " threads" << std::endl;
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    fs::path manifestFilename = outputDirectory / "cook_manifest.txt";
+    AssetManifest previous;
+    previous.load(manifestFilename);
+
+    // Hash every input in parallel and decide which outputs are stale
+    std::vector<AssetManifest::Entry> entries(jobs.size());
+    std::vector<char> upToDate(jobs.size(), 0);
+    pool.parallelFor(jobs.size(), [&](size_t i) {
+        entries[i] = describe(jobs[i]);
+        const AssetManifest::Entry* recorded = previous.find(manifestKey(jobs[i]));
+        std::error_code error;
+        upToDate[i] = !options.force && recorded != nullptr && AssetManifest::sameInputs(*recorded, entries[i]) &&
+            fs::is_regular_file(jobs[i].output, error);
+    });
+
+    auto hashTime = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::future<Result>> pending(jobs.size());
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (!upToDate[i]) {
+            const Job& job = jobs[i];
+            const Options& jobOptions = options;
+            pending[i] = pool.submit([job, &jobOptions, &pool]() { return cook(job, jobOptions, &pool); });
+        }
+    }
+
+    AssetManifest manifest;
+    size_t failures = 0, hits = 0;
+    uintmax_t totalInput = 0, totalOutput = 0;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        Result result;
+        if (upToDate[i]) {
+            result.job = jobs[i];
+            result.success = true;
+            result.cached = true;
+            result.inputBytes = fileSizeOrZero(jobs[i].input);
+            result.outputBytes = fileSizeOrZero(jobs[i].output);
+            ++hits;
+        }
+        else {
+            result = pending[i].get();
+        }
+
+        totalInput += result.inputBytes;
+        totalOutput += result.outputBytes;
+        if (result.success) {
+            manifest.set(manifestKey(jobs[i]), std::move(entries[i]));
+        }
+        else {
+            ++failures;
+        }
+
+        std::cout << (result.cached ? "  cached" : result.success ? "  ok    " : "  FAIL  ")
+            << std::fixed << std::setprecision(1) << std::setw(9) << result.milliseconds << " ms  "
+            << std::setw(12) << result.inputBytes << " -> " << std::setw(12) << result.outputBytes << " bytes  "
+            << fs::relative(result.job.input, inputDirectory).string()
+            << (result.details.empty() ? "" : "  (" + result.details + ")") << std::endl;
+    }
+
+    std::error_code error;
+    fs::create_directories(outputDirectory, error);
+    manifest.save(manifestFilename);
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    std::cout << "Cache: " << hits << " hits, " << (jobs.size() - hits) << " misses (input hashing "
+        << std::chrono::duration<double, std::milli>(hashTime - startTime).count() << " ms)" << std::endl;
+    std::cout << "Cooked " << (jobs.size() - failures) << "/" << jobs.size() << " assets, "
+        << totalInput << " -> " << totalOutput << " bytes in "
+        << std::chrono::duration<double, std::milli>(endTime - startTime).count() << " ms" << std::endl;
+
+    return failures == 0;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#ifndef ASSET_COOKER_H
+#define ASSET_COOKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "asset_manifest.h"
+#include "../ConsoleApplication1/mesh_simplifier.h"
+
+class ThreadPool;
+
+// Converts a directory of source assets into the runtime formats:
+//   .obj (+ .mtl)        -> .mesh  (MeshFile)
+//   .png/.jpg/.jpeg/.tga -> .tex   (TextureFile)
+// Runs without a GL context. Outputs whose inputs are unchanged since the last run (per the
+// manifest in the output directory) are skipped.
+class AssetCooker {
+public:
+    // Bump whenever cooking logic changes in a way that alters outputs
+    static const uint32_t COOKER_VERSION = 5;
+
+    enum class AssetType {
+        Mesh,
+        Texture,
+    };
+
+    struct Options {
+        bool force = false;  // Ignore the manifest and cook everything
+        bool optimizeMeshes = true;  // Vertex cache, overdraw and vertex fetch ordering
+        std::vector<float> lodRatios = MeshSimplifier::defaultLodRatios();  // Empty: base mesh only
+    };
+
+    struct Job {
+        AssetType type;
+        std::filesystem::path input;
+        std::filesystem::path output;
+    };
+
+    struct Result {
+        Job job;
+        bool success = false;
+        bool cached = false;
+        double milliseconds = 0.0;
+        uintmax_t inputBytes = 0;
+        uintmax_t outputBytes = 0;
+        std::string details;  // Extra per-asset statistics for the report
+    };
+
+    AssetCooker(const std::filesystem::path& inputDirectory, const std::filesystem::path& outputDirectory,
+        const Options& options);
+
+    // Finds every cookable asset under the input directory
+    std::vector<Job> collectJobs() const;
+
+    // Every file the job's output depends on, primary input first: an OBJ, its MTL files and
+    // the textures they reference; a texture depends only on itself
+    static std::vector<std::filesystem::path> findInputs(const Job& job);
+
+    // Hash of the options that affect the output of this asset type
+    uint64_t optionsHash(AssetType type) const;
+
+    // Cooks out-of-date jobs on the pool, printing one line per asset and a summary.
+    // Returns false if any job failed.
+    bool run(ThreadPool& pool);
+
+    // With a pool, large OBJs are parsed in slices on it; idle workers pick them up while other jobs run
+    static Result cook(const Job& job, const Options& options, ThreadPool* pool = nullptr);
+
+private:
+    std::filesystem::path inputDirectory;
+    std::filesystem::path outputDirectory;
+    Options options;
+
+    AssetManifest::Entry describe(const Job& job) const;
+    std::string manifestKey(const Job& job) const;
+};
+
+#endif // ASSET_COOKER_H
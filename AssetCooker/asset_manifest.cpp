@@ -0,0 +1,119 @@
+#include "asset_manifest.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// Reads the rest of the line after the leading fields, which is a path that may contain spaces
+static std::string readPath(std::istringstream& line) {
+    std::string path;
+    std::getline(line >> std::ws, path);
+    return path;
+}
+
+bool AssetManifest::load(const std::filesystem::path& filename) {
+    entries.clear();
+
+    std::ifstream input(filename);
+    if (!input) {
+        return false;  // No manifest yet: everything is a miss
+    }
+
+    std::string text;
+    Entry* current = nullptr;
+    size_t lineNumber = 0;
+    while (std::getline(input, text)) {
+        ++lineNumber;
+        std::istringstream line(text);
+        std::string keyword;
+        line >> keyword;
+
+        if (keyword == "output") {
+            Entry entry;
+            size_t inputCount = 0;
+            line >> entry.cookerVersion >> std::hex >> entry.optionsHash >> std::dec >> inputCount;
+            std::string path = readPath(line);
+            entry.inputs.reserve(inputCount);
+            current = &(entries[path] = std::move(entry));
+        }
+        else if (keyword == "input" && current != nullptr) {
+            Input entryInput;
+            line >> std::hex >> entryInput.hash >> std::dec;
+            entryInput.path = readPath(line);
+            current->inputs.push_back(std::move(entryInput));
+        }
+        else if (!keyword.empty()) {
+            break;
+        }
+
+        if (line.fail()) {
+            break;
+        }
+    }
+
+    if (!input.eof()) {
+        // A damaged manifest only costs a full rebuild
+        std::cerr << "Ignoring corrupt cook manifest " << filename.string() << " at line " << lineNumber << std::endl;
+        entries.clear();
+        return false;
+    }
+    return true;
+}
+
+bool AssetManifest::save(const std::filesystem::path& filename) const {
+    std::filesystem::path temporary = filename;
+    temporary += ".tmp";
+
+    {
+        std::ofstream output(temporary, std::ios::trunc);
+        if (!output) {
+            std::cerr << "Failed to write cook manifest: " << temporary.string() << std::endl;
+            return false;
+        }
+
+        for (const auto& [path, entry] : entries) {
+            output << "output " << entry.cookerVersion << ' ' << std::hex << entry.optionsHash << std::dec << ' '
+                << entry.inputs.size() << ' ' << path << '\n';
+            for (const Input& entryInput : entry.inputs) {
+                output << "input " << std::hex << entryInput.hash << std::dec << ' ' << entryInput.path << '\n';
+            }
+        }
+
+        if (!output) {
+            std::cerr << "Failed to write cook manifest: " << temporary.string() << std::endl;
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, filename, error);
+    if (error) {
+        std::cerr << "Failed to replace cook manifest " << filename.string() << ": " << error.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const AssetManifest::Entry* AssetManifest::find(const std::string& outputPath) const {
+    auto it = entries.find(outputPath);
+    return it == entries.end() ? nullptr : &it->second;
+}
+
+void AssetManifest::set(const std::string& outputPath, Entry entry) {
+    entries[outputPath] = std::move(entry);
+}
+
+void AssetManifest::erase(const std::string& outputPath) {
+    entries.erase(outputPath);
+}
+
+bool AssetManifest::sameInputs(const Entry& a, const Entry& b) {
+    if (a.cookerVersion != b.cookerVersion || a.optionsHash != b.optionsHash || a.inputs.size() != b.inputs.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.inputs.size(); ++i) {
+        if (a.inputs[i].path != b.inputs[i].path || a.inputs[i].hash != b.inputs[i].hash) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#ifndef ASSET_MANIFEST_H
+#define ASSET_MANIFEST_H
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+// Record of what every cooked output was built from. An output is up to date when the cooker
+// version, the option hash and the content hash of every input still match.
+//
+// Text format, paths relative to the output directory for outputs and to the input directory for inputs:
+//   output <cooker version> <options hash> <input count> <output path>
+//   input <content hash> <input path>
+class AssetManifest {
+public:
+    struct Input {
+        std::string path;
+        uint64_t hash;  // MISSING_INPUT when the file did not exist at cook time
+    };
+
+    struct Entry {
+        uint32_t cookerVersion = 0;
+        uint64_t optionsHash = 0;
+        std::vector<Input> inputs;
+    };
+
+    static const uint64_t MISSING_INPUT = 0;
+
+    bool load(const std::filesystem::path& filename);
+    // Writes to a temporary file first so an interrupted cook never leaves a truncated manifest
+    bool save(const std::filesystem::path& filename) const;
+
+    const Entry* find(const std::string& outputPath) const;
+    void set(const std::string& outputPath, Entry entry);
+    void erase(const std::string& outputPath);
+    size_t size() const { return entries.size(); }
+
+    static bool sameInputs(const Entry& a, const Entry& b);
+
+private:
+    std::map<std::string, Entry> entries;  // Ordered so the file diffs cleanly
+};
+
+#endif // ASSET_MANIFEST_H
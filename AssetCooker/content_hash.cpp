@@ -0,0 +1,68 @@
+#include "content_hash.h"
+#include "../ConsoleApplication1/mapped_file.h"
+#include <cstring>
+#include <system_error>
+
+static uint64_t mix(uint64_t a, uint64_t b) {
+    // 64x64 -> 128 multiply folded back to 64 bits
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#else
+    uint64_t aLow = a & 0xFFFFFFFFull, aHigh = a >> 32;
+    uint64_t bLow = b & 0xFFFFFFFFull, bHigh = b >> 32;
+    uint64_t lowLow = aLow * bLow, lowHigh = aLow * bHigh, highLow = aHigh * bLow, highHigh = aHigh * bHigh;
+    uint64_t middle = (lowLow >> 32) + (lowHigh & 0xFFFFFFFFull) + (highLow & 0xFFFFFFFFull);
+    uint64_t low = (lowLow & 0xFFFFFFFFull) | (middle << 32);
+    uint64_t high = highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+    return low ^ high;
+#endif
+}
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed) {
+    const uint64_t PRIME0 = 0xA0761D6478BD642Full;
+    const uint64_t PRIME1 = 0xE7037ED1A0B428DBull;
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t state0 = seed ^ PRIME0;
+    uint64_t state1 = seed + PRIME1;
+
+    // Two independent lanes of 8 bytes keep the multiplier busy
+    size_t offset = 0;
+    for (; offset + 16 <= size; offset += 16) {
+        uint64_t word0, word1;
+        std::memcpy(&word0, bytes + offset, 8);
+        std::memcpy(&word1, bytes + offset + 8, 8);
+        state0 = mix(word0 ^ PRIME1, state0 ^ PRIME0);
+        state1 = mix(word1 ^ PRIME0, state1 ^ PRIME1);
+    }
+
+    uint64_t tail[2] = { 0, 0 };
+    std::memcpy(tail, bytes + offset, size - offset);
+    state0 = mix(tail[0] ^ PRIME1, state0 ^ PRIME0);
+    state1 = mix(tail[1] ^ PRIME0, state1 ^ PRIME1);
+
+    return mix(state0 ^ static_cast<uint64_t>(size), state1 ^ PRIME1);
+}
+
+uint64_t hashString(const std::string& text, uint64_t seed) {
+    return hashBytes(text.data(), text.size(), seed);
+}
+
+bool hashFile(const std::filesystem::path& path, uint64_t& hash) {
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error)) {
+        return false;
+    }
+    if (std::filesystem::file_size(path, error) == 0 && !error) {
+        hash = hashBytes(nullptr, 0);
+        return true;
+    }
+
+    MappedFile file;
+    if (!file.open(path.string())) {
+        return false;
+    }
+    hash = hashBytes(file.data(), file.size());
+    return true;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#ifndef CONTENT_HASH_H
+#define CONTENT_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+// 64-bit non-cryptographic content hash used to detect changed cooker inputs
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0);
+uint64_t hashString(const std::string& text, uint64_t seed = 0);
+
+// Hashes the whole file through a memory mapping. Empty files hash to hashBytes(nullptr, 0).
+bool hashFile(const std::filesystem::path& path, uint64_t& hash);
+
+#endif // CONTENT_HASH_H
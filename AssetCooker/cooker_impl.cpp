@@ -0,0 +1,6 @@
+// Single-header library implementations for the cooker; the game compiles its own copies elsewhere
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../ConsoleApplication1/stb_image.h"
@@ -0,0 +1,935 @@
+// Offline asset cooker: converts OBJ/MTL/PNG/JPG sources into the cooked runtime formats.
+// Usage: AssetCooker <input directory> <output directory> [--threads N] [--force] [--no-optimize] [--no-lods]
+//        AssetCooker --benchmark-obj <file.obj> [mtl base path] [--threads N]
+//        AssetCooker --benchmark-dedup <file.obj>
+//        AssetCooker --benchmark-threads <file.obj>
+//        AssetCooker --test-obj-lines [--threads N]
+//        AssetCooker --benchmark-glb <file.glb> <equivalent file.obj>
+//        AssetCooker --benchmark-culling [object count]
+//        AssetCooker --benchmark-bvh
+//        AssetCooker --benchmark-raycast <file.obj>
+//        AssetCooker --benchmark-picking <file.obj>
+//        AssetCooker --benchmark-character
+//        AssetCooker --benchmark-sap [body count]
+#include "asset_cooker.h"
+#include "../ConsoleApplication1/character_controller.h"
+#include "../ConsoleApplication1/frustum_culler.h"
+#include "../ConsoleApplication1/gltf_file.h"
+#include "../ConsoleApplication1/load_benchmark.h"
+#include "../ConsoleApplication1/mesh_processing.h"
+#include "../ConsoleApplication1/obj_parser.h"
+#include "../ConsoleApplication1/process_memory.h"
+#include "../ConsoleApplication1/scene_bvh.h"
+#include "../ConsoleApplication1/scene_picker.h"
+#include "../ConsoleApplication1/sweep_and_prune.h"
+#include "../ConsoleApplication1/thread_pool.h"
+#include "../ConsoleApplication1/triangle_bvh.h"
+#include "../ConsoleApplication1/vertex_dedup.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+static void printUsage() {
+    std::cerr << "Usage: AssetCooker <input directory> <output directory> [--threads N] [--force] [--no-optimize] [--no-lods]" << std::endl;
+    std::cerr << "       AssetCooker --benchmark-obj <file.obj> [mtl base path] [--threads N]" << std::endl;
+    std::cerr << "       AssetCooker --benchmark-dedup <file.obj>" << std::endl;
+    std::cerr << "       AssetCooker --benchmark-threads <file.obj>" << std::endl;
+    std::cerr << "       AssetCooker --test-obj-lines [--threads N]" << std::endl;
+    std::cerr << "       AssetCooker --benchmark-glb <file.glb> <equivalent file.obj>" << std::endl;
+    std::cerr << "       AssetCooker --benchmark-culling [object count]" << std::endl;
+    std::cerr << "       AssetCooker --benchmark-bvh" << std::endl;
+    std::cerr << "       AssetCooker --benchmark-raycast <file.obj>" << std::endl;
+    std::cerr << "       AssetCooker --benchmark-picking <file.obj>" << std::endl;
+    std::cerr << "       AssetCooker --benchmark-character" << std::endl;
+    std::cerr << "       AssetCooker --benchmark-sap [body count]" << std::endl;
+}
+
+static double megabytes(size_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+// Loads one OBJ with the streaming parser and then with tinyobj, reporting time, throughput and how far
+// each pushed resident memory above where it started. The peak only grows, so the streaming parser runs
+// first; if tinyobj does not exceed its peak, tinyobj's figure is an upper bound rather than its own peak.
+// Then parses it again in slices on the pool and checks that the result is the same.
+static int benchmarkObj(const std::string& objFilename, const std::string& mtlBasePath, ThreadPool& pool) {
+    size_t baseline = currentResidentBytes();
+
+    MeshData streamed;
+    ObjParser::Stats stats;
+    if (!ObjParser::load(objFilename, mtlBasePath, streamed, &stats)) {
+        return 1;
+    }
+    size_t streamingPeak = peakResidentBytes();
+    std::cout << "streaming: " << stats.milliseconds << " ms, " << stats.megabytesPerSecond() << " MB/s, peak +"
+        << megabytes(std::max(streamingPeak, baseline) - baseline) << " MB (" << megabytes(stats.bytes) << " MB read, " << stats.triangles
+        << " triangles, " << streamed.vertices.size() << " vertices)" << std::endl;
+
+    MeshData reference;
+    size_t tinyobjBaseline = currentResidentBytes();  // The streamed mesh stays resident for the comparison
+    auto startTime = std::chrono::high_resolution_clock::now();
+    // MeshProcessor resolves MTL files through tinyobj, which takes the base path literally
+    std::string tinyobjBasePath = mtlBasePath.empty() ? std::filesystem::path(objFilename).parent_path().string() + "/" : mtlBasePath;
+    if (!MeshProcessor::loadObj(objFilename, tinyobjBasePath, reference, pool)) {
+        return 1;
+    }
+    auto endTime = std::chrono::high_resolution_clock::now();
+    double milliseconds = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+    size_t tinyobjPeak = peakResidentBytes();
+    std::cout << "tinyobj:   " << milliseconds << " ms, " << megabytes(stats.bytes) / (milliseconds / 1000.0) << " MB/s, peak "
+        << (tinyobjPeak > streamingPeak ? "+" : "<= +") << megabytes(std::max(tinyobjPeak, tinyobjBaseline) - tinyobjBaseline) << " MB ("
+        << pool.threadCount() << " threads)" << std::endl;
+
+    bool sameVertices = streamed.vertices.size() == reference.vertices.size() &&
+        std::equal(streamed.vertices.begin(), streamed.vertices.end(), reference.vertices.begin(), VertexDeduplicator::sameBits);
+    bool sameIndices = streamed.indices == reference.indices;
+    std::cout << "Outputs " << (sameVertices && sameIndices ? "match" : "differ")
+        << ": " << streamed.submeshes.size() << " / " << reference.submeshes.size() << " submeshes, "
+        << streamed.materials.size() << " / " << reference.materials.size() << " materials" << std::endl;
+
+    // Last, so its peak does not hide tinyobj's
+    MeshData sliced;
+    ObjParser::Stats slicedStats;
+    if (!ObjParser::load(objFilename, mtlBasePath, sliced, &slicedStats, &pool)) {
+        return 1;
+    }
+    bool sameSliced = sliced.vertices.size() == streamed.vertices.size() &&
+        std::equal(sliced.vertices.begin(), sliced.vertices.end(), streamed.vertices.begin(), VertexDeduplicator::sameBits) &&
+        sliced.indices == streamed.indices && sliced.submeshes.size() == streamed.submeshes.size() &&
+        sliced.materials.size() == streamed.materials.size();
+    std::cout << "sliced:    " << slicedStats.milliseconds << " ms, " << slicedStats.megabytesPerSecond() << " MB/s ("
+        << slicedStats.chunks << " slices, " << pool.threadCount() << " threads), output "
+        << (sameSliced ? "matches" : "differs from") << " streaming" << std::endl;
+    return sameSliced ? 0 : 1;
+}
+
+// Writes an OBJ with indented element lines, a bare "v" and unknown keywords that start like "vn", large
+// enough to be split into slices, and checks that serial and sliced parsing both count every element
+// where it is and agree with each other
+static int testObjLines(ThreadPool& pool) {
+    std::filesystem::path objPath = std::filesystem::temp_directory_path() / "asset_cooker_obj_lines.obj";
+    const size_t blockCount = 200000;
+    {
+        std::ofstream obj(objPath, std::ios::binary);
+        for (size_t block = 0; block < blockCount; ++block) {
+            obj << "  v " << block << " 0 0\n"
+                << "v\n"
+                << "vnx 1 2 3\n"
+                << "vtx 1 2\n"
+                << "\tv " << block << " 1 0\n"
+                << "v " << block << " 0 1\n"
+                << "vn 0 0 1\n"
+                << " vt 0.5 0.5\n"
+                << "\tf -1/-1/-1 -2/-1/-1 -3/-1/-1 -4/-1/-1\n";
+        }
+    }
+
+    MeshData serial, sliced;
+    ObjParser::Stats serialStats, slicedStats;
+    bool loaded = ObjParser::load(objPath.string(), std::string(), serial, &serialStats) &&
+        ObjParser::load(objPath.string(), std::string(), sliced, &slicedStats, &pool);
+    std::filesystem::remove(objPath);
+    if (!loaded) {
+        return 1;
+    }
+
+    bool counted = serialStats.positions == blockCount * 4 && serialStats.normals == blockCount && serialStats.texCoords == blockCount &&
+        serialStats.triangles == blockCount * 2 && slicedStats.positions == serialStats.positions &&
+        slicedStats.normals == serialStats.normals && slicedStats.texCoords == serialStats.texCoords;
+    bool same = sliced.vertices.size() == serial.vertices.size() &&
+        std::equal(sliced.vertices.begin(), sliced.vertices.end(), serial.vertices.begin(), VertexDeduplicator::sameBits) &&
+        sliced.indices == serial.indices;
+    std::cout << serialStats.positions << " positions, " << serialStats.triangles << " triangles, " << slicedStats.chunks << " slices: counts "
+        << (counted ? "ok" : "WRONG") << ", sliced output " << (same ? "matches" : "DIFFERS FROM") << " serial" << std::endl;
+    return counted && same ? 0 : 1;
+}
+
+// Loads the same model from a .glb and from an OBJ, up to the point where the vertex and index data is
+// ready to upload
+static int benchmarkGlb(const std::string& glbFilename, const std::string& objFilename) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    GltfFile file;
+    MeshData gltfMesh;
+    GltfMeshSource source;
+    if (!file.open(glbFilename) || !file.readMesh(gltfMesh, source)) {
+        return 1;
+    }
+    auto endTime = std::chrono::high_resolution_clock::now();
+    double milliseconds = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+    size_t glbBytes = static_cast<size_t>(std::filesystem::file_size(glbFilename));
+    std::cout << "glb: " << milliseconds << " ms, " << megabytes(glbBytes) / (milliseconds / 1000.0) << " MB/s ("
+        << megabytes(glbBytes) << " MB, " << gltfMesh.indices.size() / 3 << " triangles, " << source.vertexCount << " vertices, "
+        << (source.directVertices != nullptr ? "direct" : "copied") << ")" << std::endl;
+
+    MeshData objMesh;
+    ObjParser::Stats stats;
+    if (!ObjParser::load(objFilename, std::string(), objMesh, &stats)) {
+        return 1;
+    }
+    std::cout << "obj: " << stats.milliseconds << " ms, " << stats.megabytesPerSecond() << " MB/s (" << megabytes(stats.bytes) << " MB, "
+        << stats.triangles << " triangles, " << objMesh.vertices.size() << " vertices)" << std::endl;
+    if (milliseconds > 0.0) {
+        std::cout << "glb loads " << stats.milliseconds / milliseconds << "x as fast" << std::endl;
+    }
+    return 0;
+}
+
+// Culls a random field of boxes with every path the CPU supports, checking each visible list against the
+// scalar one
+static int benchmarkCulling(size_t objectCount) {
+    const int rounds = 50;
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+    std::uniform_real_distribution<float> size(0.1f, 4.0f);
+    FrustumCuller culler;
+    for (size_t i = 0; i < objectCount; ++i) {
+        glm::vec3 center(position(random), position(random) * 0.1f, position(random));
+        glm::vec3 extent(size(random), size(random), size(random));
+        culler.add(center - extent, center + extent);
+    }
+    glm::mat4 projection = glm::perspective(glm::radians(90.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(1.0f, 2.0f, 0.5f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum = Frustum::fromMatrix(projection * view);
+
+    std::vector<uint32_t> reference;
+    double scalarMilliseconds = 0.0;
+    bool allMatch = true;
+    for (FrustumCuller::Path path : { FrustumCuller::Path::Scalar, FrustumCuller::Path::Sse, FrustumCuller::Path::Avx }) {
+        if (!FrustumCuller::isSupported(path)) {
+            std::cout << FrustumCuller::pathName(path) << ": not supported" << std::endl;
+            continue;
+        }
+        std::vector<uint32_t> visible;
+        culler.cull(frustum, visible, path);
+        auto startTime = std::chrono::high_resolution_clock::now();
+        for (int round = 0; round < rounds; ++round) {
+            culler.cull(frustum, visible, path);
+        }
+        auto endTime = std::chrono::high_resolution_clock::now();
+        double milliseconds = std::chrono::duration<double, std::milli>(endTime - startTime).count() / rounds;
+
+        if (path == FrustumCuller::Path::Scalar) {
+            reference = visible;
+            scalarMilliseconds = milliseconds;
+        }
+        bool matches = visible == reference;
+        allMatch = allMatch && matches;
+        std::cout << FrustumCuller::pathName(path) << ": " << milliseconds << " ms, " << objectCount / milliseconds / 1000.0
+            << " M objects/s, " << visible.size() << " visible";
+        if (path != FrustumCuller::Path::Scalar) {
+            std::cout << ", " << scalarMilliseconds / milliseconds << "x scalar, " << (matches ? "matches" : "DIFFERS FROM") << " scalar";
+        }
+        std::cout << std::endl;
+    }
+    return allMatch ? 0 : 1;
+}
+
+template <typename Function>
+static double timeMilliseconds(Function function) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    function();
+    auto endTime = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
+
+// Frustum, ray and radius queries through SceneBvh against linear scans over the same boxes, at a fixed
+// object density so the queries touch a similar number of objects at every size
+static int benchmarkBvh() {
+    const size_t queryCount = 1000;
+    bool allMatch = true;
+    for (size_t objectCount : { static_cast<size_t>(1000), static_cast<size_t>(10000), static_cast<size_t>(100000) }) {
+        std::mt19937 random(1234);
+        float halfWorld = 5.0f * std::sqrt(static_cast<float>(objectCount));
+        std::uniform_real_distribution<float> position(-halfWorld, halfWorld);
+        std::uniform_real_distribution<float> height(0.0f, 4.0f);
+        std::uniform_real_distribution<float> size(0.2f, 2.0f);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+        std::vector<SceneBvh::Item> items(objectCount);
+        FrustumCuller linearCuller;
+        for (size_t i = 0; i < objectCount; ++i) {
+            glm::vec3 center(position(random), height(random), position(random));
+            glm::vec3 extent(size(random), size(random), size(random));
+            items[i] = { static_cast<uint32_t>(i), center - extent, center + extent };
+            linearCuller.add(items[i].boxMin, items[i].boxMax);
+        }
+
+        SceneBvh bvh(0.0f);
+        double buildMilliseconds = timeMilliseconds([&]() { bvh.build(items.data(), items.size()); });
+        SceneBvh dynamicBvh;
+        double insertMilliseconds = timeMilliseconds([&]() {
+            for (const SceneBvh::Item& item : items) {
+                dynamicBvh.insert(item.object, item.boxMin, item.boxMax);
+            }
+        });
+        // A tenth of the objects walk a short way, as they would in one frame
+        std::uniform_real_distribution<float> step(-0.3f, 0.3f);
+        size_t moved = 0;
+        double updateMilliseconds = timeMilliseconds([&]() {
+            for (size_t i = 0; i < objectCount; i += 10) {
+                glm::vec3 offset(step(random), 0.0f, step(random));
+                moved += dynamicBvh.update(items[i].object, items[i].boxMin + offset, items[i].boxMax + offset) ? 1 : 0;
+            }
+        });
+        SceneBvh::Stats built = bvh.stats();
+        SceneBvh::Stats inserted = dynamicBvh.stats();
+        std::cout << objectCount << " objects: SAH build " << buildMilliseconds << " ms (height " << built.height << ", cost "
+            << built.sahCost << "), inserts " << insertMilliseconds << " ms (height " << inserted.height << ", cost " << inserted.sahCost
+            << "), moving " << objectCount / 10 << " took " << updateMilliseconds << " ms with " << moved << " reinserted" << std::endl;
+
+        // Cameras and rays on the ground among the objects, looking in random directions
+        std::vector<glm::vec3> origins(queryCount), directions(queryCount);
+        for (size_t i = 0; i < queryCount; ++i) {
+            float a = angle(random);
+            origins[i] = glm::vec3(position(random), 1.8f, position(random));
+            directions[i] = glm::vec3(std::cos(a), -0.05f, std::sin(a));
+        }
+        glm::mat4 projection = glm::perspective(glm::radians(90.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+        std::vector<Frustum> frustums(queryCount);
+        for (size_t i = 0; i < queryCount; ++i) {
+            frustums[i] = Frustum::fromMatrix(projection * glm::lookAt(origins[i], origins[i] + directions[i], glm::vec3(0.0f, 1.0f, 0.0f)));
+        }
+        const float rayLength = 100.0f;
+        const float queryRadius = 10.0f;
+
+        std::vector<std::vector<uint32_t>> bvhResults(queryCount), linearResults(queryCount);
+        std::vector<SceneBvh::RayHit> hits;
+        auto report = [&](const char* query, double bvhMilliseconds, double linearMilliseconds) {
+            size_t found = 0;
+            bool matches = true;
+            for (size_t i = 0; i < queryCount; ++i) {
+                std::sort(bvhResults[i].begin(), bvhResults[i].end());
+                std::sort(linearResults[i].begin(), linearResults[i].end());
+                matches = matches && bvhResults[i] == linearResults[i];
+                found += bvhResults[i].size();
+            }
+            allMatch = allMatch && matches;
+            std::cout << "  " << query << ": BVH " << queryCount / bvhMilliseconds << " k queries/s, linear " << queryCount / linearMilliseconds
+                << " k queries/s, " << linearMilliseconds / bvhMilliseconds << "x, " << static_cast<double>(found) / queryCount << " objects per query, "
+                << (matches ? "results match" : "RESULTS DIFFER") << std::endl;
+        };
+
+        double bvhMilliseconds = timeMilliseconds([&]() {
+            for (size_t i = 0; i < queryCount; ++i) {
+                bvh.queryFrustum(frustums[i], bvhResults[i]);
+            }
+        });
+        double linearMilliseconds = timeMilliseconds([&]() {
+            for (size_t i = 0; i < queryCount; ++i) {
+                linearCuller.cull(frustums[i], linearResults[i]);
+            }
+        });
+        report("frustum (linear is FrustumCuller)", bvhMilliseconds, linearMilliseconds);
+
+        bvhMilliseconds = timeMilliseconds([&]() {
+            for (size_t i = 0; i < queryCount; ++i) {
+                bvh.queryRay(origins[i], directions[i], rayLength, hits);
+                bvhResults[i].clear();
+                for (const SceneBvh::RayHit& hit : hits) {
+                    bvhResults[i].push_back(hit.object);
+                }
+            }
+        });
+        linearMilliseconds = timeMilliseconds([&]() {
+            for (size_t i = 0; i < queryCount; ++i) {
+                linearResults[i].clear();
+                glm::vec3 inverseDirection = 1.0f / directions[i];
+                for (const SceneBvh::Item& item : items) {
+                    glm::vec3 t0 = (item.boxMin - origins[i]) * inverseDirection;
+                    glm::vec3 t1 = (item.boxMax - origins[i]) * inverseDirection;
+                    glm::vec3 tNear = glm::min(t0, t1);
+                    glm::vec3 tFar = glm::max(t0, t1);
+                    float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+                    float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, rayLength));
+                    if (enter <= exit) {
+                        linearResults[i].push_back(item.object);
+                    }
+                }
+            }
+        });
+        report("ray", bvhMilliseconds, linearMilliseconds);
+
+        bvhMilliseconds = timeMilliseconds([&]() {
+            for (size_t i = 0; i < queryCount; ++i) {
+                bvh.queryRadius(origins[i], queryRadius, bvhResults[i]);
+            }
+        });
+        linearMilliseconds = timeMilliseconds([&]() {
+            for (size_t i = 0; i < queryCount; ++i) {
+                linearResults[i].clear();
+                for (const SceneBvh::Item& item : items) {
+                    glm::vec3 offset = origins[i] - glm::clamp(origins[i], item.boxMin, item.boxMax);
+                    if (glm::dot(offset, offset) <= queryRadius * queryRadius) {
+                        linearResults[i].push_back(item.object);
+                    }
+                }
+            }
+        });
+        report("radius", bvhMilliseconds, linearMilliseconds);
+    }
+    return allMatch ? 0 : 1;
+}
+
+// Nearest hit over every triangle, for checking TriangleBvh::raycast
+static float bruteForceRaycast(const MeshData& mesh, const glm::vec3& origin, const glm::vec3& direction, float maxDistance) {
+    float best = maxDistance;
+    for (size_t i = 0; i + 3 <= mesh.indices.size(); i += 3) {
+        glm::vec3 v0 = mesh.vertices[mesh.indices[i]].position;
+        glm::vec3 edge1 = mesh.vertices[mesh.indices[i + 1]].position - v0;
+        glm::vec3 edge2 = mesh.vertices[mesh.indices[i + 2]].position - v0;
+        glm::vec3 p = glm::cross(direction, edge2);
+        float det = glm::dot(edge1, p);
+        if (det == 0.0f) {
+            continue;
+        }
+        glm::vec3 s = origin - v0;
+        glm::vec3 q = glm::cross(s, edge1);
+        float u = glm::dot(s, p) / det;
+        float v = glm::dot(direction, q) / det;
+        float t = glm::dot(edge2, q) / det;
+        if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t < best) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+// Builds the triangle hierarchy of an OBJ serially and on every core, then casts rays from around the
+// model towards random points inside it and runs sphere and capsule queries, checking a sample of each
+// against a scan over every triangle
+static int benchmarkRaycast(const std::string& objFilename) {
+    MeshData mesh;
+    if (!ObjParser::load(objFilename, std::string(), mesh)) {
+        return 1;
+    }
+    ThreadPool pool;
+    TriangleBvh::BuildStats serialStats, parallelStats;
+    TriangleBvh::build(mesh, nullptr, &serialStats);
+    std::vector<TriangleBvhNode> serialNodes = mesh.bvhNodes;
+    std::vector<TrianglePacket> serialPackets = mesh.bvhPackets;
+    TriangleBvh::build(mesh, &pool, &parallelStats);
+    bool sameTree = serialNodes.size() == mesh.bvhNodes.size() && serialPackets.size() == mesh.bvhPackets.size() &&
+        std::memcmp(serialNodes.data(), mesh.bvhNodes.data(), serialNodes.size() * sizeof(TriangleBvhNode)) == 0 &&
+        std::memcmp(serialPackets.data(), mesh.bvhPackets.data(), serialPackets.size() * sizeof(TrianglePacket)) == 0;
+    std::cout << serialStats.triangles << " triangles: build " << serialStats.milliseconds << " ms serial, " << parallelStats.milliseconds
+        << " ms on " << pool.threadCount() << " threads (" << (sameTree ? "identical" : "TREES DIFFER") << "), " << serialStats.nodes
+        << " nodes, " << serialStats.packets << " packets (" << 100.0 * serialStats.triangles / (serialStats.packets * 4.0)
+        << "% lanes used), depth " << serialStats.depth << std::endl;
+
+    const size_t rayCount = 100000;
+    const size_t checkedCount = 200;
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    glm::vec3 center = (mesh.boundsMin + mesh.boundsMax) * 0.5f;
+    float radius = glm::length(mesh.boundsMax - mesh.boundsMin) * 0.5f;
+    auto insideBox = [&]() {
+        return mesh.boundsMin + (mesh.boundsMax - mesh.boundsMin) * glm::vec3(unit(random), unit(random), unit(random));
+    };
+    std::vector<glm::vec3> origins(rayCount), directions(rayCount);
+    for (size_t i = 0; i < rayCount; ++i) {
+        glm::vec3 offset(unit(random) * 2.0f - 1.0f, unit(random) * 2.0f - 1.0f, unit(random) * 2.0f - 1.0f);
+        origins[i] = center + glm::normalize(offset) * radius * 1.5f;
+        directions[i] = glm::normalize(insideBox() - origins[i]);
+    }
+    const float maxDistance = radius * 4.0f;
+
+    size_t hitCount = 0;
+    std::vector<float> distances(rayCount);
+    double milliseconds = timeMilliseconds([&]() {
+        for (size_t i = 0; i < rayCount; ++i) {
+            TriangleBvh::RayHit hit;
+            distances[i] = TriangleBvh::raycast(mesh, origins[i], directions[i], maxDistance, hit) ? hit.distance : maxDistance;
+            hitCount += hit.triangle != TriangleBvh::INVALID_TRIANGLE ? 1 : 0;
+        }
+    });
+    bool raysMatch = true;
+    for (size_t i = 0; i < checkedCount; ++i) {
+        float expected = bruteForceRaycast(mesh, origins[i], directions[i], maxDistance);
+        raysMatch = raysMatch && std::fabs(expected - distances[i]) <= 1e-4f * radius;
+    }
+    std::cout << "  rays: " << rayCount / milliseconds / 1000.0 << " M rays/s, " << 100.0 * hitCount / rayCount << "% hit, first "
+        << checkedCount << " " << (raysMatch ? "match" : "DIFFER FROM") << " brute force" << std::endl;
+
+    // Spheres and capsules a few percent of the model's size, placed inside its box
+    const size_t queryCount = 20000;
+    const float queryRadius = radius * 0.03f;
+    std::vector<glm::vec3> centers(queryCount), ends(queryCount);
+    for (size_t i = 0; i < queryCount; ++i) {
+        centers[i] = insideBox();
+        ends[i] = centers[i] + glm::vec3(0.0f, radius * 0.1f, 0.0f);
+    }
+    std::vector<TriangleBvh::Contact> contacts;
+    std::vector<size_t> contactCounts(queryCount);
+    size_t contactTotal = 0;
+    milliseconds = timeMilliseconds([&]() {
+        for (size_t i = 0; i < queryCount; ++i) {
+            TriangleBvh::overlapSphere(mesh, centers[i], queryRadius, contacts);
+            contactCounts[i] = contacts.size();
+            contactTotal += contacts.size();
+        }
+    });
+    bool spheresMatch = true;
+    for (size_t i = 0; i < checkedCount; ++i) {
+        size_t expected = 0;
+        for (size_t k = 0; k + 3 <= mesh.indices.size(); k += 3) {
+            glm::vec3 a = mesh.vertices[mesh.indices[k]].position;
+            glm::vec3 b = mesh.vertices[mesh.indices[k + 1]].position;
+            glm::vec3 c = mesh.vertices[mesh.indices[k + 2]].position;
+            if (glm::length(glm::cross(b - a, c - a)) == 0.0f) {
+                continue;  // Degenerate triangles are not in the hierarchy's tests
+            }
+            glm::vec3 offset = centers[i] - TriangleBvh::closestPointOnTriangle(centers[i], a, b, c);
+            expected += glm::dot(offset, offset) <= queryRadius * queryRadius ? 1 : 0;
+        }
+        spheresMatch = spheresMatch && expected == contactCounts[i];
+    }
+    std::cout << "  spheres: " << queryCount / milliseconds << " k queries/s, " << static_cast<double>(contactTotal) / queryCount
+        << " contacts per query, first " << checkedCount << " " << (spheresMatch ? "match" : "DIFFER FROM") << " brute force" << std::endl;
+
+    contactTotal = 0;
+    milliseconds = timeMilliseconds([&]() {
+        for (size_t i = 0; i < queryCount; ++i) {
+            TriangleBvh::overlapCapsule(mesh, centers[i], ends[i], queryRadius, contacts);
+            contactTotal += contacts.size();
+        }
+    });
+    std::cout << "  capsules: " << queryCount / milliseconds << " k queries/s, " << static_cast<double>(contactTotal) / queryCount
+        << " contacts per query" << std::endl;
+    return sameTree && raysMatch && spheresMatch ? 0 : 1;
+}
+
+// Scatters copies of an OBJ over a ground box and casts line-of-sight rays between random points above
+// the ground through ScenePicker: serially, on every core, and in per-frame budgets. The first rays are
+// checked against a test of every copy's mesh.
+static int benchmarkPicking(const std::string& objFilename) {
+    MeshData mesh;
+    if (!ObjParser::load(objFilename, std::string(), mesh)) {
+        return 1;
+    }
+    ThreadPool pool;
+    TriangleBvh::build(mesh, &pool);
+
+    // A grid of copies with random turns and sizes, spaced a few model sizes apart
+    const size_t gridSize = 32;
+    const uint32_t groundObject = 0;
+    float radius = glm::length(mesh.boundsMax - mesh.boundsMin) * 0.5f;
+    float spacing = radius * 3.0f;
+    float halfWorld = spacing * gridSize * 0.5f;
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    SceneBvh scene(0.0f);
+    ScenePicker picker(scene);
+    std::vector<SceneBvh::Item> items;
+    std::vector<glm::mat4> transforms;
+    items.push_back({ groundObject, glm::vec3(-halfWorld, -1.0f, -halfWorld), glm::vec3(halfWorld, 0.0f, halfWorld) });
+    for (size_t x = 0; x < gridSize; ++x) {
+        for (size_t z = 0; z < gridSize; ++z) {
+            glm::vec3 position(-halfWorld + (x + 0.5f) * spacing, radius, -halfWorld + (z + 0.5f) * spacing);
+            glm::mat4 transform = glm::translate(glm::mat4(1.0f), position);
+            transform = glm::rotate(transform, unit(random) * 6.2831853f, glm::vec3(0.0f, 1.0f, 0.0f));
+            transform = glm::scale(transform, glm::vec3(0.5f + unit(random)));
+            // Box around the transformed box, as Model::getWorldBounds makes it
+            glm::vec3 center = glm::vec3(transform * glm::vec4((mesh.boundsMin + mesh.boundsMax) * 0.5f, 1.0f));
+            glm::vec3 extent = (mesh.boundsMax - mesh.boundsMin) * 0.5f;
+            glm::vec3 worldExtent(0.0f);
+            for (int column = 0; column < 3; ++column) {
+                worldExtent += glm::abs(glm::vec3(transform[column])) * extent[column];
+            }
+            uint32_t object = static_cast<uint32_t>(items.size());
+            items.push_back({ object, center - worldExtent, center + worldExtent });
+            transforms.push_back(transform);
+            picker.setObjectMesh(object, mesh, transform);
+        }
+    }
+    scene.build(items.data(), items.size());
+
+    // Line of sight between random points at eye height; the unnormalized direction makes 1 the target
+    const size_t rayCount = 20000;
+    std::vector<ScenePicker::Ray> rays(rayCount);
+    for (ScenePicker::Ray& ray : rays) {
+        glm::vec3 from((unit(random) * 2.0f - 1.0f) * halfWorld, radius * (0.5f + unit(random)), (unit(random) * 2.0f - 1.0f) * halfWorld);
+        glm::vec3 to((unit(random) * 2.0f - 1.0f) * halfWorld, radius * 2.0f * unit(random), (unit(random) * 2.0f - 1.0f) * halfWorld);
+        ray = { from, to - from, 1.0f };
+    }
+
+    std::vector<ScenePicker::Hit> serialHits(rayCount), parallelHits(rayCount), budgetHits(rayCount);
+    picker.pick(rays.data(), rayCount, serialHits.data());
+    ScenePicker::Stats serial = picker.lastStats();
+    picker.pick(rays.data(), rayCount, parallelHits.data(), 0.0, &pool);
+    ScenePicker::Stats parallel = picker.lastStats();
+    std::cout << items.size() - 1 << " copies of " << mesh.indices.size() / 3 << " triangles, " << rayCount << " rays: "
+        << rayCount / serial.milliseconds / 1000.0 << " M rays/s serial, " << rayCount / parallel.milliseconds / 1000.0 << " M rays/s on "
+        << pool.threadCount() + 1 << " threads, " << 100.0 * serial.hits / rayCount << "% blocked, "
+        << static_cast<double>(serial.meshTests) / rayCount << " mesh tests per ray" << std::endl;
+
+    // As a game would run it: a fixed slice of each frame until the batch is done
+    const double budgetMilliseconds = 1.0;
+    size_t frames = 0;
+    size_t done = 0;
+    double slowestFrame = 0.0;
+    while (done < rayCount) {
+        done += picker.pick(rays.data() + done, rayCount - done, budgetHits.data() + done, budgetMilliseconds, &pool);
+        slowestFrame = std::max(slowestFrame, picker.lastStats().milliseconds);
+        ++frames;
+    }
+    std::cout << "  " << budgetMilliseconds << " ms budget: " << frames << " frames, " << rayCount / frames << " rays per frame, slowest frame "
+        << slowestFrame << " ms" << std::endl;
+
+    auto sameHit = [](const ScenePicker::Hit& a, const ScenePicker::Hit& b) {
+        return a.object == b.object && a.triangle == b.triangle && a.distance == b.distance;
+    };
+    bool batchesMatch = true;
+    for (size_t i = 0; i < rayCount; ++i) {
+        batchesMatch = batchesMatch && sameHit(serialHits[i], parallelHits[i]) && sameHit(serialHits[i], budgetHits[i]);
+    }
+
+    // Every copy's mesh and the ground, with no scene hierarchy
+    const size_t checkedCount = 500;
+    bool raysMatch = true;
+    for (size_t i = 0; i < checkedCount; ++i) {
+        const ScenePicker::Ray& ray = rays[i];
+        float best = ray.maxDistance;
+        uint32_t bestObject = ScenePicker::NO_OBJECT;
+        float groundDistance = (0.0f - ray.origin.y) / ray.direction.y;
+        if (ray.direction.y < 0.0f && groundDistance <= best) {
+            best = groundDistance;
+            bestObject = groundObject;
+        }
+        for (size_t copy = 0; copy < transforms.size(); ++copy) {
+            glm::mat4 worldToObject = glm::inverse(transforms[copy]);
+            TriangleBvh::RayHit hit;
+            if (TriangleBvh::raycast(mesh, glm::vec3(worldToObject * glm::vec4(ray.origin, 1.0f)),
+                glm::vec3(worldToObject * glm::vec4(ray.direction, 0.0f)), best, hit)) {
+                best = hit.distance;
+                bestObject = static_cast<uint32_t>(copy + 1);
+            }
+        }
+        raysMatch = raysMatch && bestObject == serialHits[i].object && (bestObject == ScenePicker::NO_OBJECT ||
+            std::fabs(best - serialHits[i].distance) <= 1e-5f);
+    }
+    std::cout << "  batches " << (batchesMatch ? "match" : "DIFFER") << ", first " << checkedCount << " rays "
+        << (raysMatch ? "match" : "DIFFER FROM") << " testing every copy" << std::endl;
+    return batchesMatch && raysMatch ? 0 : 1;
+}
+
+// Two triangles over the corners in order
+static void addQuad(MeshData& mesh, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d) {
+    uint32_t first = static_cast<uint32_t>(mesh.vertices.size());
+    for (const glm::vec3& corner : { a, b, c, d }) {
+        mesh.vertices.push_back({ corner, glm::vec3(0.0f), glm::vec2(0.0f) });
+    }
+    for (uint32_t index : { 0u, 1u, 2u, 0u, 2u, 3u }) {
+        mesh.indices.push_back(first + index);
+    }
+}
+
+static void addBox(MeshData& mesh, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    glm::vec3 corners[8];
+    for (int i = 0; i < 8; ++i) {
+        corners[i] = glm::vec3((i & 1) ? boxMax.x : boxMin.x, (i & 2) ? boxMax.y : boxMin.y, (i & 4) ? boxMax.z : boxMin.z);
+    }
+    static const int faces[6][4] = { { 0, 2, 3, 1 }, { 4, 5, 7, 6 }, { 0, 1, 5, 4 }, { 2, 6, 7, 3 }, { 0, 4, 6, 2 }, { 1, 3, 7, 5 } };
+    for (const auto& face : faces) {
+        addQuad(mesh, corners[face[0]], corners[face[1]], corners[face[2]], corners[face[3]]);
+    }
+}
+
+// Walks a capsule through a small level at a fixed 60 Hz: into a wall head on and at an angle, up and down
+// a flight of stairs, into a ledge too tall to climb, and down from a height. Every scenario runs twice
+// and must end in the same place bit for bit.
+static int benchmarkCharacter() {
+    // Floor, a thin wall at x = 5, five 0.2 m stairs up to a platform at z = 10..14, and a 0.6 m ledge
+    MeshData floor, wall, stairs, ledge;
+    addQuad(floor, glm::vec3(-20.0f, 0.0f, -20.0f), glm::vec3(-20.0f, 0.0f, 20.0f), glm::vec3(20.0f, 0.0f, 20.0f), glm::vec3(20.0f, 0.0f, -20.0f));
+    addQuad(wall, glm::vec3(5.0f, 0.0f, -8.0f), glm::vec3(5.0f, 3.0f, -8.0f), glm::vec3(5.0f, 3.0f, 8.0f), glm::vec3(5.0f, 0.0f, 8.0f));
+    for (int step = 0; step < 5; ++step) {
+        addBox(stairs, glm::vec3(-2.0f, 0.0f, 10.0f + 0.4f * step), glm::vec3(2.0f, 0.2f * (step + 1), 14.0f));
+    }
+    addBox(ledge, glm::vec3(-12.0f, 0.0f, -2.0f), glm::vec3(-8.0f, 0.6f, 2.0f));
+    MeshData* meshes[] = { &floor, &wall, &stairs, &ledge };
+    SceneBvh scene(0.0f);
+    std::vector<SceneBvh::Item> items;
+    for (uint32_t object = 0; object < 4; ++object) {
+        meshes[object]->computeBounds();
+        TriangleBvh::build(*meshes[object], nullptr);
+        items.push_back({ object, meshes[object]->boundsMin, meshes[object]->boundsMax });
+    }
+    scene.build(items.data(), items.size());
+
+    const float deltaTime = 1.0f / 60.0f;
+    const float speed = 4.0f;
+    size_t moves = 0;
+    double totalMilliseconds = 0.0;
+    double slowestMove = 0.0;
+    size_t airborneFrames = 0;
+    auto walk = [&](glm::vec3 feet, const glm::vec3& direction, float seconds) {
+        CharacterController controller(scene);
+        for (uint32_t object = 0; object < 4; ++object) {
+            controller.setObjectMesh(object, *meshes[object], glm::mat4(1.0f));
+        }
+        airborneFrames = 0;
+        for (int frame = 0; frame < static_cast<int>(seconds * 60.0f + 0.5f); ++frame) {
+            feet = controller.move(feet, direction * (speed * deltaTime), deltaTime);
+            airborneFrames += controller.isGrounded() ? 0 : 1;
+            totalMilliseconds += controller.lastStats().milliseconds;
+            slowestMove = std::max(slowestMove, controller.lastStats().milliseconds);
+            ++moves;
+        }
+        return feet;
+    };
+
+    bool allPassed = true;
+    auto check = [&](const char* scenario, bool passed, const glm::vec3& feet) {
+        std::cout << "  " << scenario << ": ended at " << feet.x << ", " << feet.y << ", " << feet.z << " - " << (passed ? "ok" : "FAILED") << std::endl;
+        allPassed = allPassed && passed;
+    };
+    const float radius = CharacterController::Settings().radius;
+    const float tolerance = 0.02f;
+    for (int run = 0; run < 2; ++run) {
+        static glm::vec3 firstRun[6];
+        glm::vec3 ends[6];
+        ends[0] = walk(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 3.0f);
+        ends[1] = walk(glm::vec3(0.0f, 0.0f, -6.0f), glm::normalize(glm::vec3(1.0f, 0.0f, 1.0f)), 3.0f);
+        ends[2] = walk(glm::vec3(0.0f, 0.0f, 8.0f), glm::vec3(0.0f, 0.0f, 1.0f), 1.2f);
+        ends[3] = walk(ends[2], glm::vec3(0.0f, 0.0f, -1.0f), 3.0f);
+        size_t stairsDownAirborne = airborneFrames;
+        ends[4] = walk(glm::vec3(-5.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), 2.0f);
+        ends[5] = walk(glm::vec3(0.0f, 3.0f, -10.0f), glm::vec3(0.0f), 1.5f);
+        if (run == 0) {
+            std::copy(ends, ends + 6, firstRun);
+            check("wall head on", std::fabs(ends[0].x - (5.0f - radius)) < tolerance && std::fabs(ends[0].y) < tolerance, ends[0]);
+            check("wall at 45 degrees", ends[1].x < 5.0f - radius + tolerance && ends[1].z > 2.0f, ends[1]);
+            check("stairs up", std::fabs(ends[2].y - 1.0f) < tolerance && ends[2].z > 12.0f, ends[2]);
+            check("stairs down", std::fabs(ends[3].y) < tolerance && ends[3].z < 8.0f && stairsDownAirborne == 0, ends[3]);
+            check("0.6 m ledge", std::fabs(ends[4].x - (-8.0f + radius)) < tolerance && std::fabs(ends[4].y) < tolerance, ends[4]);
+            check("fall", std::fabs(ends[5].y) < tolerance, ends[5]);
+        }
+        else {
+            bool same = std::equal(ends, ends + 6, firstRun);
+            std::cout << "  second run " << (same ? "identical" : "DIFFERS") << std::endl;
+            allPassed = allPassed && same;
+        }
+    }
+    std::cout << moves << " moves: " << totalMilliseconds / moves * 1000.0 << " us average, " << slowestMove * 1000.0 << " us slowest" << std::endl;
+    return allPassed ? 0 : 1;
+}
+
+// Crates and debris flying around a walled yard, longer along z, for five seconds of 60 Hz ticks. Each
+// tick every body moves and one in a hundred is removed and spawned again elsewhere. Pairs are checked
+// against every box against every other at the start, middle and end.
+static int benchmarkSweepAndPrune(size_t bodyCount) {
+    const int ticks = 300;
+    const float deltaTime = 1.0f / 60.0f;
+    std::mt19937 random(1234);
+    float halfWorld = std::sqrt(static_cast<float>(bodyCount));
+    glm::vec3 worldMin(-halfWorld * 0.5f, 0.0f, -halfWorld * 2.0f);
+    glm::vec3 worldMax(halfWorld * 0.5f, 4.0f, halfWorld * 2.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_real_distribution<float> size(0.1f, 0.6f);
+    std::uniform_real_distribution<float> speed(-3.0f, 3.0f);
+
+    struct Body {
+        uint32_t id;
+        glm::vec3 center, extent, velocity;
+    };
+    std::vector<Body> bodies(bodyCount);
+    auto spawn = [&](Body& body) {
+        body.extent = glm::vec3(size(random), size(random), size(random));
+        body.center = worldMin + body.extent + (worldMax - worldMin - body.extent * 2.0f) * glm::vec3(unit(random), unit(random), unit(random));
+        body.velocity = glm::vec3(speed(random), speed(random), speed(random));
+    };
+    SweepAndPrune broadphase;
+    for (Body& body : bodies) {
+        spawn(body);
+        body.id = broadphase.add(body.center - body.extent, body.center + body.extent);
+    }
+
+    auto bruteForce = [&](std::vector<SweepAndPrune::Pair>& pairs) {
+        pairs.clear();
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            glm::vec3 minI = bodies[i].center - bodies[i].extent, maxI = bodies[i].center + bodies[i].extent;
+            for (size_t j = i + 1; j < bodies.size(); ++j) {
+                glm::vec3 minJ = bodies[j].center - bodies[j].extent, maxJ = bodies[j].center + bodies[j].extent;
+                if (glm::all(glm::lessThanEqual(minI, maxJ)) && glm::all(glm::lessThanEqual(minJ, maxI))) {
+                    uint32_t a = bodies[i].id, b = bodies[j].id;
+                    pairs.push_back({ std::min(a, b), std::max(a, b) });
+                }
+            }
+        }
+    };
+    auto pairOrder = [](const SweepAndPrune::Pair& left, const SweepAndPrune::Pair& right) {
+        return left.a != right.a ? left.a < right.a : left.b < right.b;
+    };
+    auto samePairs = [](const SweepAndPrune::Pair& left, const SweepAndPrune::Pair& right) {
+        return left.a == right.a && left.b == right.b;
+    };
+
+    std::vector<SweepAndPrune::Pair> pairs, expected;
+    bool allMatch = true;
+    double sortMilliseconds = 0.0, sweepMilliseconds = 0.0, slowestTick = 0.0;
+    size_t totalPairs = 0, totalSwaps = 0, totalComparisons = 0, fullSorts = 0;
+    std::uniform_int_distribution<size_t> pick(0, bodyCount - 1);
+    for (int tick = 0; tick < ticks; ++tick) {
+        if (tick != 0) {
+            for (Body& body : bodies) {
+                body.center += body.velocity * deltaTime;
+                for (int k = 0; k < 3; ++k) {
+                    if (body.center[k] - body.extent[k] < worldMin[k] || body.center[k] + body.extent[k] > worldMax[k]) {
+                        body.velocity[k] = -body.velocity[k];
+                        body.center[k] = glm::clamp(body.center[k], worldMin[k] + body.extent[k], worldMax[k] - body.extent[k]);
+                    }
+                }
+                broadphase.update(body.id, body.center - body.extent, body.center + body.extent);
+            }
+            for (size_t i = 0; i < bodyCount / 100; ++i) {
+                Body& body = bodies[pick(random)];
+                broadphase.remove(body.id);
+                spawn(body);
+                body.id = broadphase.add(body.center - body.extent, body.center + body.extent);
+            }
+        }
+
+        broadphase.findPairs(pairs);
+        const SweepAndPrune::Stats& stats = broadphase.lastStats();
+        double milliseconds = stats.sortMilliseconds + stats.sweepMilliseconds;
+        if (tick != 0) {
+            // The first tick sorts from scratch; the steady state is what counts against the tick rate
+            sortMilliseconds += stats.sortMilliseconds;
+            sweepMilliseconds += stats.sweepMilliseconds;
+            slowestTick = std::max(slowestTick, milliseconds);
+            totalSwaps += stats.swaps;
+            fullSorts += stats.fullSort ? 1 : 0;
+        }
+        else {
+            std::cout << bodyCount << " bodies, first tick sorted from scratch along axis " << stats.axis << " in "
+                << stats.sortMilliseconds << " ms, sweep " << stats.sweepMilliseconds << " ms" << std::endl;
+        }
+        totalPairs += stats.pairs;
+        totalComparisons += stats.comparisons;
+
+        if (tick == 0 || tick == ticks / 2 || tick == ticks - 1) {
+            bruteForce(expected);
+            std::sort(pairs.begin(), pairs.end(), pairOrder);
+            std::sort(expected.begin(), expected.end(), pairOrder);
+            bool matches = pairs.size() == expected.size() && std::equal(pairs.begin(), pairs.end(), expected.begin(), samePairs);
+            allMatch = allMatch && matches;
+            std::cout << "  tick " << tick << ": " << pairs.size() << " pairs, " << (matches ? "match" : "DIFFER FROM") << " brute force" << std::endl;
+        }
+    }
+
+    const double steadyTicks = ticks - 1;
+    double tickMilliseconds = (sortMilliseconds + sweepMilliseconds) / steadyTicks;
+    std::cout << steadyTicks << " ticks: " << tickMilliseconds << " ms average (sort " << sortMilliseconds / steadyTicks << ", sweep "
+        << sweepMilliseconds / steadyTicks << ", " << tickMilliseconds / (deltaTime * 1000.0) * 100.0 << "% of a 60 Hz tick), " << slowestTick << " ms slowest, " << static_cast<double>(totalPairs) / ticks << " pairs, "
+        << static_cast<double>(totalComparisons) / ticks << " sort-axis overlaps, " << static_cast<double>(totalSwaps) / steadyTicks
+        << " insertion sort moves per tick, " << fullSorts << " full sorts" << std::endl;
+
+    // The same boxes again sorted from scratch, for what the insertion sort saves
+    SweepAndPrune fresh;
+    for (const Body& body : bodies) {
+        fresh.add(body.center - body.extent, body.center + body.extent);
+    }
+    fresh.findPairs(expected);
+    std::cout << "sorting from scratch takes " << fresh.lastStats().sortMilliseconds << " ms, an incremental one " << sortMilliseconds / steadyTicks << " ms" << std::endl;
+    return allMatch ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 3 && std::string(argv[1]) == "--benchmark-dedup") {
+        return LoadBenchmark::dedup(argv[2]) ? 0 : 1;
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--benchmark-threads") {
+        return LoadBenchmark::threadScaling(argv[2]) ? 0 : 1;
+    }
+    if (argc >= 2 && std::string(argv[1]) == "--benchmark-sap") {
+        size_t bodyCount = argc >= 3 ? static_cast<size_t>(std::strtoul(argv[2], nullptr, 10)) : 20000;
+        return benchmarkSweepAndPrune(bodyCount);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "--benchmark-character") {
+        return benchmarkCharacter();
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--benchmark-picking") {
+        return benchmarkPicking(argv[2]);
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--benchmark-raycast") {
+        return benchmarkRaycast(argv[2]);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "--benchmark-bvh") {
+        return benchmarkBvh();
+    }
+    if (argc >= 2 && std::string(argv[1]) == "--benchmark-culling") {
+        size_t objectCount = argc >= 3 ? static_cast<size_t>(std::strtoul(argv[2], nullptr, 10)) : 100000;
+        return benchmarkCulling(objectCount);
+    }
+    if (argc >= 4 && std::string(argv[1]) == "--benchmark-glb") {
+        return benchmarkGlb(argv[2], argv[3]);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "--test-obj-lines") {
+        size_t threadCount = argc >= 4 && std::string(argv[2]) == "--threads" ? static_cast<size_t>(std::strtoul(argv[3], nullptr, 10)) : 0;
+        ThreadPool pool(threadCount);
+        return testObjLines(pool);
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--benchmark-obj") {
+        std::string mtlBasePath;
+        size_t threadCount = 0;
+        for (int i = 3; i < argc; ++i) {
+            std::string argument = argv[i];
+            if (argument == "--threads" && i + 1 < argc) {
+                threadCount = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+            }
+            else {
+                mtlBasePath = argument;
+            }
+        }
+        ThreadPool pool(threadCount);
+        return benchmarkObj(argv[2], mtlBasePath, pool);
+    }
+
+    if (argc < 3) {
+        printUsage();
+        return 1;
+    }
+
+    std::filesystem::path inputDirectory = argv[1];
+    std::filesystem::path outputDirectory = argv[2];
+    size_t threadCount = 0;
+    AssetCooker::Options options;
+
+    for (int i = 3; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--threads" && i + 1 < argc) {
+            threadCount = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (argument == "--force") {
+            options.force = true;
+        }
+        else if (argument == "--no-optimize") {
+            options.optimizeMeshes = false;
+        }
+        else if (argument == "--no-lods") {
+            options.lodRatios.clear();
+        }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (!std::filesystem::is_directory(inputDirectory)) {
+        std::cerr << "Input directory does not exist: " << inputDirectory.string() << std::endl;
+        return 1;
+    }
+
+    ThreadPool pool(threadCount);
+    AssetCooker cooker(inputDirectory, outputDirectory, options);
+    return cooker.run(pool) ? 0 : 1;
+}
@@ -0,0 +1,212 @@
+#include "character_controller.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Pushes per resolve; each removes the deepest overlap, so corners settle in two or three
+static const int MAX_RESOLVE_ITERATIONS = 4;
+// Overlaps shallower than this are contact only and need no push
+static const float RESOLVE_TOLERANCE = 1e-5f;
+
+CharacterController::CharacterController(const SceneBvh& scene) : CharacterController(scene, Settings()) {
+}
+
+CharacterController::CharacterController(const SceneBvh& scene, const Settings& settings)
+    : scene(scene), settings(settings), grounded(false), verticalSpeed(0.0f) {
+}
+
+void CharacterController::setObjectMesh(uint32_t object, const MeshData& mesh, const glm::mat4& modelMatrix) {
+    if (object >= objectMeshes.size()) {
+        objectMeshes.resize(object + 1);
+    }
+    ObjectMesh& target = objectMeshes[object];
+    target.mesh = &mesh;
+    target.modelMatrix = modelMatrix;
+    target.worldToObject = glm::inverse(modelMatrix);
+    target.scale = glm::length(glm::vec3(modelMatrix[0]));
+}
+
+void CharacterController::clearObjectMesh(uint32_t object) {
+    if (object < objectMeshes.size()) {
+        objectMeshes[object] = ObjectMesh();
+    }
+}
+
+glm::vec3 CharacterController::resolve(const glm::vec3& feet, Resolution& resolution) {
+    resolution = Resolution();
+    glm::vec3 position = feet;
+    // Surfaces within the skin count as touched, so resting contact is still seen as ground
+    float reach = settings.radius + settings.skinWidth;
+    for (int iteration = 0; iteration < MAX_RESOLVE_ITERATIONS; ++iteration) {
+        glm::vec3 bottom = position + glm::vec3(0.0f, settings.radius, 0.0f);
+        glm::vec3 top = position + glm::vec3(0.0f, settings.height - settings.radius, 0.0f);
+        float deepest = RESOLVE_TOLERANCE;
+        glm::vec3 push(0.0f);
+        for (uint32_t object : candidates) {
+            if (object >= objectMeshes.size() || objectMeshes[object].mesh == nullptr) {
+                continue;
+            }
+            const ObjectMesh& target = objectMeshes[object];
+            ++moveStats.overlapQueries;
+            TriangleBvh::overlapCapsule(*target.mesh, glm::vec3(target.worldToObject * glm::vec4(bottom, 1.0f)),
+                glm::vec3(target.worldToObject * glm::vec4(top, 1.0f)), reach / target.scale, contacts);
+            moveStats.contacts += contacts.size();
+
+            for (const TriangleBvh::Contact& contact : contacts) {
+                glm::vec3 normal = glm::normalize(glm::vec3(target.modelMatrix * glm::vec4(contact.normal, 0.0f)));
+                float depth = contact.depth * target.scale;
+                glm::vec3 contactPush;
+                if (normal.y >= settings.maxSlopeCosine) {
+                    // Straight up, so standing on a slope does not creep down it
+                    resolution.ground = true;
+                    contactPush = glm::vec3(0.0f, depth / normal.y, 0.0f);
+                }
+                else if (normal.y <= -settings.maxSlopeCosine) {
+                    resolution.ceiling = true;
+                    contactPush = normal * depth;
+                }
+                else {
+                    // Sideways only, so walking into a steep slope does not climb it
+                    glm::vec3 horizontal(normal.x, 0.0f, normal.z);
+                    float horizontalLength = glm::length(horizontal);
+                    resolution.wall = true;
+                    resolution.wallNormal = horizontal / horizontalLength;
+                    contactPush = resolution.wallNormal * (depth / horizontalLength);
+                }
+                if (depth > deepest) {
+                    deepest = depth;
+                    push = contactPush;
+                }
+            }
+        }
+        if (push == glm::vec3(0.0f)) {
+            break;
+        }
+        position += push;
+    }
+    return position;
+}
+
+bool CharacterController::dropToGround(const glm::vec3& feet, float distance, glm::vec3& landed) {
+    // In substeps like any other move, so thin floors are not passed through
+    size_t count = std::max<size_t>(1, static_cast<size_t>(std::ceil(distance / (settings.radius * 0.5f))));
+    glm::vec3 position = feet;
+    Resolution resolution;
+    for (size_t i = 0; i < count; ++i) {
+        position = resolve(position - glm::vec3(0.0f, distance / count, 0.0f), resolution);
+        if (resolution.ground) {
+            landed = position;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CharacterController::tryStep(const glm::vec3& feet, const glm::vec3& step, const glm::vec3& blocked, glm::vec3& stepped) {
+    Resolution resolution;
+    glm::vec3 up = feet + glm::vec3(0.0f, settings.stepHeight, 0.0f);
+    glm::vec3 raised = resolve(up, resolution);
+    if (resolution.ceiling || raised.y < up.y - settings.skinWidth) {
+        return false;  // No headroom
+    }
+
+    // Short steps would leave the capsule hanging on the ledge's edge, which reads as a wall, so the
+    // probe goes at least half a radius forward
+    float stepLength = glm::length(step);
+    glm::vec3 probe = step * (std::max(stepLength, settings.radius * 0.5f) / stepLength);
+    glm::vec3 forward = resolve(raised + probe, resolution);
+    glm::vec3 landed;
+    if (!dropToGround(forward, settings.stepHeight + settings.skinWidth, landed)) {
+        return false;  // Nothing to stand on up there
+    }
+
+    auto progress = [&](const glm::vec3& position) {
+        glm::vec2 offset(position.x - feet.x, position.z - feet.z);
+        return glm::dot(offset, offset);
+    };
+    if (progress(landed) <= progress(blocked) + RESOLVE_TOLERANCE * RESOLVE_TOLERANCE) {
+        return false;  // Blocked up there too
+    }
+    stepped = landed;
+    return true;
+}
+
+glm::vec3 CharacterController::move(const glm::vec3& feet, const glm::vec3& displacement, float deltaTime) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    moveStats = Stats();
+
+    glm::vec3 total = displacement;
+    if (!grounded) {
+        verticalSpeed -= settings.gravity * deltaTime;
+        total.y += verticalSpeed * deltaTime;
+    }
+    float substepLength = settings.radius * 0.5f;
+    float length = glm::length(total);
+    float maxLength = settings.maxSubsteps * substepLength;
+    if (length > maxLength) {
+        total *= maxLength / length;
+        length = maxLength;
+    }
+    size_t substeps = std::max<size_t>(1, static_cast<size_t>(std::ceil(length / substepLength)));
+
+    // One broadphase query covers the whole move, the step climb and the drop after it
+    glm::vec3 middle = feet + total * 0.5f + glm::vec3(0.0f, settings.height * 0.5f, 0.0f);
+    scene.queryRadius(middle, length * 0.5f + settings.height * 0.5f + settings.radius + settings.stepHeight + settings.skinWidth, candidates);
+
+    bool wasGrounded = grounded;
+    Resolution resolution;
+    glm::vec3 position = resolve(feet, resolution);  // In case something moved into the capsule
+    grounded = resolution.ground;
+    glm::vec3 step = total / static_cast<float>(substeps);
+    for (size_t substep = 0; substep < substeps; ++substep) {
+        if (settings.budgetMilliseconds > 0.0 && std::chrono::duration<double, std::milli>(
+            std::chrono::high_resolution_clock::now() - startTime).count() > settings.budgetMilliseconds) {
+            moveStats.budgetExceeded = true;
+            break;
+        }
+        ++moveStats.substeps;
+        glm::vec3 moved = resolve(position + step, resolution);
+        glm::vec3 horizontalStep(step.x, 0.0f, step.z);
+        if (resolution.wall && grounded && horizontalStep != glm::vec3(0.0f)) {
+            glm::vec3 stepped;
+            if (tryStep(position, horizontalStep, moved, stepped)) {
+                moved = stepped;
+                resolution = Resolution();
+                resolution.ground = true;
+                moveStats.stepped = true;
+            }
+        }
+
+        // The rest of the move slides along what was hit
+        if (resolution.wall) {
+            float into = glm::dot(step, resolution.wallNormal);
+            if (into < 0.0f) {
+                step -= resolution.wallNormal * into;
+            }
+        }
+        if ((resolution.ceiling && step.y > 0.0f) || (resolution.ground && step.y < 0.0f)) {
+            step.y = 0.0f;
+        }
+        if (resolution.ceiling) {
+            verticalSpeed = std::min(verticalSpeed, 0.0f);
+        }
+        grounded = resolution.ground;
+        position = moved;
+    }
+
+    // Follow steps and slopes down rather than walking off them into the air
+    if (wasGrounded && !grounded && total.y <= 0.0f) {
+        glm::vec3 landed;
+        if (dropToGround(position, settings.stepHeight, landed)) {
+            position = landed;
+            grounded = true;
+        }
+    }
+    if (grounded) {
+        verticalSpeed = 0.0f;
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    moveStats.milliseconds = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+    return position;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#ifndef CHARACTER_CONTROLLER_H
+#define CHARACTER_CONTROLLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "mesh_data.h"
+#include "scene_bvh.h"
+#include "triangle_bvh.h"
+
+// Moves an upright capsule through static geometry. The SceneBvh picks the objects near the move and
+// their meshes are tested through TriangleBvh capsule overlaps. A move is swept in substeps no longer than
+// half the radius, so the capsule cannot pass through a surface between two tests; after each substep it
+// is pushed out of what it overlaps and the rest of the move slides along the walls it met. Ledges up to
+// the step height are climbed, and the capsule follows steps and slopes down while it is on the ground.
+//
+// Only objects given a mesh collide; their boxes alone are never solid.
+class CharacterController {
+public:
+    struct Settings {
+        float radius = 0.3f;
+        float height = 1.8f;          // Feet to the top of the capsule
+        float stepHeight = 0.35f;     // Tallest ledge climbed, and drop followed without leaving the ground
+        float maxSlopeCosine = 0.7f;  // Normals at least this far up are ground (slopes under about 45 degrees)
+        float skinWidth = 0.005f;     // Gap kept between the capsule and surfaces
+        float gravity = 9.81f;
+        size_t maxSubsteps = 32;      // Longer moves are shortened to this many half-radius substeps
+        double budgetMilliseconds = 1.0;  // Substeps left when this runs out are dropped for the frame
+    };
+
+    // Counters from the last move
+    struct Stats {
+        size_t substeps = 0;
+        size_t overlapQueries = 0;   // Mesh capsule tests
+        size_t contacts = 0;
+        bool stepped = false;        // Climbed a ledge
+        bool budgetExceeded = false;
+        double milliseconds = 0.0;
+    };
+
+    explicit CharacterController(const SceneBvh& scene);
+    CharacterController(const SceneBvh& scene, const Settings& settings);
+
+    // Object collides with the mesh's triangle hierarchy placed by modelMatrix, which should scale uniformly.
+    // The mesh is not copied and must stay alive and unchanged until the object is cleared or set again.
+    void setObjectMesh(uint32_t object, const MeshData& mesh, const glm::mat4& modelMatrix);
+    void clearObjectMesh(uint32_t object);
+
+    // Moves the capsule standing at feet by displacement, plus gravity over deltaTime while airborne, as far
+    // as the geometry allows. Returns where the feet end up.
+    glm::vec3 move(const glm::vec3& feet, const glm::vec3& displacement, float deltaTime);
+
+    bool isGrounded() const { return grounded; }
+    const Settings& getSettings() const { return settings; }
+    const Stats& lastStats() const { return moveStats; }
+
+private:
+    struct ObjectMesh {
+        const MeshData* mesh = nullptr;
+        glm::mat4 modelMatrix{ 1.0f };
+        glm::mat4 worldToObject{ 1.0f };
+        float scale = 1.0f;
+    };
+
+    // What pushing the capsule out touched
+    struct Resolution {
+        bool ground = false;
+        bool ceiling = false;
+        bool wall = false;
+        glm::vec3 wallNormal{ 0.0f };  // Horizontal, unit length; the last wall met
+    };
+
+    const SceneBvh& scene;
+    Settings settings;
+    std::vector<ObjectMesh> objectMeshes;  // By object id
+    std::vector<uint32_t> candidates;      // Objects near the current move
+    std::vector<TriangleBvh::Contact> contacts;
+    bool grounded;
+    float verticalSpeed;                   // From gravity, while airborne
+    Stats moveStats;
+
+    // Pushes the capsule at feet out of the candidates' geometry and returns where it ends up
+    glm::vec3 resolve(const glm::vec3& feet, Resolution& resolution);
+    // Lowers feet by up to distance until it stands on ground
+    bool dropToGround(const glm::vec3& feet, float distance, glm::vec3& landed);
+    // Climbs over whatever blocked a horizontal step from feet; blocked is where the plain step ended
+    bool tryStep(const glm::vec3& feet, const glm::vec3& step, const glm::vec3& blocked, glm::vec3& stepped);
+};
+
+#endif // CHARACTER_CONTROLLER_H
@@ -3,7 +3,7 @@
 #include "globals.h"
 
 // Implementacin de la funcin para dibujar el crosshair
-void drawCrosshair(int screenWidth, int screenHeight) {
+void drawCrosshair(int screenWidth, int screenHeight, bool onTarget) {
     // Tamao del crosshair en pxeles
     float crosshairSize = 10.0f;
 
@@ -25,7 +25,12 @@ void drawCrosshair(int screenWidth, int screenHeight) {
     glDisable(GL_DEPTH_TEST);
 
     // Configura el color del crosshair (rojo para visibilidad)
-    glColor3f(0.0f, 255.0f, 255.0f);
+    if (onTarget) {
+        glColor3f(1.0f, 0.0f, 0.0f);
+    }
+    else {
+        glColor3f(0.0f, 255.0f, 255.0f);
+    }
     glLineWidth(3.0f);           // Grosor de las lneas (ajstalo a tu preferencia)
 
     // Dibuja el crosshair en el centro de la pantalla
@@ -3,6 +3,7 @@
 #define CROSSHAIR_H
 
 // Declaracin de la funcin para dibujar el crosshair
-void drawCrosshair(int WIDTH, int HEIGHT);
+// onTarget la pinta en rojo cuando apunta a algo
+void drawCrosshair(int WIDTH, int HEIGHT, bool onTarget = false);
 
 #endif // CROSSHAIR_H
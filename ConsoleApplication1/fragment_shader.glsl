@@ -2,7 +2,14 @@
 out vec4 FragColor;
 
 in vec2 TexCoord;
+in vec4 InstanceColor;
+
+// Material state, set once per material by Model; the defaults draw untextured white
+uniform vec4 u_DiffuseColor = vec4(1.0);  // Alpha is the MTL dissolve
+uniform bool u_UseTexture = false;
+uniform sampler2D u_DiffuseTexture;
 
 void main() {
-    FragColor = vec4(TexCoord, 0.0, 1.0); // Example color output
+    vec4 base = u_UseTexture ? texture(u_DiffuseTexture, TexCoord) : vec4(1.0);
+    FragColor = base * u_DiffuseColor * InstanceColor;
 }
@@ -0,0 +1,105 @@
+#include "free_list_allocator.h"
+#include <iterator>
+
+FreeListAllocator::FreeListAllocator(size_t capacity) : totalSize(0), usedSize(0) {
+    reset(capacity);
+}
+
+void FreeListAllocator::reset(size_t capacity) {
+    freeByOffset.clear();
+    freeBySize.clear();
+    allocations.clear();
+    totalSize = capacity;
+    usedSize = 0;
+    if (capacity != 0) {
+        addFreeBlock(0, capacity);
+    }
+}
+
+void FreeListAllocator::addFreeBlock(size_t offset, size_t size) {
+    // Merge with the blocks on either side
+    auto next = freeByOffset.lower_bound(offset);
+    if (next != freeByOffset.end() && offset + size == next->first) {
+        size += next->second;
+        auto merged = next++;
+        removeFreeBlock(merged);
+    }
+    if (next != freeByOffset.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            offset = previous->first;
+            size += previous->second;
+            removeFreeBlock(previous);
+        }
+    }
+    freeByOffset.emplace(offset, size);
+    freeBySize.emplace(size, offset);
+}
+
+void FreeListAllocator::removeFreeBlock(std::map<size_t, size_t>::iterator block) {
+    auto range = freeBySize.equal_range(block->second);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == block->first) {
+            freeBySize.erase(it);
+            break;
+        }
+    }
+    freeByOffset.erase(block);
+}
+
+size_t FreeListAllocator::allocate(size_t size, size_t alignment) {
+    if (size == 0 || alignment == 0) {
+        return INVALID_OFFSET;
+    }
+
+    // Smallest block that still fits once its start is aligned
+    for (auto it = freeBySize.lower_bound(size); it != freeBySize.end(); ++it) {
+        size_t blockOffset = it->second;
+        size_t blockSize = it->first;
+        size_t offset = (blockOffset + alignment - 1) / alignment * alignment;
+        size_t padding = offset - blockOffset;
+        if (padding + size > blockSize) {
+            continue;
+        }
+
+        removeFreeBlock(freeByOffset.find(blockOffset));
+        if (padding != 0) {
+            addFreeBlock(blockOffset, padding);
+        }
+        if (padding + size < blockSize) {
+            addFreeBlock(offset + size, blockSize - padding - size);
+        }
+        allocations.emplace(offset, size);
+        usedSize += size;
+        return offset;
+    }
+    return INVALID_OFFSET;
+}
+
+bool FreeListAllocator::free(size_t offset) {
+    auto allocation = allocations.find(offset);
+    if (allocation == allocations.end()) {
+        return false;
+    }
+    usedSize -= allocation->second;
+    addFreeBlock(allocation->first, allocation->second);
+    allocations.erase(allocation);
+    return true;
+}
+
+void FreeListAllocator::grow(size_t newCapacity) {
+    if (newCapacity > totalSize) {
+        addFreeBlock(totalSize, newCapacity - totalSize);
+        totalSize = newCapacity;
+    }
+}
+
+FreeListAllocator::Stats FreeListAllocator::stats() const {
+    Stats result;
+    result.capacity = totalSize;
+    result.used = usedSize;
+    result.allocations = allocations.size();
+    result.freeBlocks = freeByOffset.size();
+    result.largestFreeBlock = freeBySize.empty() ? 0 : freeBySize.rbegin()->first;
+    return result;
+}
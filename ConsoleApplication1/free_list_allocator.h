@@ -0,0 +1,55 @@
+#pragma once
+#ifndef FREE_LIST_ALLOCATOR_H
+#define FREE_LIST_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+// Hands out ranges of an abstract address space (vertices, bytes) without touching any memory itself.
+// Free blocks are kept both by offset, so frees coalesce with their neighbours, and by size, so
+// allocation is best fit in O(log n).
+class FreeListAllocator {
+public:
+    static const size_t INVALID_OFFSET = SIZE_MAX;
+
+    struct Stats {
+        size_t capacity = 0;
+        size_t used = 0;
+        size_t allocations = 0;
+        size_t freeBlocks = 0;
+        size_t largestFreeBlock = 0;
+
+        // Share of the free space that is not in the largest block: 0 when it is all in one piece
+        double fragmentation() const {
+            size_t free = capacity - used;
+            return free != 0 ? 1.0 - static_cast<double>(largestFreeBlock) / free : 0.0;
+        }
+    };
+
+    explicit FreeListAllocator(size_t capacity = 0);
+
+    // Offset of a free range of size units starting on a multiple of alignment, or INVALID_OFFSET
+    size_t allocate(size_t size, size_t alignment = 1);
+    // Returns a range from allocate; unknown offsets are ignored
+    bool free(size_t offset);
+    // Extends the address space; existing allocations keep their offsets
+    void grow(size_t newCapacity);
+    // Forgets every allocation
+    void reset(size_t capacity);
+
+    size_t capacity() const { return totalSize; }
+    Stats stats() const;
+
+private:
+    size_t totalSize;
+    size_t usedSize;
+    std::map<size_t, size_t> freeByOffset;       // Offset -> size
+    std::multimap<size_t, size_t> freeBySize;    // Size -> offset
+    std::map<size_t, size_t> allocations;        // Offset -> size
+
+    void addFreeBlock(size_t offset, size_t size);
+    void removeFreeBlock(std::map<size_t, size_t>::iterator block);
+};
+
+#endif // FREE_LIST_ALLOCATOR_H
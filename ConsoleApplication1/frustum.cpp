@@ -0,0 +1,60 @@
+#include "frustum.h"
+#include <cmath>
+
+static glm::vec4 normalizePlane(const glm::vec4& plane) {
+    float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+    return length > 0.0f ? glm::vec4(plane.x / length, plane.y / length, plane.z / length, plane.w / length) : plane;
+}
+
+Frustum Frustum::fromMatrix(const glm::mat4& m) {
+    // Gribb/Hartmann: combine the rows of the (column-major) matrix
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    Frustum frustum;
+    frustum.planes[LEFT] = normalizePlane(row3 + row0);
+    frustum.planes[RIGHT] = normalizePlane(row3 - row0);
+    frustum.planes[BOTTOM] = normalizePlane(row3 + row1);
+    frustum.planes[TOP] = normalizePlane(row3 - row1);
+    frustum.planes[NEAR_PLANE] = normalizePlane(row3 + row2);
+    frustum.planes[FAR_PLANE] = normalizePlane(row3 - row2);
+    return frustum;
+}
+
+Frustum Frustum::toLocalSpace(const glm::mat4& modelMatrix) const {
+    // A plane transforms by the transpose of the matrix that maps local points to world points
+    Frustum local;
+    for (int i = 0; i < PLANE_COUNT; ++i) {
+        const glm::vec4& p = planes[i];
+        local.planes[i] = normalizePlane(glm::vec4(
+            glm::dot(glm::vec4(modelMatrix[0]), p),
+            glm::dot(glm::vec4(modelMatrix[1]), p),
+            glm::dot(glm::vec4(modelMatrix[2]), p),
+            glm::dot(glm::vec4(modelMatrix[3]), p)));
+    }
+    return local;
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const {
+    for (int i = 0; i < PLANE_COUNT; ++i) {
+        const glm::vec4& p = planes[i];
+        if (p.x * center.x + p.y * center.y + p.z * center.z + p.w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::intersectsBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+    for (int i = 0; i < PLANE_COUNT; ++i) {
+        const glm::vec4& p = planes[i];
+        // Box corner furthest along the plane normal
+        glm::vec3 corner(p.x >= 0.0f ? boxMax.x : boxMin.x, p.y >= 0.0f ? boxMax.y : boxMin.y, p.z >= 0.0f ? boxMax.z : boxMin.z);
+        if (p.x * corner.x + p.y * corner.y + p.z * corner.z + p.w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// Six inward-facing planes (xyz = unit normal, w = distance) extracted from a view-projection matrix
+struct Frustum {
+    enum { LEFT, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE, PLANE_COUNT };
+
+    glm::vec4 planes[PLANE_COUNT];
+
+    static Frustum fromMatrix(const glm::mat4& viewProjection);
+
+    // Same frustum expressed in the local space of an object with the given model matrix
+    Frustum toLocalSpace(const glm::mat4& modelMatrix) const;
+
+    bool intersectsSphere(const glm::vec3& center, float radius) const;
+    bool intersectsBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+};
+
+#endif // FRUSTUM_H
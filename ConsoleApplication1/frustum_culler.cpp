@@ -0,0 +1,245 @@
+#include "frustum_culler.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FRUSTUM_CULLER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AVX_TARGET
+#else
+// GCC and Clang only emit AVX inside functions marked for it; the caller checks the CPU first
+#define AVX_TARGET __attribute__((target("avx")))
+#endif
+#endif
+
+uint32_t FrustumCuller::add(const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    return add(boxMin, boxMax, (boxMin + boxMax) * 0.5f, glm::length(boxMax - boxMin) * 0.5f);
+}
+
+uint32_t FrustumCuller::add(const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::vec3& sphereCenter, float sphereRadius) {
+    uint32_t object = static_cast<uint32_t>(size());
+    centerX.push_back(0.0f);
+    centerY.push_back(0.0f);
+    centerZ.push_back(0.0f);
+    extentX.push_back(0.0f);
+    extentY.push_back(0.0f);
+    extentZ.push_back(0.0f);
+    radius.push_back(0.0f);
+    update(object, boxMin, boxMax, sphereCenter, sphereRadius);
+    return object;
+}
+
+void FrustumCuller::update(uint32_t object, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    update(object, boxMin, boxMax, (boxMin + boxMax) * 0.5f, glm::length(boxMax - boxMin) * 0.5f);
+}
+
+void FrustumCuller::update(uint32_t object, const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::vec3& sphereCenter, float sphereRadius) {
+    glm::vec3 center = (boxMin + boxMax) * 0.5f;
+    glm::vec3 extent = (boxMax - boxMin) * 0.5f;
+    centerX[object] = center.x;
+    centerY[object] = center.y;
+    centerZ[object] = center.z;
+    extentX[object] = extent.x;
+    extentY[object] = extent.y;
+    extentZ[object] = extent.z;
+    radius[object] = glm::length(sphereCenter - center) + sphereRadius;
+}
+
+void FrustumCuller::clear() {
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    extentX.clear();
+    extentY.clear();
+    extentZ.clear();
+    radius.clear();
+}
+
+void FrustumCuller::cull(const Frustum& frustum, std::vector<uint32_t>& visible) const {
+    static const Path path = bestPath();
+    cull(frustum, visible, path);
+}
+
+void FrustumCuller::cull(const Frustum& frustum, std::vector<uint32_t>& visible, Path path) const {
+    // Written through a pointer and trimmed afterwards, which beats push_back in the inner loops
+    visible.resize(size());
+    size_t processed = 0;
+    size_t count = 0;
+    if (path == Path::Avx && isSupported(Path::Avx)) {
+        count = cullAvx(frustum, visible.data(), processed);
+    }
+    else if (path != Path::Scalar && isSupported(Path::Sse)) {
+        count = cullSse(frustum, visible.data(), processed);
+    }
+    // The scalar loop also finishes the objects left over after the last full SIMD group
+    count += cullScalar(frustum, processed, visible.data() + count);
+    visible.resize(count);
+}
+
+// Every path evaluates the same expressions in the same order, so they agree bit for bit:
+// an object is outside a plane when dot(n, c) + w < -min(radius, dot(|n|, extent)).
+size_t FrustumCuller::cullScalar(const Frustum& frustum, size_t first, uint32_t* visible) const {
+    size_t count = 0;
+    for (size_t object = first; object < size(); ++object) {
+        bool inside = true;
+        for (int plane = 0; plane < Frustum::PLANE_COUNT && inside; ++plane) {
+            const glm::vec4& p = frustum.planes[plane];
+            float distance = p.x * centerX[object] + p.y * centerY[object] + p.z * centerZ[object] + p.w;
+            float boxRadius = std::fabs(p.x) * extentX[object] + std::fabs(p.y) * extentY[object] + std::fabs(p.z) * extentZ[object];
+            inside = distance >= -std::min(radius[object], boxRadius);
+        }
+        if (inside) {
+            visible[count++] = static_cast<uint32_t>(object);
+        }
+    }
+    return count;
+}
+
+#ifdef FRUSTUM_CULLER_X86
+
+size_t FrustumCuller::cullSse(const Frustum& frustum, uint32_t* visible, size_t& processed) const {
+    __m128 planeX[Frustum::PLANE_COUNT], planeY[Frustum::PLANE_COUNT], planeZ[Frustum::PLANE_COUNT], planeW[Frustum::PLANE_COUNT];
+    __m128 absX[Frustum::PLANE_COUNT], absY[Frustum::PLANE_COUNT], absZ[Frustum::PLANE_COUNT];
+    for (int plane = 0; plane < Frustum::PLANE_COUNT; ++plane) {
+        const glm::vec4& p = frustum.planes[plane];
+        planeX[plane] = _mm_set1_ps(p.x);
+        planeY[plane] = _mm_set1_ps(p.y);
+        planeZ[plane] = _mm_set1_ps(p.z);
+        planeW[plane] = _mm_set1_ps(p.w);
+        absX[plane] = _mm_set1_ps(std::fabs(p.x));
+        absY[plane] = _mm_set1_ps(std::fabs(p.y));
+        absZ[plane] = _mm_set1_ps(std::fabs(p.z));
+    }
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+
+    size_t count = 0;
+    size_t end = size() & ~static_cast<size_t>(3);
+    for (size_t object = 0; object < end; object += 4) {
+        __m128 cx = _mm_loadu_ps(&centerX[object]);
+        __m128 cy = _mm_loadu_ps(&centerY[object]);
+        __m128 cz = _mm_loadu_ps(&centerZ[object]);
+        __m128 ex = _mm_loadu_ps(&extentX[object]);
+        __m128 ey = _mm_loadu_ps(&extentY[object]);
+        __m128 ez = _mm_loadu_ps(&extentZ[object]);
+        __m128 r = _mm_loadu_ps(&radius[object]);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int plane = 0; plane < Frustum::PLANE_COUNT; ++plane) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[plane], cx), _mm_mul_ps(planeY[plane], cy)),
+                _mm_mul_ps(planeZ[plane], cz)), planeW[plane]);
+            __m128 boxRadius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[plane], ex), _mm_mul_ps(absY[plane], ey)), _mm_mul_ps(absZ[plane], ez));
+            __m128 limit = _mm_xor_ps(_mm_min_ps(r, boxRadius), signBit);
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, limit));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+        for (int lane = 0; lane < 4; ++lane) {
+            if (mask & (1 << lane)) {
+                visible[count++] = static_cast<uint32_t>(object + lane);
+            }
+        }
+    }
+    processed = end;
+    return count;
+}
+
+AVX_TARGET size_t FrustumCuller::cullAvx(const Frustum& frustum, uint32_t* visible, size_t& processed) const {
+    __m256 planeX[Frustum::PLANE_COUNT], planeY[Frustum::PLANE_COUNT], planeZ[Frustum::PLANE_COUNT], planeW[Frustum::PLANE_COUNT];
+    __m256 absX[Frustum::PLANE_COUNT], absY[Frustum::PLANE_COUNT], absZ[Frustum::PLANE_COUNT];
+    for (int plane = 0; plane < Frustum::PLANE_COUNT; ++plane) {
+        const glm::vec4& p = frustum.planes[plane];
+        planeX[plane] = _mm256_set1_ps(p.x);
+        planeY[plane] = _mm256_set1_ps(p.y);
+        planeZ[plane] = _mm256_set1_ps(p.z);
+        planeW[plane] = _mm256_set1_ps(p.w);
+        absX[plane] = _mm256_set1_ps(std::fabs(p.x));
+        absY[plane] = _mm256_set1_ps(std::fabs(p.y));
+        absZ[plane] = _mm256_set1_ps(std::fabs(p.z));
+    }
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+    size_t count = 0;
+    size_t end = size() & ~static_cast<size_t>(7);
+    for (size_t object = 0; object < end; object += 8) {
+        __m256 cx = _mm256_loadu_ps(&centerX[object]);
+        __m256 cy = _mm256_loadu_ps(&centerY[object]);
+        __m256 cz = _mm256_loadu_ps(&centerZ[object]);
+        __m256 ex = _mm256_loadu_ps(&extentX[object]);
+        __m256 ey = _mm256_loadu_ps(&extentY[object]);
+        __m256 ez = _mm256_loadu_ps(&extentZ[object]);
+        __m256 r = _mm256_loadu_ps(&radius[object]);
+
+        // Stops early once all eight are outside, which is the common case far from the camera
+        int mask = 0xFF;
+        for (int plane = 0; plane < Frustum::PLANE_COUNT && mask != 0; ++plane) {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[plane], cx), _mm256_mul_ps(planeY[plane], cy)),
+                _mm256_mul_ps(planeZ[plane], cz)), planeW[plane]);
+            __m256 boxRadius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absX[plane], ex), _mm256_mul_ps(absY[plane], ey)),
+                _mm256_mul_ps(absZ[plane], ez));
+            __m256 limit = _mm256_xor_ps(_mm256_min_ps(r, boxRadius), signBit);
+            mask &= _mm256_movemask_ps(_mm256_cmp_ps(distance, limit, _CMP_GE_OQ));
+        }
+
+        for (int lane = 0; lane < 8; ++lane) {
+            if (mask & (1 << lane)) {
+                visible[count++] = static_cast<uint32_t>(object + lane);
+            }
+        }
+    }
+    processed = end;
+    return count;
+}
+
+static bool cpuSupportsAvx() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+    return osSavesYmm && (info[2] & (1 << 28)) != 0;
+#else
+    return __builtin_cpu_supports("avx");
+#endif
+}
+
+bool FrustumCuller::isSupported(Path path) {
+    static const bool avx = cpuSupportsAvx();
+    return path != Path::Avx || avx;  // SSE2 is part of every x86-64 CPU
+}
+
+#else
+
+size_t FrustumCuller::cullSse(const Frustum&, uint32_t*, size_t& processed) const {
+    processed = 0;
+    return 0;
+}
+
+size_t FrustumCuller::cullAvx(const Frustum&, uint32_t*, size_t& processed) const {
+    processed = 0;
+    return 0;
+}
+
+bool FrustumCuller::isSupported(Path path) {
+    return path == Path::Scalar;
+}
+
+#endif // FRUSTUM_CULLER_X86
+
+FrustumCuller::Path FrustumCuller::bestPath() {
+    if (isSupported(Path::Avx)) {
+        return Path::Avx;
+    }
+    return isSupported(Path::Sse) ? Path::Sse : Path::Scalar;
+}
+
+const char* FrustumCuller::pathName(Path path) {
+    switch (path) {
+    case Path::Sse:
+        return "SSE";
+    case Path::Avx:
+        return "AVX";
+    default:
+        return "scalar";
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#ifndef FRUSTUM_CULLER_H
+#define FRUSTUM_CULLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "frustum.h"
+
+// World-space bounds of many objects in structure-of-arrays form, tested against a frustum four (SSE)
+// or eight (AVX) objects at a time. Each object keeps a box and a bounding sphere; against every plane
+// the tighter of the two is used, so an object is culled when either volume is fully outside.
+// The game culls through SceneBvh; this stays in the asset cooker as the linear baseline its benchmarks
+// measure the hierarchy against.
+class FrustumCuller {
+public:
+    enum class Path {
+        Scalar,
+        Sse,
+        Avx,
+    };
+
+    // Returns the object's index; the sphere is optional, a box alone gets the sphere around it
+    uint32_t add(const glm::vec3& boxMin, const glm::vec3& boxMax);
+    uint32_t add(const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::vec3& sphereCenter, float sphereRadius);
+    void update(uint32_t object, const glm::vec3& boxMin, const glm::vec3& boxMax);
+    void update(uint32_t object, const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::vec3& sphereCenter, float sphereRadius);
+    void clear();
+    size_t size() const { return centerX.size(); }
+
+    // Replaces visible with the indices of the objects inside or crossing the frustum, in increasing
+    // order. Every path gives exactly the same list; the default picks the widest the CPU supports.
+    void cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+    void cull(const Frustum& frustum, std::vector<uint32_t>& visible, Path path) const;
+
+    static Path bestPath();
+    static bool isSupported(Path path);
+    static const char* pathName(Path path);
+
+private:
+    // Box centre and half extents. The sphere is re-centred on the box centre, grown to still enclose
+    // the original, so both volumes share one centre.
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    std::vector<float> radius;
+
+    size_t cullScalar(const Frustum& frustum, size_t first, uint32_t* visible) const;
+    size_t cullSse(const Frustum& frustum, uint32_t* visible, size_t& processed) const;
+    size_t cullAvx(const Frustum& frustum, uint32_t* visible, size_t& processed) const;
+};
+
+#endif // FRUSTUM_CULLER_H
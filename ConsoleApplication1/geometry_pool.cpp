@@ -0,0 +1,193 @@
+#include "geometry_pool.h"
+#include "vertex_layout_gl.h"
+#include <algorithm>
+#include <cstdint>
+
+GeometryPool& GeometryPool::shared() {
+    // Never destroyed, so models that outlive main can still return their ranges
+    static GeometryPool* pool = new GeometryPool();
+    return *pool;
+}
+
+GeometryPool::Stream GeometryPool::streamFor(VertexFormat format) {
+    switch (format) {
+    case VertexFormat::Compact16:
+        return Stream::Compact16;
+    case VertexFormat::Compact12:
+        return Stream::Compact12;
+    default:
+        return Stream::Float;
+    }
+}
+
+size_t GeometryPool::vertexSize(Stream stream) {
+    switch (stream) {
+    case Stream::Compact16:
+        return sizeof(CompactVertex16);
+    case Stream::Compact12:
+        return sizeof(CompactVertex12);
+    case Stream::Position:
+        return sizeof(PositionVertex);
+    default:
+        return sizeof(Vertex);
+    }
+}
+
+void GeometryPool::resize(Buffer& buffer, size_t unitSize, size_t newCapacity) {
+    GLuint grown = 0;
+    glGenBuffers(1, &grown);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(newCapacity * unitSize), nullptr, GL_STATIC_DRAW);
+    if (buffer.buffer != 0) {
+        // Copied on the GPU, including ranges whose upload is still in progress
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer.buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(buffer.allocator.capacity() * unitSize));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glDeleteBuffers(1, &buffer.buffer);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    buffer.buffer = grown;
+}
+
+bool GeometryPool::allocate(Buffer& buffer, size_t unitSize, size_t initialCapacity, size_t count, size_t alignment, Range& range) {
+    range = Range();
+    if (count == 0) {
+        return false;
+    }
+
+    size_t offset = buffer.allocator.allocate(count, alignment);
+    if (offset == FreeListAllocator::INVALID_OFFSET) {
+        size_t capacity = buffer.allocator.capacity();
+        size_t newCapacity = std::max(initialCapacity, capacity * 2);
+        while (newCapacity < capacity + count + alignment) {
+            newCapacity *= 2;
+        }
+        resize(buffer, unitSize, newCapacity);
+        buffer.allocator.grow(newCapacity);
+        offset = buffer.allocator.allocate(count, alignment);
+        if (offset == FreeListAllocator::INVALID_OFFSET) {
+            return false;
+        }
+    }
+    range.offset = offset;
+    range.count = count;
+    return true;
+}
+
+void GeometryPool::setupVertexArray(Stream stream) {
+    Buffer& vertices = streams[static_cast<size_t>(stream)];
+    if (vertices.vertexArray == 0) {
+        glGenVertexArrays(1, &vertices.vertexArray);
+    }
+    glBindVertexArray(vertices.vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, vertices.buffer);
+    switch (stream) {
+    case Stream::Compact16:
+        applyVertexLayout<CompactVertex16>();
+        break;
+    case Stream::Compact12:
+        applyVertexLayout<CompactVertex12>();
+        break;
+    case Stream::Position:
+        applyVertexLayout<PositionVertex>();
+        break;
+    default:
+        applyVertexLayout<Vertex>();
+        break;
+    }
+    if (indices.buffer != 0) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices.buffer);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    boundVertexArray = 0;
+}
+
+bool GeometryPool::allocateVertices(Stream stream, size_t count, Range& range) {
+    Buffer& vertices = streams[static_cast<size_t>(stream)];
+    GLuint previous = vertices.buffer;
+    if (!allocate(vertices, vertexSize(stream), INITIAL_VERTICES, count, 1, range)) {
+        return false;
+    }
+    if (vertices.buffer != previous) {
+        setupVertexArray(stream);
+    }
+    return true;
+}
+
+bool GeometryPool::allocateIndices(size_t bytes, Range& range) {
+    // 4-byte alignment suits both 16- and 32-bit indices
+    GLuint previous = indices.buffer;
+    if (!allocate(indices, 1, INITIAL_INDEX_BYTES, bytes, sizeof(uint32_t), range)) {
+        return false;
+    }
+    if (indices.buffer != previous) {
+        for (Buffer& vertices : streams) {
+            if (vertices.vertexArray != 0) {
+                glBindVertexArray(vertices.vertexArray);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices.buffer);
+            }
+        }
+        glBindVertexArray(0);
+        boundVertexArray = 0;
+    }
+    return true;
+}
+
+void GeometryPool::freeVertices(Stream stream, Range& range) {
+    if (range.valid() && !released) {
+        streams[static_cast<size_t>(stream)].allocator.free(range.offset);
+    }
+    range = Range();
+}
+
+void GeometryPool::freeIndices(Range& range) {
+    if (range.valid() && !released) {
+        indices.allocator.free(range.offset);
+    }
+    range = Range();
+}
+
+void GeometryPool::bindVertexArray(Stream stream) {
+    GLuint vertexArray = streams[static_cast<size_t>(stream)].vertexArray;
+    if (vertexArray == boundVertexArray) {
+        ++bindsSkipped;
+        return;
+    }
+    glBindVertexArray(vertexArray);
+    boundVertexArray = vertexArray;
+    ++vertexArrayBinds;
+}
+
+GeometryPool::Stats GeometryPool::stats() const {
+    Stats result;
+    for (size_t i = 0; i < STREAM_COUNT; ++i) {
+        result.vertices[i] = streams[i].allocator.stats();
+    }
+    result.indices = indices.allocator.stats();
+    result.vertexArrayBinds = vertexArrayBinds;
+    result.bindsSkipped = bindsSkipped;
+    return result;
+}
+
+void GeometryPool::release() {
+    glBindVertexArray(0);
+    for (Buffer& vertices : streams) {
+        if (vertices.vertexArray != 0) {
+            glDeleteVertexArrays(1, &vertices.vertexArray);
+            vertices.vertexArray = 0;
+        }
+        if (vertices.buffer != 0) {
+            glDeleteBuffers(1, &vertices.buffer);
+            vertices.buffer = 0;
+        }
+        vertices.allocator.reset(0);
+    }
+    if (indices.buffer != 0) {
+        glDeleteBuffers(1, &indices.buffer);
+        indices.buffer = 0;
+    }
+    indices.allocator.reset(0);
+    boundVertexArray = 0;
+    released = true;
+}
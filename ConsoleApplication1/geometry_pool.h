@@ -0,0 +1,85 @@
+#pragma once
+#ifndef GEOMETRY_POOL_H
+#define GEOMETRY_POOL_H
+
+#include <cstddef>
+#include <GL/glew.h>
+#include "free_list_allocator.h"
+#include "vertex_quantization.h"
+
+// Shared GPU geometry: one growable vertex buffer and VAO per vertex layout, and one index buffer all
+// the VAOs use. Models only hold ranges in them, so drawing many models needs a VAO bind per layout
+// change rather than per model, and any draws in one layout can be merged into a base-vertex multi-draw.
+class GeometryPool {
+public:
+    enum class Stream {
+        Float,      // Vertex
+        Compact16,  // CompactVertex16
+        Compact12,  // CompactVertex12
+        Position,   // PositionVertex, for depth passes
+    };
+    static const size_t STREAM_COUNT = 4;
+
+    // Vertex ranges count vertices, so offset is the base vertex of the range; index ranges count bytes
+    struct Range {
+        size_t offset = 0;
+        size_t count = 0;
+        bool valid() const { return count != 0; }
+    };
+
+    struct Stats {
+        FreeListAllocator::Stats vertices[STREAM_COUNT];  // In vertices
+        FreeListAllocator::Stats indices;                 // In bytes
+        size_t vertexArrayBinds = 0;
+        size_t bindsSkipped = 0;
+    };
+
+    static const size_t INITIAL_VERTICES = 64 * 1024;
+    static const size_t INITIAL_INDEX_BYTES = 1024 * 1024;
+
+    // The pool every Model allocates from; GL objects are created on first use
+    static GeometryPool& shared();
+    static Stream streamFor(VertexFormat format);
+    static size_t vertexSize(Stream stream);
+
+    // Buffers grow by doubling when a range does not fit; ranges already handed out keep their offsets
+    bool allocateVertices(Stream stream, size_t count, Range& range);
+    bool allocateIndices(size_t bytes, Range& range);
+    void freeVertices(Stream stream, Range& range);
+    void freeIndices(Range& range);
+
+    // Current buffer names; they change when a buffer grows
+    GLuint vertexBuffer(Stream stream) const { return streams[static_cast<size_t>(stream)].buffer; }
+    GLuint indexBuffer() const { return indices.buffer; }
+
+    // Binds the stream's VAO unless it is already bound
+    void bindVertexArray(Stream stream);
+    // Call after binding a VAO behind the pool's back
+    void invalidateBinding() { boundVertexArray = 0; }
+
+    Stats stats() const;
+    // Deletes the GL objects; call before the context goes away. Ranges freed afterwards are ignored.
+    void release();
+    bool isReleased() const { return released; }
+
+private:
+    struct Buffer {
+        GLuint buffer = 0;
+        GLuint vertexArray = 0;  // Vertex streams only
+        FreeListAllocator allocator;
+    };
+    Buffer streams[STREAM_COUNT];
+    Buffer indices;
+    GLuint boundVertexArray = 0;
+    size_t vertexArrayBinds = 0;
+    size_t bindsSkipped = 0;
+    bool released = false;
+
+    GeometryPool() = default;
+    // Reallocates the buffer at newCapacity units, keeping its contents
+    static void resize(Buffer& buffer, size_t unitSize, size_t newCapacity);
+    void setupVertexArray(Stream stream);
+    bool allocate(Buffer& buffer, size_t unitSize, size_t initialCapacity, size_t count, size_t alignment, Range& range);
+};
+
+#endif // GEOMETRY_POOL_H
@@ -0,0 +1,524 @@
+#include "gltf_file.h"
+#include "mesh_processing.h"
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+static const uint32_t GLB_MAGIC = 0x46546C67;       // "glTF"
+static const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;  // "JSON"
+static const uint32_t GLB_CHUNK_BIN = 0x004E4942;   // "BIN\0"
+static const int MAX_NODE_DEPTH = 64;
+
+static uint32_t readU32(const uint8_t* bytes) {
+    uint32_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+bool GltfFile::open(const std::string& path) {
+    close();
+    filename = path;
+    if (!file.open(path)) {
+        std::cerr << "Failed to open glTF file: " << path << std::endl;
+        return false;
+    }
+
+    const uint8_t* bytes = file.data();
+    size_t size = file.size();
+    if (size < 20 || readU32(bytes) != GLB_MAGIC || readU32(bytes + 4) != 2 || readU32(bytes + 8) > size) {
+        std::cerr << "Not a binary glTF 2.0 file: " << path << std::endl;
+        close();
+        return false;
+    }
+    size = readU32(bytes + 8);
+
+    // The JSON chunk comes first, then an optional binary chunk; anything after is ignored
+    size_t offset = 12;
+    bool haveJson = false;
+    while (offset + 8 <= size) {
+        uint32_t chunkLength = readU32(bytes + offset);
+        uint32_t chunkType = readU32(bytes + offset + 4);
+        const uint8_t* chunk = bytes + offset + 8;
+        if (chunkLength > size - offset - 8) {
+            std::cerr << "Truncated chunk in glTF file: " << path << std::endl;
+            close();
+            return false;
+        }
+
+        if (!haveJson) {
+            std::string error;
+            if (chunkType != GLB_CHUNK_JSON || !JsonValue::parse(reinterpret_cast<const char*>(chunk),
+                reinterpret_cast<const char*>(chunk) + chunkLength, document, error)) {
+                std::cerr << "Invalid JSON chunk in glTF file " << path << ": " << error << std::endl;
+                close();
+                return false;
+            }
+            haveJson = true;
+        }
+        else if (chunkType == GLB_CHUNK_BIN && binary == nullptr) {
+            binary = chunk;
+            binarySize = chunkLength;
+        }
+        offset += 8 + ((static_cast<size_t>(chunkLength) + 3) & ~static_cast<size_t>(3));
+    }
+
+    if (!haveJson) {
+        std::cerr << "Missing JSON chunk in glTF file: " << path << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void GltfFile::close() {
+    file.close();
+    document = JsonValue();
+    binary = nullptr;
+    binarySize = 0;
+}
+
+const uint8_t* GltfFile::binaryChunk(size_t& size) const {
+    size = binarySize;
+    return binary;
+}
+
+static uint32_t componentSize(uint32_t componentType) {
+    switch (componentType) {
+    case GltfFile::BYTE:
+    case GltfFile::UNSIGNED_BYTE:
+        return 1;
+    case GltfFile::SHORT:
+    case GltfFile::UNSIGNED_SHORT:
+        return 2;
+    case GltfFile::UNSIGNED_INT:
+    case GltfFile::FLOAT:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+static uint32_t componentCount(const std::string& type) {
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    if (type == "MAT4") return 16;
+    return 0;
+}
+
+// Byte range of a bufferView inside the binary chunk; only the GLB-stored buffer 0 is supported
+static const uint8_t* viewRange(const JsonValue& document, const uint8_t* binary, size_t binarySize, int index, size_t& length) {
+    const JsonValue& view = document["bufferViews"][static_cast<size_t>(index)];
+    if (!view.isObject() || view["buffer"].asInt(-1) != 0 || document["buffers"][size_t(0)].has("uri") || binary == nullptr) {
+        return nullptr;
+    }
+    double offset = view["byteOffset"].asNumber(0.0);
+    double viewLength = view["byteLength"].asNumber(-1.0);
+    if (offset < 0.0 || viewLength < 0.0 || offset + viewLength > static_cast<double>(binarySize)) {
+        return nullptr;
+    }
+    length = static_cast<size_t>(viewLength);
+    return binary + static_cast<size_t>(offset);
+}
+
+bool GltfFile::accessor(int index, Accessor& result) const {
+    const JsonValue& source = document["accessors"][static_cast<size_t>(index)];
+    if (!source.isObject() || source.has("sparse") || !source.has("bufferView")) {
+        return false;
+    }
+
+    result = Accessor();
+    result.bufferView = source["bufferView"].asInt(-1);
+    result.componentType = static_cast<uint32_t>(source["componentType"].asInt(0));
+    result.components = componentCount(source["type"].asString());
+    result.normalized = source["normalized"].asBool(false);
+    double count = source["count"].asNumber(-1.0);
+    uint32_t elementSize = componentSize(result.componentType) * result.components;
+    if (elementSize == 0 || count < 0.0) {
+        return false;
+    }
+    result.count = static_cast<size_t>(count);
+
+    size_t viewLength = 0;
+    const uint8_t* view = viewRange(document, binary, binarySize, result.bufferView, viewLength);
+    if (view == nullptr) {
+        return false;
+    }
+    result.stride = static_cast<size_t>(document["bufferViews"][static_cast<size_t>(result.bufferView)]["byteStride"].asInt(0));
+    if (result.stride == 0) {
+        result.stride = elementSize;
+    }
+    double offset = source["byteOffset"].asNumber(0.0);
+    if (offset < 0.0 || offset > static_cast<double>(viewLength)) {
+        return false;
+    }
+    if (result.count != 0) {
+        double last = offset + static_cast<double>(result.stride) * (result.count - 1) + elementSize;
+        if (last > static_cast<double>(viewLength)) {
+            return false;
+        }
+    }
+    result.data = view + static_cast<size_t>(offset);
+
+    const JsonValue& min = source["min"];
+    const JsonValue& max = source["max"];
+    if (result.components <= 3 && min.size() == result.components && max.size() == result.components) {
+        result.hasBounds = true;
+        for (uint32_t i = 0; i < result.components; ++i) {
+            result.min[i] = static_cast<float>(min[i].asNumber());
+            result.max[i] = static_cast<float>(max[i].asNumber());
+        }
+    }
+    return true;
+}
+
+const uint8_t* GltfFile::imageData(int image, size_t& size) const {
+    const JsonValue& source = document["images"][static_cast<size_t>(image)];
+    if (!source.has("bufferView")) {
+        return nullptr;
+    }
+    return viewRange(document, binary, binarySize, source["bufferView"].asInt(-1), size);
+}
+
+const uint8_t* GltfFile::embeddedTexture(const std::string& name, size_t& size) const {
+    if (name.size() < 2 || name[0] != EMBEDDED_IMAGE_PREFIX) {
+        return nullptr;
+    }
+    return imageData(std::atoi(name.c_str() + 1), size);
+}
+
+// Component i of element index as a float, applying normalization for integer types
+static float readComponent(const GltfFile::Accessor& accessor, size_t index, uint32_t i) {
+    const uint8_t* element = accessor.data + index * accessor.stride;
+    switch (accessor.componentType) {
+    case GltfFile::FLOAT: {
+        float value;
+        std::memcpy(&value, element + i * 4, sizeof(value));
+        return value;
+    }
+    case GltfFile::UNSIGNED_BYTE: {
+        float value = element[i];
+        return accessor.normalized ? value / 255.0f : value;
+    }
+    case GltfFile::BYTE: {
+        float value = static_cast<int8_t>(element[i]);
+        return accessor.normalized ? std::max(value / 127.0f, -1.0f) : value;
+    }
+    case GltfFile::UNSIGNED_SHORT: {
+        uint16_t value;
+        std::memcpy(&value, element + i * 2, sizeof(value));
+        return accessor.normalized ? value / 65535.0f : value;
+    }
+    case GltfFile::SHORT: {
+        int16_t value;
+        std::memcpy(&value, element + i * 2, sizeof(value));
+        return accessor.normalized ? std::max(value / 32767.0f, -1.0f) : value;
+    }
+    default:
+        return 0.0f;
+    }
+}
+
+static uint32_t readIndex(const GltfFile::Accessor& accessor, size_t index) {
+    const uint8_t* element = accessor.data + index * accessor.stride;
+    switch (accessor.componentType) {
+    case GltfFile::UNSIGNED_BYTE:
+        return element[0];
+    case GltfFile::UNSIGNED_SHORT: {
+        uint16_t value;
+        std::memcpy(&value, element, sizeof(value));
+        return value;
+    }
+    default: {
+        uint32_t value;
+        std::memcpy(&value, element, sizeof(value));
+        return value;
+    }
+    }
+}
+
+// URIs may percent-encode characters such as spaces
+static std::string decodeUri(const std::string& uri) {
+    std::string path;
+    for (size_t i = 0; i < uri.size(); ++i) {
+        if (uri[i] == '%' && i + 2 < uri.size() && std::isxdigit(static_cast<unsigned char>(uri[i + 1])) &&
+            std::isxdigit(static_cast<unsigned char>(uri[i + 2]))) {
+            path += static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16));
+            i += 2;
+        }
+        else {
+            path += uri[i];
+        }
+    }
+    return path;
+}
+
+static Material readMaterial(const JsonValue& document, const JsonValue& source) {
+    Material material;
+    material.name = source["name"].asString();
+    const JsonValue& pbr = source["pbrMetallicRoughness"];
+    const JsonValue& baseColor = pbr["baseColorFactor"];
+    material.diffuse = glm::vec3(static_cast<float>(baseColor[size_t(0)].asNumber(1.0)), static_cast<float>(baseColor[1].asNumber(1.0)),
+        static_cast<float>(baseColor[2].asNumber(1.0)));
+    material.dissolve = static_cast<float>(baseColor[3].asNumber(1.0));
+    const JsonValue& emissive = source["emissiveFactor"];
+    material.emission = glm::vec3(static_cast<float>(emissive[size_t(0)].asNumber()), static_cast<float>(emissive[1].asNumber()),
+        static_cast<float>(emissive[2].asNumber()));
+
+    if (pbr["baseColorTexture"].has("index")) {
+        const JsonValue& texture = document["textures"][static_cast<size_t>(pbr["baseColorTexture"]["index"].asInt(-1))];
+        int imageIndex = texture["source"].asInt(-1);
+        const JsonValue& image = document["images"][static_cast<size_t>(imageIndex)];
+        const std::string& uri = image["uri"].asString();
+        if (image.has("bufferView")) {
+            material.diffuseTexture = GltfFile::EMBEDDED_IMAGE_PREFIX + std::to_string(imageIndex);
+        }
+        else if (!uri.empty() && uri.compare(0, 5, "data:") != 0) {
+            material.diffuseTexture = decodeUri(uri);
+        }
+    }
+    return material;
+}
+
+static glm::mat4 nodeTransform(const JsonValue& node) {
+    glm::mat4 transform(1.0f);
+    const JsonValue& matrix = node["matrix"];
+    if (matrix.size() == 16) {
+        for (int column = 0; column < 4; ++column) {
+            for (int row = 0; row < 4; ++row) {
+                transform[column][row] = static_cast<float>(matrix[static_cast<size_t>(column * 4 + row)].asNumber());
+            }
+        }
+        return transform;
+    }
+
+    // T * R * S, with the rotation as an (x, y, z, w) quaternion
+    const JsonValue& t = node["translation"];
+    const JsonValue& r = node["rotation"];
+    const JsonValue& s = node["scale"];
+    float x = static_cast<float>(r[size_t(0)].asNumber(0.0)), y = static_cast<float>(r[1].asNumber(0.0));
+    float z = static_cast<float>(r[2].asNumber(0.0)), w = static_cast<float>(r[3].asNumber(1.0));
+    glm::vec3 scale(static_cast<float>(s[size_t(0)].asNumber(1.0)), static_cast<float>(s[1].asNumber(1.0)), static_cast<float>(s[2].asNumber(1.0)));
+    transform[0] = glm::vec4(1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w), 0) * scale.x;
+    transform[1] = glm::vec4(2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w), 0) * scale.y;
+    transform[2] = glm::vec4(2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y), 0) * scale.z;
+    transform[3] = glm::vec4(static_cast<float>(t[size_t(0)].asNumber()), static_cast<float>(t[1].asNumber()), static_cast<float>(t[2].asNumber()), 1.0f);
+    return transform;
+}
+
+namespace {
+    // A mesh placed by the scene graph
+    struct MeshInstance {
+        int mesh;
+        glm::mat4 transform;
+    };
+
+    // One triangle primitive's resolved accessors
+    struct Primitive {
+        GltfFile::Accessor positions, normals, texCoords, indices;
+        bool hasNormals = false, hasTexCoords = false, hasIndices = false;
+        int material = -1;
+        glm::mat4 transform{ 1.0f };
+    };
+}
+
+static void collectNodes(const JsonValue& document, int nodeIndex, const glm::mat4& parent, int depth, std::vector<MeshInstance>& instances) {
+    const JsonValue& node = document["nodes"][static_cast<size_t>(nodeIndex)];
+    if (!node.isObject() || depth > MAX_NODE_DEPTH) {
+        return;
+    }
+    glm::mat4 transform = parent * nodeTransform(node);
+    if (node.has("mesh")) {
+        instances.push_back({ node["mesh"].asInt(-1), transform });
+    }
+    const JsonValue& children = node["children"];
+    for (size_t i = 0; i < children.size(); ++i) {
+        collectNodes(document, children[i].asInt(-1), transform, depth + 1, instances);
+    }
+}
+
+bool GltfFile::readMesh(MeshData& mesh, GltfMeshSource& source) const {
+    mesh.clear();
+    source = GltfMeshSource();
+
+    // Meshes placed by the default scene; files without scenes just list meshes
+    std::vector<MeshInstance> instances;
+    const JsonValue& scenes = document["scenes"];
+    if (scenes.size() > 0) {
+        const JsonValue& roots = scenes[static_cast<size_t>(document["scene"].asInt(0))]["nodes"];
+        for (size_t i = 0; i < roots.size(); ++i) {
+            collectNodes(document, roots[i].asInt(-1), glm::mat4(1.0f), 0, instances);
+        }
+    }
+    else {
+        for (size_t i = 0; i < document["meshes"].size(); ++i) {
+            instances.push_back({ static_cast<int>(i), glm::mat4(1.0f) });
+        }
+    }
+
+    std::vector<Primitive> primitives;
+    std::vector<int> meshUses(document["meshes"].size(), 0);
+    for (const MeshInstance& instance : instances) {
+        const JsonValue& primitiveList = document["meshes"][static_cast<size_t>(instance.mesh)]["primitives"];
+        if (instance.mesh >= 0 && static_cast<size_t>(instance.mesh) < meshUses.size()) {
+            ++meshUses[instance.mesh];
+        }
+        for (size_t i = 0; i < primitiveList.size(); ++i) {
+            const JsonValue& primitiveSource = primitiveList[i];
+            // Points and lines have no surface to draw
+            if (primitiveSource["mode"].asInt(4) != 4) {
+                continue;
+            }
+            const JsonValue& attributes = primitiveSource["attributes"];
+            Primitive primitive;
+            primitive.transform = instance.transform;
+            primitive.material = primitiveSource["material"].asInt(-1);
+            if (!accessor(attributes["POSITION"].asInt(-1), primitive.positions) || primitive.positions.components != 3) {
+                std::cerr << "Unsupported POSITION accessor in glTF file: " << filename << std::endl;
+                return false;
+            }
+            primitive.hasNormals = attributes.has("NORMAL") && accessor(attributes["NORMAL"].asInt(-1), primitive.normals) &&
+                primitive.normals.components == 3 && primitive.normals.count == primitive.positions.count;
+            primitive.hasTexCoords = attributes.has("TEXCOORD_0") && accessor(attributes["TEXCOORD_0"].asInt(-1), primitive.texCoords) &&
+                primitive.texCoords.components == 2 && primitive.texCoords.count == primitive.positions.count;
+            if (primitiveSource.has("indices")) {
+                primitive.hasIndices = accessor(primitiveSource["indices"].asInt(-1), primitive.indices) && primitive.indices.components == 1 &&
+                    (primitive.indices.componentType == UNSIGNED_BYTE || primitive.indices.componentType == UNSIGNED_SHORT ||
+                        primitive.indices.componentType == UNSIGNED_INT);
+                if (!primitive.hasIndices) {
+                    std::cerr << "Unsupported index accessor in glTF file: " << filename << std::endl;
+                    return false;
+                }
+            }
+            primitives.push_back(primitive);
+        }
+    }
+    if (primitives.empty()) {
+        std::cerr << "No triangles in glTF file: " << filename << std::endl;
+        return false;
+    }
+
+    // Direct use needs untransformed, unshared primitives whose attributes already are Vertex records in a row
+    bool direct = true;
+    const uint8_t* expected = primitives[0].positions.data;
+    for (const int uses : meshUses) {
+        direct = direct && uses <= 1;
+    }
+    for (const Primitive& primitive : primitives) {
+        const GltfFile::Accessor& positions = primitive.positions;
+        direct = direct && primitive.transform == glm::mat4(1.0f) && primitive.hasNormals && primitive.hasTexCoords && positions.hasBounds &&
+            positions.data == expected && positions.stride == sizeof(Vertex) && positions.componentType == FLOAT &&
+            primitive.normals.data == positions.data + offsetof(Vertex, normal) && primitive.normals.stride == sizeof(Vertex) &&
+            primitive.normals.componentType == FLOAT && primitive.texCoords.data == positions.data + offsetof(Vertex, texCoord) &&
+            primitive.texCoords.stride == sizeof(Vertex) && primitive.texCoords.componentType == FLOAT && !primitive.texCoords.normalized &&
+            reinterpret_cast<uintptr_t>(positions.data) % alignof(Vertex) == 0;
+        expected = positions.data + positions.count * sizeof(Vertex);
+    }
+    static_assert(sizeof(Vertex) == 8 * sizeof(float), "Vertex must be position, normal, texCoord floats");
+
+    // Materials, merged like MTL ones so duplicates share a draw
+    const JsonValue& materialList = document["materials"];
+    std::vector<Material> materials;
+    for (size_t i = 0; i < materialList.size(); ++i) {
+        materials.push_back(readMaterial(document, materialList[i]));
+    }
+    std::vector<bool> used(materials.size(), false);
+    for (const Primitive& primitive : primitives) {
+        if (primitive.material >= 0 && static_cast<size_t>(primitive.material) < materials.size()) {
+            used[primitive.material] = true;
+        }
+    }
+    std::vector<int32_t> remap = MeshProcessor::mergeMaterials(materials, used, mesh.materials);
+
+    std::vector<int32_t> triangleMaterials;
+    size_t vertexCount = 0;
+    for (const Primitive& primitive : primitives) {
+        const size_t count = primitive.positions.count;
+        const uint32_t baseVertex = static_cast<uint32_t>(vertexCount);
+
+        if (!direct) {
+            // Normals go through the cofactor matrix so non-uniform scales keep them perpendicular; it carries
+            // the determinant's sign, which mirroring transforms must not apply to the normals
+            const glm::mat4& m = primitive.transform;
+            glm::vec3 c0 = glm::cross(glm::vec3(m[1]), glm::vec3(m[2]));
+            glm::vec3 c1 = glm::cross(glm::vec3(m[2]), glm::vec3(m[0]));
+            glm::vec3 c2 = glm::cross(glm::vec3(m[0]), glm::vec3(m[1]));
+            if (glm::dot(glm::vec3(m[0]), c0) < 0.0f) {
+                c0 = -c0;
+                c1 = -c1;
+                c2 = -c2;
+            }
+            for (size_t v = 0; v < count; ++v) {
+                Vertex vertex{};
+                glm::vec4 position = m * glm::vec4(readComponent(primitive.positions, v, 0), readComponent(primitive.positions, v, 1),
+                    readComponent(primitive.positions, v, 2), 1.0f);
+                vertex.position = glm::vec3(position);
+                vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+                if (primitive.hasNormals) {
+                    glm::vec3 normal = c0 * readComponent(primitive.normals, v, 0) + c1 * readComponent(primitive.normals, v, 1) +
+                        c2 * readComponent(primitive.normals, v, 2);
+                    float length = glm::length(normal);
+                    if (length > 0.0f) {
+                        vertex.normal = normal / length;
+                    }
+                }
+                if (primitive.hasTexCoords) {
+                    vertex.texCoord = glm::vec2(readComponent(primitive.texCoords, v, 0), readComponent(primitive.texCoords, v, 1));
+                }
+                mesh.vertices.push_back(vertex);
+            }
+        }
+
+        // Mirroring transforms turn the triangles inside out; swap two corners to keep them front facing
+        const glm::mat4& m = primitive.transform;
+        bool flip = glm::dot(glm::vec3(m[0]), glm::cross(glm::vec3(m[1]), glm::vec3(m[2]))) < 0.0f;
+        size_t cornerCount = primitive.hasIndices ? primitive.indices.count : count;
+        cornerCount -= cornerCount % 3;
+        for (size_t corner = 0; corner < cornerCount; corner += 3) {
+            uint32_t triangle[3];
+            for (size_t k = 0; k < 3; ++k) {
+                triangle[k] = primitive.hasIndices ? readIndex(primitive.indices, corner + k) : static_cast<uint32_t>(corner + k);
+                if (triangle[k] >= count) {
+                    std::cerr << "Index out of range in glTF file: " << filename << std::endl;
+                    mesh.clear();
+                    return false;
+                }
+            }
+            if (flip) {
+                std::swap(triangle[1], triangle[2]);
+            }
+            for (uint32_t index : triangle) {
+                mesh.indices.push_back(baseVertex + index);
+            }
+            bool known = primitive.material >= 0 && static_cast<size_t>(primitive.material) < remap.size();
+            triangleMaterials.push_back(known ? remap[primitive.material] : -1);
+        }
+        vertexCount += count;
+    }
+
+    MeshProcessor::groupByMaterial(mesh, triangleMaterials);
+    mesh.ensureBaseLod();
+
+    if (direct) {
+        source.directVertices = reinterpret_cast<const Vertex*>(primitives[0].positions.data);
+        source.vertexCount = vertexCount;
+        // The accessor bounds are required by the spec, so the vertices need not be touched
+        mesh.boundsMin = glm::vec3(primitives[0].positions.min[0], primitives[0].positions.min[1], primitives[0].positions.min[2]);
+        mesh.boundsMax = glm::vec3(primitives[0].positions.max[0], primitives[0].positions.max[1], primitives[0].positions.max[2]);
+        for (const Primitive& primitive : primitives) {
+            mesh.boundsMin = glm::min(mesh.boundsMin, glm::vec3(primitive.positions.min[0], primitive.positions.min[1], primitive.positions.min[2]));
+            mesh.boundsMax = glm::max(mesh.boundsMax, glm::vec3(primitive.positions.max[0], primitive.positions.max[1], primitive.positions.max[2]));
+        }
+        mesh.sphereCenter = (mesh.boundsMin + mesh.boundsMax) * 0.5f;
+        mesh.sphereRadius = glm::length(mesh.boundsMax - mesh.boundsMin) * 0.5f;
+    }
+    else {
+        source.vertexCount = mesh.vertices.size();
+        mesh.computeBounds();
+    }
+    return true;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#ifndef GLTF_FILE_H
+#define GLTF_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "json.h"
+#include "mapped_file.h"
+#include "mesh_data.h"
+
+// Where the vertices of a mesh read from a .glb live
+struct GltfMeshSource {
+    // Set when every primitive's POSITION/NORMAL/TEXCOORD_0 is already an interleaved float array in
+    // Vertex layout, laid out back to back in the binary chunk: the vertices are then used straight
+    // from the mapping and mesh.vertices stays empty.
+    const Vertex* directVertices = nullptr;
+    size_t vertexCount = 0;
+};
+
+// Binary glTF 2.0 reader. The file is memory mapped; accessors point into the mapped binary chunk,
+// and the returned pointers stay valid until close().
+class GltfFile {
+public:
+    enum ComponentType : uint32_t {
+        BYTE = 5120,
+        UNSIGNED_BYTE = 5121,
+        SHORT = 5122,
+        UNSIGNED_SHORT = 5123,
+        UNSIGNED_INT = 5125,
+        FLOAT = 5126,
+    };
+
+    struct Accessor {
+        const uint8_t* data = nullptr;  // First element
+        size_t count = 0;
+        size_t stride = 0;              // Bytes between elements
+        uint32_t componentType = FLOAT;
+        uint32_t components = 1;
+        bool normalized = false;
+        int bufferView = -1;
+        bool hasBounds = false;
+        float min[3] = {};
+        float max[3] = {};
+    };
+
+    bool open(const std::string& filename);
+    void close();
+
+    const JsonValue& json() const { return document; }
+    const uint8_t* binaryChunk(size_t& size) const;
+
+    // Resolves and range-checks an accessor; false for sparse or out-of-range accessors
+    bool accessor(int index, Accessor& result) const;
+
+    // Material::diffuseTexture of a texture embedded in the file is this prefix and the image index
+    static const char EMBEDDED_IMAGE_PREFIX = '#';
+
+    // Embedded image bytes, or nullptr when the image is stored outside the file
+    const uint8_t* imageData(int image, size_t& size) const;
+    // Same for a Material::diffuseTexture name; nullptr unless it names an embedded image
+    const uint8_t* embeddedTexture(const std::string& name, size_t& size) const;
+
+    // Flattens the default scene into mesh: one submesh per triangle primitive, node transforms baked
+    // in, materials merged as in MeshProcessor. Nothing is deduplicated; glTF vertices are already unique.
+    bool readMesh(MeshData& mesh, GltfMeshSource& source) const;
+
+private:
+    MappedFile file;
+    JsonValue document;
+    const uint8_t* binary = nullptr;
+    size_t binarySize = 0;
+    std::string filename;
+};
+
+#endif // GLTF_FILE_H
@@ -0,0 +1,96 @@
+#include "index_buffer.h"
+#include <algorithm>
+#include <cstring>
+
+IndexLayout IndexPacker::pack(const uint32_t* indices, size_t indexCount, const std::vector<Submesh>& submeshes,
+    std::vector<uint8_t>& packed) {
+    IndexLayout layout;
+    layout.baseVertices.assign(submeshes.size(), 0);
+
+    uint32_t maxIndex = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        maxIndex = std::max(maxIndex, indices[i]);
+    }
+
+    bool fits = maxIndex <= 0xFFFF;
+    if (!fits) {
+        // Too many vertices for one 16-bit range; see whether each submesh fits on its own
+        fits = true;
+        std::vector<int32_t> baseVertices(submeshes.size(), 0);
+        for (size_t s = 0; s < submeshes.size() && fits; ++s) {
+            const Submesh& submesh = submeshes[s];
+            if (submesh.indexCount == 0) {
+                continue;
+            }
+            const uint32_t* first = indices + submesh.firstIndex;
+            auto range = std::minmax_element(first, first + submesh.indexCount);
+            fits = *range.second - *range.first <= 0xFFFF;
+            baseVertices[s] = static_cast<int32_t>(*range.first);
+        }
+
+        // Indices not covered by a submesh are drawn without a base vertex
+        std::vector<char> covered(indexCount, 0);
+        for (const Submesh& submesh : submeshes) {
+            std::fill(covered.begin() + submesh.firstIndex, covered.begin() + submesh.firstIndex + submesh.indexCount, 1);
+        }
+        for (size_t i = 0; i < indexCount && fits; ++i) {
+            fits = covered[i] || indices[i] <= 0xFFFF;
+        }
+
+        if (fits) {
+            layout.baseVertices = baseVertices;
+        }
+    }
+
+    if (!fits) {
+        layout.indexSize = sizeof(uint32_t);
+        layout.baseVertices.assign(submeshes.size(), 0);
+        packed.resize(indexCount * sizeof(uint32_t));
+        if (indexCount != 0) {
+            std::memcpy(packed.data(), indices, indexCount * sizeof(uint32_t));
+        }
+        return layout;
+    }
+
+    layout.indexSize = sizeof(uint16_t);
+    packed.resize(indexCount * sizeof(uint16_t));
+    uint16_t* output = reinterpret_cast<uint16_t*>(packed.data());
+    for (size_t i = 0; i < indexCount; ++i) {
+        output[i] = static_cast<uint16_t>(indices[i]);
+    }
+    for (size_t s = 0; s < submeshes.size(); ++s) {
+        uint32_t base = static_cast<uint32_t>(layout.baseVertices[s]);
+        if (base == 0) {
+            continue;
+        }
+        const Submesh& submesh = submeshes[s];
+        for (uint32_t i = submesh.firstIndex; i < submesh.firstIndex + submesh.indexCount; ++i) {
+            output[i] = static_cast<uint16_t>(indices[i] - base);
+        }
+    }
+    return layout;
+}
+
+void IndexPacker::unpack(const void* packed, size_t indexCount, const IndexLayout& layout, const std::vector<Submesh>& submeshes,
+    std::vector<uint32_t>& indices) {
+    indices.resize(indexCount);
+    if (layout.indexSize == sizeof(uint32_t)) {
+        if (indexCount != 0) {
+            std::memcpy(indices.data(), packed, indexCount * sizeof(uint32_t));
+        }
+    }
+    else {
+        const uint16_t* input = static_cast<const uint16_t*>(packed);
+        std::copy(input, input + indexCount, indices.begin());
+    }
+    for (size_t s = 0; s < submeshes.size() && s < layout.baseVertices.size(); ++s) {
+        uint32_t base = static_cast<uint32_t>(layout.baseVertices[s]);
+        if (base == 0) {
+            continue;
+        }
+        const Submesh& submesh = submeshes[s];
+        for (uint32_t i = submesh.firstIndex; i < submesh.firstIndex + submesh.indexCount; ++i) {
+            indices[i] += base;
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+#ifndef INDEX_BUFFER_H
+#define INDEX_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "mesh_data.h"
+
+// How an index buffer was packed for the GPU. Draws take their byte offsets and base vertices from here.
+struct IndexLayout {
+    uint32_t indexSize = sizeof(uint32_t);  // 2 or 4
+    std::vector<int32_t> baseVertices;      // Per submesh; added by the GPU to every index in the submesh's range
+    uintptr_t firstByte = 0;                // Where the mesh's indices start in a shared index buffer
+    int32_t firstVertex = 0;                // Where its vertices start in a shared vertex buffer
+
+    uintptr_t byteOffset(uint32_t firstIndex) const { return firstByte + static_cast<uintptr_t>(firstIndex) * indexSize; }
+    int32_t baseVertex(size_t submesh) const { return firstVertex + (submesh < baseVertices.size() ? baseVertices[submesh] : 0); }
+};
+
+class IndexPacker {
+public:
+    // Packs indices as 16-bit when every submesh references a vertex span of at most 65536 (rebasing
+    // each submesh on its lowest vertex when the mesh as a whole is larger), as 32-bit otherwise.
+    // Indices outside every submesh are packed unrebased.
+    static IndexLayout pack(const uint32_t* indices, size_t indexCount, const std::vector<Submesh>& submeshes,
+        std::vector<uint8_t>& packed);
+    // Widens packed indices back to 32-bit and adds each submesh's base vertex, for CPU-side users such
+    // as the depth stream and the triangle hierarchy. Ignores layout.firstByte and layout.firstVertex.
+    static void unpack(const void* packed, size_t indexCount, const IndexLayout& layout, const std::vector<Submesh>& submeshes,
+        std::vector<uint32_t>& indices);
+};
+
+#endif // INDEX_BUFFER_H
@@ -0,0 +1,74 @@
+#include "instance_buffer.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+static const GLuint INSTANCE_TRANSFORM_LOCATION = 3;
+static const GLuint INSTANCE_COLOR_LOCATION = 7;
+
+InstanceBuffer& InstanceBuffer::shared() {
+    static InstanceBuffer instances;
+    return instances;
+}
+
+size_t InstanceBuffer::upload(const glm::mat4* transforms, const glm::vec4* colors, size_t count) {
+    const size_t capacityBytes = CAPACITY * sizeof(InstanceData);
+    size_t bytes = count * sizeof(InstanceData);
+    if (buffer == 0) {
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(capacityBytes), nullptr, GL_STREAM_DRAW);
+    }
+    else {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    }
+    if (cursor + bytes > capacityBytes) {
+        // Orphan instead of waiting for draws that still read the old data
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(capacityBytes), nullptr, GL_STREAM_DRAW);
+        cursor = 0;
+    }
+
+    // Ranges are never reused before the next orphan, so no synchronization is needed
+    size_t offset = cursor;
+    void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(bytes),
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (mapped != nullptr) {
+        InstanceData* instances = static_cast<InstanceData*>(mapped);
+        for (size_t i = 0; i < count; ++i) {
+            InstanceData instance = { transforms[i], colors != nullptr ? colors[i] : glm::vec4(1.0f) };
+            std::memcpy(instances + i, &instance, sizeof(instance));
+        }
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    cursor += bytes;
+    return offset;
+}
+
+void InstanceBuffer::bindAttributes(size_t byteOffset) const {
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (GLuint column = 0; column < 4; ++column) {
+        GLuint location = INSTANCE_TRANSFORM_LOCATION + column;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+            reinterpret_cast<const void*>(static_cast<uintptr_t>(byteOffset + offsetof(InstanceData, transform) + column * sizeof(glm::vec4))));
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    }
+    glVertexAttribPointer(INSTANCE_COLOR_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+        reinterpret_cast<const void*>(static_cast<uintptr_t>(byteOffset + offsetof(InstanceData, color))));
+    glVertexAttribDivisor(INSTANCE_COLOR_LOCATION, 1);
+    glEnableVertexAttribArray(INSTANCE_COLOR_LOCATION);
+}
+
+void InstanceBuffer::unbindAttributes() {
+    for (GLuint location = INSTANCE_TRANSFORM_LOCATION; location <= INSTANCE_COLOR_LOCATION; ++location) {
+        glDisableVertexAttribArray(location);
+    }
+}
+
+void InstanceBuffer::release() {
+    if (buffer != 0) {
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+    cursor = 0;
+}
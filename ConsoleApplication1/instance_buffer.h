@@ -0,0 +1,43 @@
+#pragma once
+#ifndef INSTANCE_BUFFER_H
+#define INSTANCE_BUFFER_H
+
+#include <cstddef>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Per-instance vertex attributes read by vertex_shader.glsl when u_Instanced is set
+struct InstanceData {
+    glm::mat4 transform;  // Locations 3-6, one column each
+    glm::vec4 color;      // Location 7; multiplies the material colour
+};
+
+// Streaming buffer for per-instance data. Each upload is written behind the previous ones without
+// synchronizing; when the buffer is full its storage is orphaned, so the GPU keeps reading the old
+// copy while the new one is filled.
+class InstanceBuffer {
+public:
+    static const size_t CAPACITY = 16384;  // Instances per buffer generation; larger batches are split
+
+    static InstanceBuffer& shared();
+
+    // Copies count instances (count <= CAPACITY); colors may be null for white. Returns the byte offset
+    // to pass to bindAttributes.
+    size_t upload(const glm::mat4* transforms, const glm::vec4* colors, size_t count);
+
+    // Points the instance attributes of the bound VAO at the data uploaded at byteOffset
+    void bindAttributes(size_t byteOffset) const;
+    // Disables them again, so non-instanced draws from the same VAO do not read the buffer
+    static void unbindAttributes();
+
+    // Deletes the buffer; call before the context goes away
+    void release();
+
+private:
+    GLuint buffer = 0;
+    size_t cursor = 0;  // Next free byte
+
+    InstanceBuffer() = default;
+};
+
+#endif // INSTANCE_BUFFER_H
@@ -0,0 +1,84 @@
+#include "instancing_benchmark.h"
+#include "models.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// Runs draw once untimed, then rounds times, returning average CPU and GPU milliseconds per round
+template <typename Draw>
+static void timeRounds(int rounds, Draw draw, double& cpuMilliseconds, double& gpuMilliseconds) {
+    draw();
+    glFinish();
+
+    GLuint query = 0;
+    glGenQueries(1, &query);
+    cpuMilliseconds = 0.0;
+    gpuMilliseconds = 0.0;
+    for (int round = 0; round < rounds; ++round) {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        draw();
+        glEndQuery(GL_TIME_ELAPSED);
+        auto endTime = std::chrono::high_resolution_clock::now();
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+        cpuMilliseconds += std::chrono::duration<double, std::milli>(endTime - startTime).count();
+        gpuMilliseconds += elapsed / 1e6;
+    }
+    glDeleteQueries(1, &query);
+    cpuMilliseconds /= rounds;
+    gpuMilliseconds /= rounds;
+}
+
+InstancingBenchmark::Result InstancingBenchmark::run(Model& model, GLuint shaderProgram, size_t instanceCount, float spacing, int rounds) {
+    Result result;
+    result.instances = instanceCount;
+    if (!model.isLoaded() || instanceCount == 0 || rounds <= 0) {
+        return result;
+    }
+
+    // Square grid on the ground plane, tinted by position so the copies can be told apart
+    std::vector<glm::mat4> transforms(instanceCount);
+    std::vector<glm::vec4> colors(instanceCount);
+    size_t side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(instanceCount))));
+    for (size_t i = 0; i < instanceCount; ++i) {
+        float x = static_cast<float>(i % side);
+        float z = static_cast<float>(i / side);
+        transforms[i] = glm::translate(glm::mat4(1.0f), glm::vec3(x * spacing, 0.0f, z * spacing));
+        colors[i] = glm::vec4(0.5f + 0.5f * x / side, 0.5f + 0.5f * z / side, 1.0f, 1.0f);
+    }
+
+    GLint savedProgram = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &savedProgram);
+    glUseProgram(shaderProgram);
+
+    glm::mat4 savedMatrix = model.getModelMatrix();
+    timeRounds(rounds, [&]() {
+        for (const glm::mat4& transform : transforms) {
+            model.setModelMatrix(transform);
+            model.draw(shaderProgram);
+        }
+    }, result.individualCpuMilliseconds, result.individualGpuMilliseconds);
+    model.setModelMatrix(savedMatrix);
+
+    timeRounds(rounds, [&]() {
+        model.drawInstanced(shaderProgram, transforms.data(), transforms.size(), colors.data());
+    }, result.instancedCpuMilliseconds, result.instancedGpuMilliseconds);
+
+    glUseProgram(static_cast<GLuint>(savedProgram));
+    return result;
+}
+
+void InstancingBenchmark::print(const Result& result) {
+    std::cout << "Instancing benchmark, " << result.instances << " copies: individual draws " << result.individualCpuMilliseconds
+        << " ms CPU / " << result.individualGpuMilliseconds << " ms GPU, instanced " << result.instancedCpuMilliseconds
+        << " ms CPU / " << result.instancedGpuMilliseconds << " ms GPU";
+    if (result.instancedCpuMilliseconds > 0.0) {
+        std::cout << " (" << result.individualCpuMilliseconds / result.instancedCpuMilliseconds << "x less CPU)";
+    }
+    std::cout << std::endl;
+}
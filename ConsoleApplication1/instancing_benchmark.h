@@ -0,0 +1,28 @@
+#pragma once
+#ifndef INSTANCING_BENCHMARK_H
+#define INSTANCING_BENCHMARK_H
+
+#include <cstddef>
+#include <GL/glew.h>
+
+class Model;
+
+// Draws a grid of copies of a model once with a Model::draw per copy and once with a single
+// Model::drawInstanced, timing both on the CPU (submission) and the GPU (GL_TIME_ELAPSED).
+class InstancingBenchmark {
+public:
+    struct Result {
+        size_t instances = 0;
+        double individualCpuMilliseconds = 0.0;
+        double individualGpuMilliseconds = 0.0;
+        double instancedCpuMilliseconds = 0.0;
+        double instancedGpuMilliseconds = 0.0;
+    };
+
+    // Averages over rounds after one warm-up round of each; spacing is the grid step in world units.
+    // The model matrix is restored afterwards.
+    static Result run(Model& model, GLuint shaderProgram, size_t instanceCount = 10000, float spacing = 3.0f, int rounds = 5);
+    static void print(const Result& result);
+};
+
+#endif // INSTANCING_BENCHMARK_H
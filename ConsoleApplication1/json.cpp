@@ -0,0 +1,283 @@
+#include "json.h"
+#include <charconv>
+#include <cstring>
+
+static const JsonValue& nullValue() {
+    static const JsonValue value;
+    return value;
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const {
+    return valueType == Type::Array && index < elements.size() ? elements[index] : nullValue();
+}
+
+const JsonValue& JsonValue::operator[](const char* key) const {
+    if (valueType == Type::Object) {
+        for (const auto& member : members) {
+            if (member.first == key) {
+                return member.second;
+            }
+        }
+    }
+    return nullValue();
+}
+
+bool JsonValue::has(const char* key) const {
+    return &(*this)[key] != &nullValue();
+}
+
+// Recursive descent over the text; depth is capped so hostile files cannot overflow the stack
+class JsonParser {
+public:
+    JsonParser(const char* begin, const char* end) : cursor(begin), start(begin), end(end) {}
+
+    bool parseDocument(JsonValue& value, std::string& error) {
+        if (!parseValue(value, 0)) {
+            error = message + " at offset " + std::to_string(cursor - start);
+            return false;
+        }
+        skipWhitespace();
+        if (cursor != end) {
+            error = "Trailing characters at offset " + std::to_string(cursor - start);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static const int MAX_DEPTH = 64;
+
+    const char* cursor;
+    const char* start;
+    const char* end;
+    std::string message;
+
+    bool fail(const char* text) {
+        message = text;
+        return false;
+    }
+
+    void skipWhitespace() {
+        while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r')) {
+            ++cursor;
+        }
+    }
+
+    bool literal(const char* word) {
+        size_t length = std::strlen(word);
+        if (static_cast<size_t>(end - cursor) < length || std::memcmp(cursor, word, length) != 0) {
+            return fail("Invalid literal");
+        }
+        cursor += length;
+        return true;
+    }
+
+    bool parseValue(JsonValue& value, int depth) {
+        if (depth > MAX_DEPTH) {
+            return fail("Nesting too deep");
+        }
+        skipWhitespace();
+        if (cursor >= end) {
+            return fail("Unexpected end of input");
+        }
+
+        switch (*cursor) {
+        case '{':
+            return parseObject(value, depth);
+        case '[':
+            return parseArray(value, depth);
+        case '"':
+            value.valueType = JsonValue::Type::String;
+            return parseString(value.stringValue);
+        case 't':
+            value.valueType = JsonValue::Type::Bool;
+            value.boolValue = true;
+            return literal("true");
+        case 'f':
+            value.valueType = JsonValue::Type::Bool;
+            value.boolValue = false;
+            return literal("false");
+        case 'n':
+            value.valueType = JsonValue::Type::Null;
+            return literal("null");
+        default:
+            return parseNumber(value);
+        }
+    }
+
+    bool parseNumber(JsonValue& value) {
+        if (*cursor != '-' && (*cursor < '0' || *cursor > '9')) {
+            return fail("Unexpected character");
+        }
+        std::from_chars_result result = std::from_chars(cursor, end, value.numberValue);
+        if (result.ec != std::errc()) {
+            return fail("Invalid number");
+        }
+        cursor = result.ptr;
+        value.valueType = JsonValue::Type::Number;
+        return true;
+    }
+
+    static void appendUtf8(std::string& text, unsigned codePoint) {
+        if (codePoint < 0x80) {
+            text += static_cast<char>(codePoint);
+        }
+        else if (codePoint < 0x800) {
+            text += static_cast<char>(0xC0 | (codePoint >> 6));
+            text += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else if (codePoint < 0x10000) {
+            text += static_cast<char>(0xE0 | (codePoint >> 12));
+            text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            text += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else {
+            text += static_cast<char>(0xF0 | (codePoint >> 18));
+            text += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            text += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    bool parseHex4(unsigned& value) {
+        if (end - cursor < 4) {
+            return fail("Truncated escape");
+        }
+        value = 0;
+        for (int i = 0; i < 4; ++i, ++cursor) {
+            char c = *cursor;
+            unsigned digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : 16;
+            if (digit > 15) {
+                return fail("Invalid escape");
+            }
+            value = value * 16 + digit;
+        }
+        return true;
+    }
+
+    bool parseString(std::string& text) {
+        ++cursor;  // Opening quote
+        text.clear();
+        while (cursor < end && *cursor != '"') {
+            // Copy runs without escapes in one go
+            const char* run = cursor;
+            while (cursor < end && *cursor != '"' && *cursor != '\\') {
+                ++cursor;
+            }
+            text.append(run, cursor);
+            if (cursor >= end || *cursor == '"') {
+                break;
+            }
+
+            ++cursor;  // Backslash
+            if (cursor >= end) {
+                return fail("Truncated escape");
+            }
+            char escape = *cursor++;
+            switch (escape) {
+            case '"': text += '"'; break;
+            case '\\': text += '\\'; break;
+            case '/': text += '/'; break;
+            case 'b': text += '\b'; break;
+            case 'f': text += '\f'; break;
+            case 'n': text += '\n'; break;
+            case 'r': text += '\r'; break;
+            case 't': text += '\t'; break;
+            case 'u': {
+                unsigned codePoint = 0;
+                if (!parseHex4(codePoint)) {
+                    return false;
+                }
+                // Surrogate pairs encode code points above the basic plane
+                if (codePoint >= 0xD800 && codePoint < 0xDC00 && end - cursor >= 2 && cursor[0] == '\\' && cursor[1] == 'u') {
+                    cursor += 2;
+                    unsigned low = 0;
+                    if (!parseHex4(low)) {
+                        return false;
+                    }
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                }
+                appendUtf8(text, codePoint);
+                break;
+            }
+            default:
+                return fail("Invalid escape");
+            }
+        }
+        if (cursor >= end) {
+            return fail("Unterminated string");
+        }
+        ++cursor;  // Closing quote
+        return true;
+    }
+
+    bool parseArray(JsonValue& value, int depth) {
+        value.valueType = JsonValue::Type::Array;
+        ++cursor;
+        skipWhitespace();
+        if (cursor < end && *cursor == ']') {
+            ++cursor;
+            return true;
+        }
+        while (true) {
+            value.elements.emplace_back();
+            if (!parseValue(value.elements.back(), depth + 1)) {
+                return false;
+            }
+            skipWhitespace();
+            if (cursor < end && *cursor == ',') {
+                ++cursor;
+                continue;
+            }
+            if (cursor < end && *cursor == ']') {
+                ++cursor;
+                return true;
+            }
+            return fail("Expected ',' or ']'");
+        }
+    }
+
+    bool parseObject(JsonValue& value, int depth) {
+        value.valueType = JsonValue::Type::Object;
+        ++cursor;
+        skipWhitespace();
+        if (cursor < end && *cursor == '}') {
+            ++cursor;
+            return true;
+        }
+        while (true) {
+            skipWhitespace();
+            if (cursor >= end || *cursor != '"') {
+                return fail("Expected a member name");
+            }
+            value.members.emplace_back();
+            if (!parseString(value.members.back().first)) {
+                return false;
+            }
+            skipWhitespace();
+            if (cursor >= end || *cursor != ':') {
+                return fail("Expected ':'");
+            }
+            ++cursor;
+            if (!parseValue(value.members.back().second, depth + 1)) {
+                return false;
+            }
+            skipWhitespace();
+            if (cursor < end && *cursor == ',') {
+                ++cursor;
+                continue;
+            }
+            if (cursor < end && *cursor == '}') {
+                ++cursor;
+                return true;
+            }
+            return fail("Expected ',' or '}'");
+        }
+    }
+};
+
+bool JsonValue::parse(const char* begin, const char* end, JsonValue& value, std::string& error) {
+    value = JsonValue();
+    JsonParser parser(begin, end);
+    return parser.parseDocument(value, error);
+}
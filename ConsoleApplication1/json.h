@@ -0,0 +1,55 @@
+#pragma once
+#ifndef JSON_H
+#define JSON_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal JSON document, enough for glTF headers. Lookups never throw: a missing key or index
+// yields a shared null value, and the as*() accessors fall back to the given default.
+class JsonValue {
+public:
+    enum class Type {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object,
+    };
+
+    // Parses [begin, end) into value; on failure returns false and describes the problem in error
+    static bool parse(const char* begin, const char* end, JsonValue& value, std::string& error);
+
+    Type type() const { return valueType; }
+    bool isNull() const { return valueType == Type::Null; }
+    bool isNumber() const { return valueType == Type::Number; }
+    bool isString() const { return valueType == Type::String; }
+    bool isArray() const { return valueType == Type::Array; }
+    bool isObject() const { return valueType == Type::Object; }
+
+    bool asBool(bool fallback = false) const { return valueType == Type::Bool ? boolValue : fallback; }
+    double asNumber(double fallback = 0.0) const { return valueType == Type::Number ? numberValue : fallback; }
+    int asInt(int fallback = 0) const { return valueType == Type::Number ? static_cast<int>(numberValue) : fallback; }
+    const std::string& asString() const { return stringValue; }
+
+    // Elements of an array, or members of an object
+    size_t size() const { return valueType == Type::Object ? members.size() : elements.size(); }
+    const JsonValue& operator[](size_t index) const;
+    const JsonValue& operator[](const char* key) const;
+    bool has(const char* key) const;
+
+private:
+    Type valueType = Type::Null;
+    bool boolValue = false;
+    double numberValue = 0.0;
+    std::string stringValue;
+    std::vector<JsonValue> elements;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    friend class JsonParser;
+};
+
+#endif // JSON_H
@@ -0,0 +1,159 @@
+#include "load_benchmark.h"
+#include "mesh_processing.h"
+#include "obj_parser.h"
+#include "thread_pool.h"
+#include "vertex_dedup.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+template <typename Function>
+static double timeMilliseconds(Function function) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    function();
+    auto endTime = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
+
+static bool loadShapes(const std::string& objFilename, tinyobj::attrib_t& attrib, std::vector<tinyobj::shape_t>& shapes) {
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
+    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, objFilename.c_str())) {
+        std::cerr << "Failed to load model: " << objFilename << (err.empty() ? "" : ": ") << err << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 1, 2, 4 and one worker per hardware thread, without repeats
+static std::vector<size_t> workerCounts() {
+    std::vector<size_t> counts = { 1, 2, 4 };
+    size_t hardwareThreads = std::thread::hardware_concurrency();
+    if (hardwareThreads != 0 && std::find(counts.begin(), counts.end(), hardwareThreads) == counts.end()) {
+        counts.push_back(hardwareThreads);
+    }
+    std::sort(counts.begin(), counts.end());
+    return counts;
+}
+
+static bool sameMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+    const std::vector<Vertex>& referenceVertices, const std::vector<uint32_t>& referenceIndices) {
+    return vertices.size() == referenceVertices.size() &&
+        std::equal(vertices.begin(), vertices.end(), referenceVertices.begin(), VertexDeduplicator::sameBits) &&
+        indices == referenceIndices;
+}
+
+bool LoadBenchmark::dedup(const std::string& objFilename) {
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    if (!loadShapes(objFilename, attrib, shapes) || !MeshProcessor::buildVertices(attrib, shapes, vertices, indices)) {
+        return false;
+    }
+    std::vector<Vertex> corners(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        corners[i] = vertices[indices[i]];
+    }
+    // Sized as the loader sizes it: unique vertices are usually close to the largest attribute array
+    size_t expectedVertices = std::min(corners.size(),
+        std::max({ attrib.vertices.size() / 3, attrib.normals.size() / 3, attrib.texcoords.size() / 2 }));
+
+    const int rounds = 3;
+    std::vector<Vertex> oldVertices, newVertices;
+    std::vector<uint32_t> oldIndices, newIndices;
+    double oldMilliseconds = timeMilliseconds([&]() {
+        for (int round = 0; round < rounds; ++round) {
+            oldVertices.clear();
+            oldIndices.clear();
+            std::unordered_map<std::string, uint32_t> uniqueVertices;
+            uniqueVertices.reserve(expectedVertices);
+            oldVertices.reserve(expectedVertices);
+            oldIndices.reserve(corners.size());
+            for (const Vertex& vertex : corners) {
+                std::string vertexKey(reinterpret_cast<const char*>(&vertex), sizeof(Vertex));
+                auto inserted = uniqueVertices.emplace(std::move(vertexKey), static_cast<uint32_t>(oldVertices.size()));
+                if (inserted.second) {
+                    oldVertices.push_back(vertex);
+                }
+                oldIndices.push_back(inserted.first->second);
+            }
+        }
+    }) / rounds;
+    double newMilliseconds = timeMilliseconds([&]() {
+        for (int round = 0; round < rounds; ++round) {
+            newVertices.clear();
+            newIndices.clear();
+            VertexDeduplicator uniqueVertices;
+            uniqueVertices.reserve(expectedVertices);
+            newVertices.reserve(expectedVertices);
+            newIndices.reserve(corners.size());
+            for (const Vertex& vertex : corners) {
+                newIndices.push_back(uniqueVertices.insert(vertex, newVertices));
+            }
+        }
+    }) / rounds;
+
+    bool same = sameMesh(oldVertices, oldIndices, newVertices, newIndices);
+    std::cout << corners.size() << " corners into " << newVertices.size() << " vertices: string keys " << oldMilliseconds << " ms, "
+        << "open addressing " << newMilliseconds << " ms, " << oldMilliseconds / newMilliseconds << "x, outputs "
+        << (same ? "match" : "DIFFER") << std::endl;
+    return same;
+}
+
+bool LoadBenchmark::threadScaling(const std::string& objFilename) {
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    if (!loadShapes(objFilename, attrib, shapes)) {
+        return false;
+    }
+
+    std::vector<Vertex> serialVertices;
+    std::vector<uint32_t> serialIndices;
+    bool built = true;
+    double serialMilliseconds = timeMilliseconds([&]() {
+        built = MeshProcessor::buildVertices(attrib, shapes, serialVertices, serialIndices);
+    });
+    if (!built) {
+        return false;
+    }
+    std::cout << "vertex build: serial " << serialMilliseconds << " ms, " << serialIndices.size() << " corners into "
+        << serialVertices.size() << " vertices" << std::endl;
+
+    bool allMatch = true;
+    for (size_t workers : workerCounts()) {
+        ThreadPool pool(workers);
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        double milliseconds = timeMilliseconds([&]() {
+            MeshProcessor::buildVerticesParallel(attrib, shapes, vertices, indices, pool);
+        });
+        bool same = sameMesh(vertices, indices, serialVertices, serialIndices);
+        allMatch = allMatch && same;
+        std::cout << "  " << workers << " workers: " << milliseconds << " ms, " << serialMilliseconds / milliseconds << "x, output "
+            << (same ? "matches" : "DIFFERS") << std::endl;
+    }
+
+    MeshData serialMesh;
+    ObjParser::Stats serialStats;
+    if (!ObjParser::load(objFilename, std::string(), serialMesh, &serialStats)) {
+        return false;
+    }
+    std::cout << "OBJ parse: serial " << serialStats.milliseconds << " ms" << std::endl;
+    for (size_t workers : workerCounts()) {
+        ThreadPool pool(workers);
+        MeshData mesh;
+        ObjParser::Stats stats;
+        if (!ObjParser::load(objFilename, std::string(), mesh, &stats, &pool)) {
+            return false;
+        }
+        bool same = sameMesh(mesh.vertices, mesh.indices, serialMesh.vertices, serialMesh.indices);
+        allMatch = allMatch && same;
+        std::cout << "  " << workers << " workers: " << stats.milliseconds << " ms in " << stats.chunks << " slices, "
+            << serialStats.milliseconds / stats.milliseconds << "x, output " << (same ? "matches" : "DIFFERS") << std::endl;
+    }
+    return allMatch;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#ifndef LOAD_BENCHMARK_H
+#define LOAD_BENCHMARK_H
+
+#include <string>
+
+// Timings for the stages of an OBJ load. Nothing here touches GL, so the game can run them at startup
+// and the asset cooker from its command line. Each prints its results and returns false when the file
+// does not load or the methods compared do not produce the same output.
+class LoadBenchmark {
+public:
+    // Deduplicates the corners of an OBJ with a string-keyed std::unordered_map, as model loading did
+    // before VertexDeduplicator, and with VertexDeduplicator. The string holds the raw bytes of the
+    // vertex, so both compare exact bit patterns and must give the same vertices and indices.
+    static bool dedup(const std::string& objFilename);
+
+    // Builds the vertices of an OBJ serially and then in parallel on 1, 2, 4 and one worker per hardware
+    // thread, reporting each time and its speedup over the serial build. The sliced ObjParser is timed
+    // the same way against a serial parse.
+    static bool threadScaling(const std::string& objFilename);
+};
+
+#endif // LOAD_BENCHMARK_H
@@ -0,0 +1,65 @@
+#include "lod_selector.h"
+#include <algorithm>
+#include <cmath>
+
+// Closest the camera is treated as being, so errors stay finite inside the bounding sphere
+static const float MIN_LOD_DISTANCE = 0.1f;
+
+LodSelector::LodSelector(float verticalFovDegrees, float viewportHeight, float pixelThreshold, float hysteresis)
+    : pixelsPerUnitAtUnitDistance(0.0f), pixelThreshold(pixelThreshold), hysteresis(hysteresis) {
+    setProjection(verticalFovDegrees, viewportHeight);
+}
+
+void LodSelector::setProjection(float verticalFovDegrees, float viewportHeight) {
+    // A length of 1 at distance 1 covers viewportHeight / (2 tan(fov / 2)) pixels
+    float halfFov = verticalFovDegrees * 0.5f * 3.14159265f / 180.0f;
+    pixelsPerUnitAtUnitDistance = viewportHeight / (2.0f * std::tan(halfFov));
+}
+
+float LodSelector::projectedPixels(float worldSize, float distance) const {
+    return worldSize * pixelsPerUnitAtUnitDistance / std::max(distance, MIN_LOD_DISTANCE);
+}
+
+size_t LodSelector::select(const MeshData& mesh, const glm::vec3& center, float radius, float errorScale, const glm::vec3& cameraPosition,
+    size_t previousLevel) const {
+    if (mesh.lods.size() < 2) {
+        return 0;
+    }
+
+    // Nearest point of the sphere, so the error is never underestimated
+    float distance = glm::length(center - cameraPosition) - radius;
+    float scale = errorScale * pixelsPerUnitAtUnitDistance / std::max(distance, MIN_LOD_DISTANCE);
+    previousLevel = std::min(previousLevel, mesh.lods.size() - 1);
+
+    auto coarsestUnder = [&](float threshold) {
+        size_t level = 0;
+        for (size_t i = 1; i < mesh.lods.size(); ++i) {
+            if (mesh.lods[i].error * scale <= threshold) {
+                level = i;
+            }
+        }
+        return level;
+    };
+
+    size_t level = coarsestUnder(pixelThreshold);
+    if (level > previousLevel) {
+        // Going coarser: the new level must be comfortably under the threshold
+        level = std::max(previousLevel, coarsestUnder(pixelThreshold * (1.0f - hysteresis)));
+    }
+    else if (level < previousLevel && mesh.lods[previousLevel].error * scale <= pixelThreshold * (1.0f + hysteresis)) {
+        // Going finer: keep the current level until it is clearly over the threshold
+        level = previousLevel;
+    }
+    return level;
+}
+
+void LodSelector::beginFrame() {
+    previousFrame = currentFrame;
+    currentFrame = FrameStats();
+}
+
+void LodSelector::recordDraw(size_t trianglesSubmitted, size_t trianglesAvailable) {
+    ++currentFrame.draws;
+    currentFrame.trianglesSubmitted += trianglesSubmitted;
+    currentFrame.trianglesAvailable += trianglesAvailable;
+}
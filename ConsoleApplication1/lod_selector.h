@@ -0,0 +1,48 @@
+#pragma once
+#ifndef LOD_SELECTOR_H
+#define LOD_SELECTOR_H
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include "mesh_data.h"
+
+// Chooses a level of detail per draw from the screen-space size of each level's geometric error.
+// The coarsest level whose error projects to at most pixelThreshold pixels is used; hysteresis widens
+// that threshold in the direction of the level already on screen, so models near a switching distance
+// do not pop back and forth.
+class LodSelector {
+public:
+    struct FrameStats {
+        size_t draws = 0;
+        size_t trianglesSubmitted = 0;
+        size_t trianglesAvailable = 0;  // What full detail would have cost
+    };
+
+    LodSelector(float verticalFovDegrees, float viewportHeight, float pixelThreshold = 1.0f, float hysteresis = 0.25f);
+
+    void setProjection(float verticalFovDegrees, float viewportHeight);
+    void setPixelThreshold(float pixels) { pixelThreshold = pixels; }
+
+    // Returns the level to draw. center/radius are the world-space bounding sphere; errorScale is the
+    // largest axis scale of the model matrix, which takes the object-space level errors to world space;
+    // previousLevel is the level this object used last frame.
+    size_t select(const MeshData& mesh, const glm::vec3& center, float radius, float errorScale, const glm::vec3& cameraPosition,
+        size_t previousLevel) const;
+
+    // Projected size in pixels of a world-space length at the given distance
+    float projectedPixels(float worldSize, float distance) const;
+
+    // Frame counters: call beginFrame once per frame, recordDraw for every model drawn
+    void beginFrame();
+    void recordDraw(size_t trianglesSubmitted, size_t trianglesAvailable);
+    const FrameStats& lastFrameStats() const { return previousFrame; }
+
+private:
+    float pixelsPerUnitAtUnitDistance;
+    float pixelThreshold;
+    float hysteresis;
+    FrameStats currentFrame;
+    FrameStats previousFrame;
+};
+
+#endif // LOD_SELECTOR_H
@@ -2,6 +2,8 @@
 #include <GL/glew.h>        
 #include <GLFW/glfw3.h>     
 #include <iostream>         
+#include <algorithm>
+#include <vector>
 #include <chrono>          
 #include <sstream>         
 #include <thread>          
@@ -14,9 +16,18 @@
 #include "movement.h"      
 #include "globals.h"       
 #include "cursor.h"        
+#include "character_controller.h"
 #include "crosshair.h"
+#include "geometry_pool.h"
+#include "instance_buffer.h"
+#include "instancing_benchmark.h"
 #include "lights.h"
+#include "load_benchmark.h"
+#include "lod_selector.h"
+#include "model_loader.h"
 #include "models.h"
+#include "scene_bvh.h"
+#include "scene_picker.h"
 #include "shaders.h"
 
 // Global window handle
@@ -30,17 +41,61 @@ float lastTime = 0.0f;
 int frameCount = 0;
 float fps = 0.0f;
 
+// Vertical field of view, shared by the projection and LOD selection
+const float FIELD_OF_VIEW = 90.0f;
+const float NEAR_CLIP = 0.1f;
+const float FAR_CLIP = 100.0f;
+
+// World bounds of the fixed scenery, for culling; keep in step with drawFloor and drawWall in the renderer.
+// The wall's last argument picks the axis it runs along, so its box covers both.
+const glm::vec3 FLOOR_BOUNDS_MIN(-50.0f, -0.01f, -50.0f);
+const glm::vec3 FLOOR_BOUNDS_MAX(50.0f, 0.01f, 50.0f);
+const glm::vec3 WALL_BOUNDS_MIN(0.0f, 0.0f, 0.0f);
+const glm::vec3 WALL_BOUNDS_MAX(10.0f, 5.0f, 10.0f);
+// The wall's surface for collision and picking; drawWall's true runs it along X from its start
+const glm::vec3 WALL_START(0.0f, 0.0f, 0.0f);
+const glm::vec3 WALL_END(10.0f, 5.0f, 0.0f);
+
+// How far the crosshair can pick
+const float PICK_DISTANCE = 50.0f;
+
+// Time vertex dedup and the parallel load paths on this OBJ at startup, before the window opens
+const bool RUN_LOAD_BENCHMARKS = false;
+const char* const LOAD_BENCHMARK_MODEL = "C:/Users/ricar/Documents/Models/Basic Temple.obj";
+
+// Compare 10k individual model draws against one instanced draw once the model has loaded
+const bool RUN_INSTANCING_BENCHMARK = false;
+
 GLuint shaderProgram; // Your shader program ID
 Model myModel; // Instance of your Model class
+LodSelector lodSelector(FIELD_OF_VIEW, static_cast<float>(HEIGHT)); // Picks model detail from projected error
+SceneBvh sceneBvh; // Bounds of everything drawn in the world, for culling and queries
+ScenePicker scenePicker(sceneBvh); // Ray casts against sceneBvh and the model's triangles
+CharacterController characterController(sceneBvh); // Keeps the player out of the floor, the wall and the model
+MeshData floorMesh, wallMesh; // Collision and picking surfaces of the fixed scenery
+
+// Two triangles over the corners in order, with a hit-test hierarchy, for flat scenery
+static void buildQuadMesh(MeshData& mesh, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d) {
+    mesh.clear();
+    glm::vec3 normal = glm::normalize(glm::cross(b - a, c - a));
+    for (const glm::vec3& corner : { a, b, c, d }) {
+        mesh.vertices.push_back({ corner, normal, glm::vec2(0.0f) });
+    }
+    mesh.indices = { 0, 1, 2, 0, 2, 3 };
+    mesh.computeBounds();
+    TriangleBvh::build(mesh, nullptr);
+}
 
 void displayFPS(float fps) {
-    std::cout << "FPS: " << fps << std::endl;
+    const LodSelector::FrameStats& lodStats = lodSelector.lastFrameStats();
+    std::cout << "FPS: " << fps << " | Triangles: " << lodStats.trianglesSubmitted << " / "
+        << lodStats.trianglesAvailable << " in " << lodStats.draws << " draws" << std::endl;
 }
 
 void setupProjection() {
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
-    gluPerspective(90.0f, static_cast<float>(WIDTH) / static_cast<float>(HEIGHT), 0.1f, 100.0f);
+    gluPerspective(FIELD_OF_VIEW, static_cast<float>(WIDTH) / static_cast<float>(HEIGHT), NEAR_CLIP, FAR_CLIP);
     glMatrixMode(GL_MODELVIEW);
 }
 
@@ -52,6 +107,11 @@ void renderText(const std::string& text, float x, float y) {
 }
 
 int main() {
+    if (RUN_LOAD_BENCHMARKS) {
+        LoadBenchmark::dedup(LOAD_BENCHMARK_MODEL);
+        LoadBenchmark::threadScaling(LOAD_BENCHMARK_MODEL);
+    }
+
     // Initialize GLFW
     if (!glfwInit()) {
         std::cerr << "Error initializing GLFW\n";
@@ -99,11 +159,34 @@ int main() {
     GLuint floorTextureID = loadTexture("C:/Users/ricar/Documents/floor2.png");
     GLuint wallTextureID = loadTexture("C:/Users/ricar/Documents/wall1.jpg");
 
-    // Create and load the model
-    //if (!myModel.loadFromFile("C:/Users/ricar/Documents/Models/Basic Temple.obj", "C:/Users/ricar/Documents/Models/Basic Temple.mtl")) {
-        //std::cerr << "Failed to load model" << std::endl;
-        //return -1;
-    //}
+    // Create the model and load it in the background; the game loop keeps running while it streams in
+    ModelLoader modelLoader;
+    ModelLoader::Handle modelLoad;
+    bool modelReported = false;
+    myModel.setVertexFormat(VertexFormat::Compact16);
+    //modelLoad = modelLoader.load(myModel, "C:/Users/ricar/Documents/Models/Basic Temple.obj", "C:/Users/ricar/Documents/Models/Basic Temple.mtl");
+
+    // Scene objects; the static scenery is built once, the model joins when it has loaded and follows its matrix
+    const uint32_t floorObject = 0;
+    const uint32_t wallObject = 1;
+    const uint32_t modelObject = 2;
+    const SceneBvh::Item scenery[] = {
+        { floorObject, FLOOR_BOUNDS_MIN, FLOOR_BOUNDS_MAX },
+        { wallObject, WALL_BOUNDS_MIN, WALL_BOUNDS_MAX },
+    };
+    sceneBvh.build(scenery, 2);
+    buildQuadMesh(floorMesh, glm::vec3(FLOOR_BOUNDS_MIN.x, 0.0f, FLOOR_BOUNDS_MIN.z), glm::vec3(FLOOR_BOUNDS_MIN.x, 0.0f, FLOOR_BOUNDS_MAX.z),
+        glm::vec3(FLOOR_BOUNDS_MAX.x, 0.0f, FLOOR_BOUNDS_MAX.z), glm::vec3(FLOOR_BOUNDS_MAX.x, 0.0f, FLOOR_BOUNDS_MIN.z));
+    buildQuadMesh(wallMesh, WALL_START, glm::vec3(WALL_START.x, WALL_END.y, WALL_START.z), WALL_END, glm::vec3(WALL_END.x, WALL_START.y, WALL_END.z));
+    scenePicker.setObjectMesh(floorObject, floorMesh, glm::mat4(1.0f));
+    scenePicker.setObjectMesh(wallObject, wallMesh, glm::mat4(1.0f));
+    characterController.setObjectMesh(floorObject, floorMesh, glm::mat4(1.0f));
+    characterController.setObjectMesh(wallObject, wallMesh, glm::mat4(1.0f));
+    std::vector<uint32_t> visibleObjects;
+    glm::mat4 modelPlacement(1.0f);  // Model matrix the scene queries last saw
+    bool modelPlaced = false;
+    const glm::mat4 projectionMatrix = glm::perspective(glm::radians(FIELD_OF_VIEW), static_cast<float>(WIDTH) / static_cast<float>(HEIGHT),
+        NEAR_CLIP, FAR_CLIP);
 
     auto lastFrameTimePoint = std::chrono::high_resolution_clock::now();
     while (!glfwWindowShouldClose(window)) {
@@ -113,8 +196,39 @@ int main() {
         float deltaTime = currentFrame - lastFrameTime;
         lastFrameTime = currentFrame;
 
+        // Finish loads within this frame's upload budget
+        modelLoader.update();
+        if (modelLoad.failed()) {
+            std::cerr << "Failed to load model" << std::endl;
+            modelLoad = ModelLoader::Handle();
+        }
+        else if (modelLoad.ready() && !modelReported) {
+            const Model::MemoryStats& modelMemory = Model::getMemoryTotals();
+            std::cout << "Model buffers: vertices " << modelMemory.vertexBytes / 1024 << " KB, indices " << modelMemory.indexBytes / 1024
+                << " KB (" << modelMemory.indexBytes32 / 1024 << " KB as 32-bit)" << std::endl;
+            // Fragmentation is the share of free space outside the largest free block
+            GeometryPool::Stats poolStats = GeometryPool::shared().stats();
+            static const char* streamNames[] = { "float", "compact16", "compact12", "position" };
+            for (size_t stream = 0; stream < GeometryPool::STREAM_COUNT; ++stream) {
+                const FreeListAllocator::Stats& vertices = poolStats.vertices[stream];
+                if (vertices.capacity != 0) {
+                    std::cout << "Geometry pool " << streamNames[stream] << " vertices: " << vertices.used << " / " << vertices.capacity
+                        << " in " << vertices.allocations << " ranges, " << vertices.freeBlocks << " free blocks, "
+                        << vertices.fragmentation() * 100.0 << "% fragmented" << std::endl;
+                }
+            }
+            std::cout << "Geometry pool indices: " << poolStats.indices.used / 1024 << " / " << poolStats.indices.capacity / 1024
+                << " KB in " << poolStats.indices.allocations << " ranges, " << poolStats.indices.freeBlocks << " free blocks, "
+                << poolStats.indices.fragmentation() * 100.0 << "% fragmented" << std::endl;
+            if (RUN_INSTANCING_BENCHMARK) {
+                InstancingBenchmark::print(InstancingBenchmark::run(myModel, shaderProgram));
+            }
+            modelReported = true;
+        }
+
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glLoadIdentity();
+        lodSelector.beginFrame();
 
         // Set up camera view
         glm::vec3 cameraPosition(characterPosX, characterPosY + 1.5f, characterPosZ);
@@ -123,17 +237,41 @@ int main() {
             cameraTarget.x, cameraTarget.y, cameraTarget.z,
             0.0f, 1.0f, 0.0f);
 
+        // Same view as the fixed-function matrices, for culling
+        glm::mat4 viewMatrix = glm::lookAt(cameraPosition, cameraTarget, glm::vec3(0.0f, 1.0f, 0.0f));
+        Frustum viewFrustum = Frustum::fromMatrix(projectionMatrix * viewMatrix);
+        // The queries cache the inverse matrix, so they are only told when the model moves
+        if (myModel.isLoaded() && (!modelPlaced || myModel.getModelMatrix() != modelPlacement)) {
+            glm::vec3 boxMin, boxMax;
+            myModel.getWorldBounds(boxMin, boxMax);
+            sceneBvh.update(modelObject, boxMin, boxMax);
+            scenePicker.setObjectMesh(modelObject, myModel.getMeshData(), myModel.getModelMatrix());
+            characterController.setObjectMesh(modelObject, myModel.getMeshData(), myModel.getModelMatrix());
+            modelPlacement = myModel.getModelMatrix();
+            modelPlaced = true;
+        }
+        sceneBvh.queryFrustum(viewFrustum, visibleObjects);
+        auto isVisible = [&](uint32_t object) { return std::find(visibleObjects.begin(), visibleObjects.end(), object) != visibleObjects.end(); };
+
+        // The crosshair sits at the screen centre, so it points straight along the camera
+        ScenePicker::Hit target;
+        scenePicker.pick({ cameraPosition, cameraFront, PICK_DISTANCE }, target);
+
         // Draw floor
-        drawFloor(floorTextureID);
+        if (isVisible(floorObject)) {
+            drawFloor(floorTextureID);
+        }
 
         // Draw wall (as before)
-        drawWall(wallTextureID, 0.0f, 0.0f, 10.0f, 5.0f, true);
+        if (isVisible(wallObject)) {
+            drawWall(wallTextureID, 0.0f, 0.0f, 10.0f, 5.0f, true);
+        }
 
         glColor3f(1.0f, 1.0f, 1.0f);
 
 
         // Draw the loaded model
-        //myModel.draw(shaderProgram); // Render the model using the shader program
+        //if (myModel.isLoaded() && isVisible(modelObject)) myModel.draw(shaderProgram, lodSelector, cameraPosition, &viewFrustum); // Render the model at the detail its screen size needs
 
         // 2D overlay rendering
         glDisable(GL_DEPTH_TEST);
@@ -146,7 +284,7 @@ int main() {
         glPushMatrix();
         glLoadIdentity();
 
-        drawCrosshair(WIDTH, HEIGHT);
+        drawCrosshair(WIDTH, HEIGHT, target.isHit());
 
         glPopMatrix();
         glMatrixMode(GL_PROJECTION);
@@ -154,7 +292,13 @@ int main() {
         glMatrixMode(GL_MODELVIEW);
         glEnable(GL_DEPTH_TEST);
 
+        // Movement proposes where the player goes; the controller keeps the capsule out of the scenery
+        glm::vec3 feet(characterPosX, characterPosY, characterPosZ);
         updateMovement(deltaTime);
+        feet = characterController.move(feet, glm::vec3(characterPosX, characterPosY, characterPosZ) - feet, deltaTime);
+        characterPosX = feet.x;
+        characterPosY = feet.y;
+        characterPosZ = feet.z;
 
         // FPS calculation and display
         frameCount++;
@@ -168,6 +312,11 @@ int main() {
         std::ostringstream fpsStream;
         fpsStream << "FPS: " << fps;
         renderText(fpsStream.str(), -0.9f, 0.9f);
+        if (target.isHit()) {
+            std::ostringstream targetStream;
+            targetStream << "Target: object " << target.object << " at " << target.distance;
+            renderText(targetStream.str(), -0.9f, 0.85f);
+        }
 
         glfwSwapBuffers(window);
         glfwPollEvents();
@@ -181,6 +330,10 @@ int main() {
         }
     }
 
+    // Globals are destroyed after the context, so their GL resources go now
+    myModel.cleanup();
+    GeometryPool::shared().release();
+    InstanceBuffer::shared().release();
     glfwTerminate();
     return 0;
 }
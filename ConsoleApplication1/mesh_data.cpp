@@ -0,0 +1,65 @@
+#include "mesh_data.h"
+#include <algorithm>
+#include <cmath>
+
+bool Material::sameLook(const Material& other) const {
+    return ambient == other.ambient && diffuse == other.diffuse && specular == other.specular && emission == other.emission
+        && shininess == other.shininess && dissolve == other.dissolve && diffuseTexture == other.diffuseTexture;
+}
+
+void MeshData::clear() {
+    vertices.clear();
+    indices.clear();
+    submeshes.clear();
+    lods.clear();
+    materials.clear();
+    meshlets.clear();
+    meshletOffsets.clear();
+    bvhNodes.clear();
+    bvhPackets.clear();
+    boundsMin = glm::vec3(0.0f);
+    boundsMax = glm::vec3(0.0f);
+    sphereCenter = glm::vec3(0.0f);
+    sphereRadius = 0.0f;
+}
+
+void MeshData::computeBounds() {
+    if (vertices.empty()) {
+        boundsMin = glm::vec3(0.0f);
+        boundsMax = glm::vec3(0.0f);
+        sphereCenter = glm::vec3(0.0f);
+        sphereRadius = 0.0f;
+        return;
+    }
+
+    boundsMin = vertices[0].position;
+    boundsMax = vertices[0].position;
+    for (const Vertex& vertex : vertices) {
+        boundsMin = glm::min(boundsMin, vertex.position);
+        boundsMax = glm::max(boundsMax, vertex.position);
+    }
+
+    // Farthest vertex from the box centre; tighter than half the diagonal for most shapes
+    sphereCenter = (boundsMin + boundsMax) * 0.5f;
+    float radiusSquared = 0.0f;
+    for (const Vertex& vertex : vertices) {
+        glm::vec3 offset = vertex.position - sphereCenter;
+        radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+    }
+    sphereRadius = std::sqrt(radiusSquared);
+}
+
+void MeshData::ensureBaseLod() {
+    if (lods.empty()) {
+        lods.push_back({ 0, static_cast<uint32_t>(submeshes.size()), 0.0f });
+    }
+}
+
+size_t MeshData::lodIndexCount(size_t level) const {
+    size_t count = 0;
+    const MeshLod& lod = lods[level];
+    for (uint32_t i = 0; i < lod.submeshCount; ++i) {
+        count += submeshes[lod.firstSubmesh + i].indexCount;
+    }
+    return count;
+}
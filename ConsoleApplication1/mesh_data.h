@@ -0,0 +1,94 @@
+#pragma once
+#ifndef MESH_DATA_H
+#define MESH_DATA_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "vertex.h"
+
+// Contiguous range of the index buffer drawn with one material
+struct Submesh {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t materialId;  // -1 when the range has no material
+};
+
+// Surface appearance from an MTL file
+struct Material {
+    std::string name;
+    glm::vec3 ambient{ 0.2f };
+    glm::vec3 diffuse{ 0.8f };
+    glm::vec3 specular{ 0.0f };
+    glm::vec3 emission{ 0.0f };
+    float shininess = 0.0f;
+    float dissolve = 1.0f;       // Opacity
+    std::string diffuseTexture;  // As written in the MTL, relative to its directory; empty when untextured
+
+    // Same appearance; names are ignored so duplicated MTL entries collapse
+    bool sameLook(const Material& other) const;
+};
+
+// One level of detail: a run of entries in MeshData::submeshes. All levels share the vertex array,
+// and each level's index ranges are appended after the previous level's.
+struct MeshLod {
+    uint32_t firstSubmesh;
+    uint32_t submeshCount;
+    float error;  // Geometric error versus the base mesh, in object-space units (0 for the base)
+};
+
+// A small cluster of consecutive triangles in the index buffer with bounds for culling
+struct Meshlet {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float center[3];     // Bounding sphere, object space
+    float radius;
+    float coneAxis[3];   // Average facing direction of the triangles
+    float coneCutoff;    // sin of the cone's half angle; 1 when the cone is too wide to cull
+};
+
+// Node of a triangle BVH (see TriangleBvh). An internal node's children are adjacent, at first and
+// first + 1; a leaf owns packetCount packets starting at first.
+struct TriangleBvhNode {
+    float boundsMin[3];
+    uint32_t first;
+    float boundsMax[3];
+    uint32_t packetCount;  // 0 for internal nodes
+};
+
+// Up to four leaf triangles stored lane by lane for SIMD tests: one vertex and the two edges from it.
+// Unused lanes have zero edges and triangle UINT32_MAX.
+struct TrianglePacket {
+    float v0[3][4];
+    float edge1[3][4];
+    float edge2[3][4];
+    uint32_t triangle[4];  // Base-level triangle: index of its first index / 3
+};
+
+// CPU-side mesh as produced by processing and stored in cooked files
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<Submesh> submeshes;  // All levels of detail, base level first
+    std::vector<MeshLod> lods;       // lods[0] is the full-detail mesh
+    std::vector<Material> materials; // Indexed by Submesh::materialId
+    std::vector<Meshlet> meshlets;   // Culling clusters, grouped by submesh
+    std::vector<uint32_t> meshletOffsets;  // Submesh i owns meshlets [meshletOffsets[i], meshletOffsets[i + 1])
+    std::vector<TriangleBvhNode> bvhNodes;    // Hit-test hierarchy over the base level, root first; optional
+    std::vector<TrianglePacket> bvhPackets;
+    glm::vec3 boundsMin{ 0.0f };
+    glm::vec3 boundsMax{ 0.0f };
+    glm::vec3 sphereCenter{ 0.0f };  // Bounding sphere, centred on the box
+    float sphereRadius = 0.0f;
+
+    void clear();
+    // Box and sphere from the vertex positions
+    void computeBounds();
+
+    // Makes lods[0] cover every submesh when no chain has been built
+    void ensureBaseLod();
+    size_t lodIndexCount(size_t level) const;
+};
+
+#endif // MESH_DATA_H
@@ -0,0 +1,409 @@
+#include "mesh_file.h"
+#include "triangle_bvh.h"
+#include "vertex_layout.h"
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const char MESH_FILE_MAGIC[4] = { 'O', 'G', 'L', 'M' };
+
+static uint64_t alignUp(uint64_t value) {
+    return (value + MESH_FILE_ALIGNMENT - 1) & ~static_cast<uint64_t>(MESH_FILE_ALIGNMENT - 1);
+}
+
+std::vector<MeshFileAttribute> MeshFile::vertexAttributes() {
+    return ::vertexAttributes<Vertex>();
+}
+
+bool MeshFile::write(const std::string& filename, const MeshData& mesh) {
+    std::vector<MeshFileAttribute> attributes = vertexAttributes();
+    float sphere[4] = { mesh.sphereCenter.x, mesh.sphereCenter.y, mesh.sphereCenter.z, mesh.sphereRadius };
+    std::vector<uint8_t> indices;
+    IndexLayout layout = IndexPacker::pack(mesh.indices.data(), mesh.indices.size(), mesh.submeshes, indices);
+
+    struct Payload {
+        uint32_t type;
+        const void* data;
+        uint64_t size;
+    };
+    std::vector<Payload> payloads = {
+        { MESH_SECTION_ATTRIBUTES, attributes.data(), attributes.size() * sizeof(MeshFileAttribute) },
+        { MESH_SECTION_VERTICES, mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex) },
+        { MESH_SECTION_INDICES, indices.data(), indices.size() },
+        { MESH_SECTION_SUBMESHES, mesh.submeshes.data(), mesh.submeshes.size() * sizeof(Submesh) },
+        { MESH_SECTION_BASE_VERTICES, layout.baseVertices.data(), layout.baseVertices.size() * sizeof(int32_t) },
+        { MESH_SECTION_LODS, mesh.lods.data(), mesh.lods.size() * sizeof(MeshLod) },
+        { MESH_SECTION_SPHERE, sphere, sizeof(sphere) },
+    };
+    std::vector<MeshFileMaterial> materials;
+    std::string strings;
+    for (const Material& material : mesh.materials) {
+        MeshFileMaterial record{};
+        for (int i = 0; i < 3; ++i) {
+            record.ambient[i] = material.ambient[i];
+            record.diffuse[i] = material.diffuse[i];
+            record.specular[i] = material.specular[i];
+            record.emission[i] = material.emission[i];
+        }
+        record.shininess = material.shininess;
+        record.dissolve = material.dissolve;
+        record.nameOffset = static_cast<uint32_t>(strings.size());
+        record.nameLength = static_cast<uint32_t>(material.name.size());
+        strings += material.name;
+        record.textureOffset = static_cast<uint32_t>(strings.size());
+        record.textureLength = static_cast<uint32_t>(material.diffuseTexture.size());
+        strings += material.diffuseTexture;
+        materials.push_back(record);
+    }
+    if (!materials.empty()) {
+        payloads.push_back({ MESH_SECTION_MATERIALS, materials.data(), materials.size() * sizeof(MeshFileMaterial) });
+        payloads.push_back({ MESH_SECTION_STRINGS, strings.data(), strings.size() });
+    }
+    if (!mesh.meshlets.empty() && mesh.meshletOffsets.size() == mesh.submeshes.size() + 1) {
+        payloads.push_back({ MESH_SECTION_MESHLETS, mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet) });
+        payloads.push_back({ MESH_SECTION_MESHLET_OFFSETS, mesh.meshletOffsets.data(), mesh.meshletOffsets.size() * sizeof(uint32_t) });
+    }
+    if (!mesh.bvhNodes.empty()) {
+        payloads.push_back({ MESH_SECTION_BVH_NODES, mesh.bvhNodes.data(), mesh.bvhNodes.size() * sizeof(TriangleBvhNode) });
+        payloads.push_back({ MESH_SECTION_BVH_PACKETS, mesh.bvhPackets.data(), mesh.bvhPackets.size() * sizeof(TrianglePacket) });
+    }
+
+    MeshFileHeader header{};
+    std::memcpy(header.magic, MESH_FILE_MAGIC, sizeof(header.magic));
+    header.version = MESH_FILE_VERSION;
+    header.sectionCount = static_cast<uint32_t>(payloads.size());
+    header.vertexStride = sizeof(Vertex);
+    header.indexSize = layout.indexSize;
+    header.vertexCount = mesh.vertices.size();
+    header.indexCount = mesh.indices.size();
+    for (int i = 0; i < 3; ++i) {
+        header.boundsMin[i] = mesh.boundsMin[i];
+        header.boundsMax[i] = mesh.boundsMax[i];
+    }
+
+    std::vector<MeshFileSection> sections(payloads.size());
+    uint64_t offset = alignUp(sizeof(MeshFileHeader) + sections.size() * sizeof(MeshFileSection));
+    for (size_t i = 0; i < payloads.size(); ++i) {
+        sections[i] = { payloads[i].type, 0, offset, payloads[i].size };
+        offset = alignUp(offset + payloads[i].size);
+    }
+
+    std::ofstream output(filename, std::ios::binary | std::ios::trunc);
+    if (!output) {
+        std::cerr << "Failed to create mesh file: " << filename << std::endl;
+        return false;
+    }
+
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char*>(sections.data()), sections.size() * sizeof(MeshFileSection));
+
+    static const char padding[MESH_FILE_ALIGNMENT] = {};
+    uint64_t written = sizeof(MeshFileHeader) + sections.size() * sizeof(MeshFileSection);
+    for (size_t i = 0; i < payloads.size(); ++i) {
+        output.write(padding, static_cast<std::streamsize>(sections[i].offset - written));
+        output.write(static_cast<const char*>(payloads[i].data), static_cast<std::streamsize>(payloads[i].size));
+        written = sections[i].offset + payloads[i].size;
+    }
+
+    if (!output) {
+        std::cerr << "Failed to write mesh file: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool MeshFile::open(const std::string& filename) {
+    close();
+
+    if (!file.open(filename)) {
+        return false;
+    }
+
+    if (file.size() < sizeof(MeshFileHeader)) {
+        std::cerr << "Mesh file too small: " << filename << std::endl;
+        close();
+        return false;
+    }
+
+    const MeshFileHeader* header = reinterpret_cast<const MeshFileHeader*>(file.data());
+    if (std::memcmp(header->magic, MESH_FILE_MAGIC, sizeof(header->magic)) != 0) {
+        std::cerr << "Not a cooked mesh file: " << filename << std::endl;
+        close();
+        return false;
+    }
+    if (header->version != MESH_FILE_VERSION) {
+        std::cerr << "Unsupported mesh file version " << header->version << ": " << filename << std::endl;
+        close();
+        return false;
+    }
+
+    uint64_t tableEnd = sizeof(MeshFileHeader) + static_cast<uint64_t>(header->sectionCount) * sizeof(MeshFileSection);
+    if (tableEnd > file.size()) {
+        std::cerr << "Corrupt section table in mesh file: " << filename << std::endl;
+        close();
+        return false;
+    }
+
+    const MeshFileSection* table = reinterpret_cast<const MeshFileSection*>(file.data() + sizeof(MeshFileHeader));
+    for (uint32_t i = 0; i < header->sectionCount; ++i) {
+        if (table[i].offset % MESH_FILE_ALIGNMENT != 0 || table[i].offset > file.size() ||
+            table[i].size > file.size() - table[i].offset) {
+            std::cerr << "Corrupt section in mesh file: " << filename << std::endl;
+            close();
+            return false;
+        }
+    }
+
+    fileHeader = header;
+    sections = table;
+
+    size_t vertexBytes = 0;
+    size_t indexBytes = 0;
+    section(MESH_SECTION_VERTICES, vertexBytes);
+    section(MESH_SECTION_INDICES, indexBytes);
+    if (vertexBytes != header->vertexCount * header->vertexStride || indexBytes != header->indexCount * header->indexSize) {
+        std::cerr << "Mesh file sizes do not match its header: " << filename << std::endl;
+        close();
+        return false;
+    }
+    if (!hasValidSections()) {
+        std::cerr << "Corrupt section contents in mesh file: " << filename << std::endl;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool MeshFile::hasValidSections() const {
+    const MeshFileHeader& header = *fileHeader;
+    uint64_t indexCount = header.indexCount;
+    // Each element takes at least a byte, which also rules out counts whose byte sizes wrapped around
+    if (header.vertexStride == 0 || header.vertexCount > file.size() || indexCount > file.size()) {
+        return false;
+    }
+
+    size_t submeshCount = 0;
+    const Submesh* submeshList = submeshes(submeshCount);
+    for (size_t i = 0; i < submeshCount; ++i) {
+        if (static_cast<uint64_t>(submeshList[i].firstIndex) + submeshList[i].indexCount > indexCount) {
+            return false;
+        }
+    }
+
+    // Every index has to name a vertex once its submesh's base vertex is added; loaders index vertex
+    // tables with them without checking again
+    if (header.indexSize != sizeof(uint16_t) && header.indexSize != sizeof(uint32_t)) {
+        return false;
+    }
+    size_t baseVertexCount = 0;
+    const int32_t* baseVertexList = baseVertices(baseVertexCount);
+    if (baseVertexList != nullptr && baseVertexCount != submeshCount) {
+        return false;
+    }
+    auto indexAt = [&](uint64_t i) -> uint64_t {
+        return header.indexSize == sizeof(uint32_t) ? static_cast<const uint32_t*>(indexData())[i]
+            : static_cast<const uint16_t*>(indexData())[i];
+    };
+    for (uint64_t i = 0; i < indexCount; ++i) {
+        if (indexAt(i) >= header.vertexCount) {
+            return false;
+        }
+    }
+    for (size_t s = 0; s < baseVertexCount; ++s) {
+        if (baseVertexList[s] < 0) {
+            return false;
+        }
+        if (baseVertexList[s] == 0) {
+            continue;
+        }
+        for (uint64_t i = submeshList[s].firstIndex; i < submeshList[s].firstIndex + submeshList[s].indexCount; ++i) {
+            if (indexAt(i) + static_cast<uint64_t>(baseVertexList[s]) >= header.vertexCount) {
+                return false;
+            }
+        }
+    }
+
+    size_t lodCount = 0;
+    const MeshLod* lodList = lods(lodCount);
+    for (size_t i = 0; i < lodCount; ++i) {
+        if (static_cast<uint64_t>(lodList[i].firstSubmesh) + lodList[i].submeshCount > submeshCount) {
+            return false;
+        }
+    }
+
+    size_t meshletCount = 0, offsetCount = 0;
+    const Meshlet* meshletList = meshlets(meshletCount);
+    const uint32_t* offsets = meshletOffsets(offsetCount);
+    if (meshletList != nullptr || offsets != nullptr) {
+        if (offsetCount != submeshCount + 1) {
+            return false;
+        }
+        for (size_t i = 0; i < offsetCount; ++i) {
+            if (offsets[i] > meshletCount || (i != 0 && offsets[i] < offsets[i - 1])) {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < meshletCount; ++i) {
+            if (static_cast<uint64_t>(meshletList[i].firstIndex) + meshletList[i].indexCount > indexCount) {
+                return false;
+            }
+        }
+    }
+
+    size_t nodeCount = 0, packetCount = 0;
+    const TriangleBvhNode* nodes = bvhNodes(nodeCount);
+    const TrianglePacket* packets = bvhPackets(packetCount);
+    if ((nodes != nullptr) != (packets != nullptr)) {
+        return false;
+    }
+    return TriangleBvh::isValid(nodes, nodeCount, packets, packetCount, static_cast<size_t>(indexCount / 3));
+}
+
+void MeshFile::close() {
+    file.close();
+    fileHeader = nullptr;
+    sections = nullptr;
+}
+
+const void* MeshFile::section(uint32_t type, size_t& size) const {
+    size = 0;
+    if (fileHeader == nullptr) {
+        return nullptr;
+    }
+    for (uint32_t i = 0; i < fileHeader->sectionCount; ++i) {
+        if (sections[i].type == type) {
+            size = static_cast<size_t>(sections[i].size);
+            return file.data() + sections[i].offset;
+        }
+    }
+    return nullptr;
+}
+
+const MeshFileAttribute* MeshFile::attributes(size_t& count) const {
+    size_t size = 0;
+    const void* data = section(MESH_SECTION_ATTRIBUTES, size);
+    count = size / sizeof(MeshFileAttribute);
+    return static_cast<const MeshFileAttribute*>(data);
+}
+
+const Submesh* MeshFile::submeshes(size_t& count) const {
+    size_t size = 0;
+    const void* data = section(MESH_SECTION_SUBMESHES, size);
+    count = size / sizeof(Submesh);
+    return static_cast<const Submesh*>(data);
+}
+
+const MeshLod* MeshFile::lods(size_t& count) const {
+    size_t size = 0;
+    const void* data = section(MESH_SECTION_LODS, size);
+    count = size / sizeof(MeshLod);
+    return static_cast<const MeshLod*>(data);
+}
+
+const Meshlet* MeshFile::meshlets(size_t& count) const {
+    size_t size = 0;
+    const void* data = section(MESH_SECTION_MESHLETS, size);
+    count = size / sizeof(Meshlet);
+    return static_cast<const Meshlet*>(data);
+}
+
+const uint32_t* MeshFile::meshletOffsets(size_t& count) const {
+    size_t size = 0;
+    const void* data = section(MESH_SECTION_MESHLET_OFFSETS, size);
+    count = size / sizeof(uint32_t);
+    return static_cast<const uint32_t*>(data);
+}
+
+const int32_t* MeshFile::baseVertices(size_t& count) const {
+    size_t size = 0;
+    const void* data = section(MESH_SECTION_BASE_VERTICES, size);
+    count = size / sizeof(int32_t);
+    return static_cast<const int32_t*>(data);
+}
+
+const TriangleBvhNode* MeshFile::bvhNodes(size_t& count) const {
+    size_t size = 0;
+    const void* data = section(MESH_SECTION_BVH_NODES, size);
+    count = size / sizeof(TriangleBvhNode);
+    return static_cast<const TriangleBvhNode*>(data);
+}
+
+const TrianglePacket* MeshFile::bvhPackets(size_t& count) const {
+    size_t size = 0;
+    const void* data = section(MESH_SECTION_BVH_PACKETS, size);
+    count = size / sizeof(TrianglePacket);
+    return static_cast<const TrianglePacket*>(data);
+}
+
+bool MeshFile::materials(std::vector<Material>& materials) const {
+    materials.clear();
+
+    size_t size = 0;
+    const MeshFileMaterial* records = static_cast<const MeshFileMaterial*>(section(MESH_SECTION_MATERIALS, size));
+    size_t count = size / sizeof(MeshFileMaterial);
+    size_t stringsSize = 0;
+    const char* strings = static_cast<const char*>(section(MESH_SECTION_STRINGS, stringsSize));
+
+    materials.resize(count);
+    for (size_t m = 0; m < count; ++m) {
+        const MeshFileMaterial& record = records[m];
+        if (static_cast<uint64_t>(record.nameOffset) + record.nameLength > stringsSize ||
+            static_cast<uint64_t>(record.textureOffset) + record.textureLength > stringsSize) {
+            std::cerr << "Corrupt material table in mesh file" << std::endl;
+            materials.clear();
+            return false;
+        }
+
+        Material& material = materials[m];
+        for (int i = 0; i < 3; ++i) {
+            material.ambient[i] = record.ambient[i];
+            material.diffuse[i] = record.diffuse[i];
+            material.specular[i] = record.specular[i];
+            material.emission[i] = record.emission[i];
+        }
+        material.shininess = record.shininess;
+        material.dissolve = record.dissolve;
+        material.name.assign(strings + record.nameOffset, record.nameLength);
+        material.diffuseTexture.assign(strings + record.textureOffset, record.textureLength);
+    }
+    return true;
+}
+
+const void* MeshFile::vertexData() const {
+    size_t size = 0;
+    return section(MESH_SECTION_VERTICES, size);
+}
+
+const void* MeshFile::indexData() const {
+    size_t size = 0;
+    return section(MESH_SECTION_INDICES, size);
+}
+
+IndexLayout MeshFile::indexLayout() const {
+    IndexLayout layout;
+    size_t submeshCount = 0, baseVertexCount = 0;
+    submeshes(submeshCount);
+    const int32_t* baseVertexList = baseVertices(baseVertexCount);
+    layout.indexSize = fileHeader != nullptr ? fileHeader->indexSize : static_cast<uint32_t>(sizeof(uint32_t));
+    if (baseVertexList != nullptr) {
+        layout.baseVertices.assign(baseVertexList, baseVertexList + baseVertexCount);
+    }
+    else {
+        layout.baseVertices.assign(submeshCount, 0);
+    }
+    return layout;
+}
+
+bool MeshFile::hasVertexLayout() const {
+    if (fileHeader == nullptr || fileHeader->vertexStride != sizeof(Vertex)) {
+        return false;
+    }
+
+    size_t count = 0;
+    const MeshFileAttribute* fileAttributes = attributes(count);
+    std::vector<MeshFileAttribute> expected = vertexAttributes();
+    return count == expected.size() &&
+        std::memcmp(fileAttributes, expected.data(), count * sizeof(MeshFileAttribute)) == 0;
+}
@@ -0,0 +1,145 @@
+#pragma once
+#ifndef MESH_FILE_H
+#define MESH_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "index_buffer.h"
+#include "mapped_file.h"
+#include "mesh_data.h"
+
+// Cooked mesh container. Layout on disk:
+//   MeshFileHeader
+//   MeshFileSection[sectionCount]
+//   section payloads, each starting on a MESH_FILE_ALIGNMENT boundary
+// All values are little-endian. Readers skip section types they do not know, so new sections
+// can be added without a version bump; changing an existing section's layout needs one.
+
+const uint32_t MESH_FILE_VERSION = 2;
+const size_t MESH_FILE_ALIGNMENT = 16;
+
+enum MeshSectionType : uint32_t {
+    MESH_SECTION_ATTRIBUTES = 1,  // MeshFileAttribute[]
+    MESH_SECTION_VERTICES = 2,    // vertexCount * vertexStride bytes
+    MESH_SECTION_INDICES = 3,     // indexCount * indexSize bytes, packed by IndexPacker
+    MESH_SECTION_SUBMESHES = 4,   // Submesh[]
+    MESH_SECTION_LODS = 5,        // MeshLod[]; absent means one level covering every submesh
+    MESH_SECTION_SPHERE = 6,      // float[4]: centre xyz, radius; absent means the box's circumscribed sphere
+    MESH_SECTION_MESHLETS = 7,    // Meshlet[]; optional
+    MESH_SECTION_MESHLET_OFFSETS = 8,  // uint32_t[submeshCount + 1]; present with MESH_SECTION_MESHLETS
+    MESH_SECTION_BASE_VERTICES = 9,  // int32_t[submeshCount]: added to the packed indices of each submesh; absent means 0
+    MESH_SECTION_MATERIALS = 10,  // MeshFileMaterial[]; optional, indexed by Submesh::materialId
+    MESH_SECTION_STRINGS = 11,    // char[]; names and paths referenced by other sections, not terminated
+    MESH_SECTION_BVH_NODES = 12,  // TriangleBvhNode[]; optional, over the base level
+    MESH_SECTION_BVH_PACKETS = 13,  // TrianglePacket[]; present with MESH_SECTION_BVH_NODES
+};
+
+// Component types use the numeric values of the matching GL enums so they can be passed straight through
+enum MeshComponentType : uint32_t {
+    MESH_COMPONENT_BYTE = 0x1400,            // GL_BYTE
+    MESH_COMPONENT_UNSIGNED_BYTE = 0x1401,   // GL_UNSIGNED_BYTE
+    MESH_COMPONENT_SHORT = 0x1402,           // GL_SHORT
+    MESH_COMPONENT_UNSIGNED_SHORT = 0x1403,  // GL_UNSIGNED_SHORT
+    MESH_COMPONENT_FLOAT = 0x1406,           // GL_FLOAT
+    MESH_COMPONENT_HALF_FLOAT = 0x140B,      // GL_HALF_FLOAT
+};
+
+struct MeshFileHeader {
+    char magic[4];           // "OGLM"
+    uint32_t version;
+    uint32_t sectionCount;
+    uint32_t vertexStride;
+    uint32_t indexSize;      // Bytes per index: 2 or 4
+    uint32_t flags;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    float boundsMin[3];
+    float boundsMax[3];
+};
+
+struct MeshFileSection {
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t offset;         // From the start of the file
+    uint64_t size;
+};
+
+struct MeshFileAttribute {
+    uint32_t location;       // Shader attribute location
+    uint32_t components;
+    uint32_t componentType;  // MeshComponentType
+    uint32_t normalized;
+    uint32_t offset;         // Byte offset inside a vertex
+};
+
+struct MeshFileMaterial {
+    float ambient[3];
+    float diffuse[3];
+    float specular[3];
+    float emission[3];
+    float shininess;
+    float dissolve;
+    uint32_t nameOffset;     // Into MESH_SECTION_STRINGS
+    uint32_t nameLength;
+    uint32_t textureOffset;  // Diffuse texture path as written in the MTL
+    uint32_t textureLength;
+};
+
+static_assert(sizeof(MeshFileHeader) == 64, "MeshFileHeader layout changed");
+static_assert(sizeof(MeshFileSection) == 24, "MeshFileSection layout changed");
+static_assert(sizeof(Submesh) == 12, "Submesh layout changed");
+static_assert(sizeof(MeshLod) == 12, "MeshLod layout changed");
+static_assert(sizeof(Meshlet) == 40, "Meshlet layout changed");
+static_assert(sizeof(MeshFileMaterial) == 72, "MeshFileMaterial layout changed");
+static_assert(sizeof(TriangleBvhNode) == 32, "TriangleBvhNode layout changed");
+static_assert(sizeof(TrianglePacket) == 160, "TrianglePacket layout changed");
+
+// Reads a cooked mesh through a memory mapping; the returned pointers stay valid until close()
+class MeshFile {
+public:
+    // Indices are stored packed for the GPU, 16-bit whenever IndexPacker can fit them, so loads upload
+    // them straight from the mapping
+    static bool write(const std::string& filename, const MeshData& mesh);
+
+    // Attribute layout of the interleaved Vertex struct
+    static std::vector<MeshFileAttribute> vertexAttributes();
+
+    // Fails unless every range and index in the known sections is in bounds, so corrupt files are rejected
+    // here rather than read out of bounds later
+    bool open(const std::string& filename);
+    void close();
+
+    const MeshFileHeader& header() const { return *fileHeader; }
+
+    // Returns nullptr (and size 0) when the section is absent
+    const void* section(uint32_t type, size_t& size) const;
+
+    const MeshFileAttribute* attributes(size_t& count) const;
+    const Submesh* submeshes(size_t& count) const;
+    const MeshLod* lods(size_t& count) const;
+    const Meshlet* meshlets(size_t& count) const;
+    const uint32_t* meshletOffsets(size_t& count) const;
+    const int32_t* baseVertices(size_t& count) const;
+    const TriangleBvhNode* bvhNodes(size_t& count) const;
+    const TrianglePacket* bvhPackets(size_t& count) const;
+    // Decodes the material table; false when a string reference is out of range
+    bool materials(std::vector<Material>& materials) const;
+    const void* vertexData() const;
+    // Indices as IndexPacker left them; indexLayout() gives their size and per-submesh base vertices
+    const void* indexData() const;
+    IndexLayout indexLayout() const;
+
+    // True when the vertex blob can be read as an array of Vertex
+    bool hasVertexLayout() const;
+
+private:
+    MappedFile file;
+    const MeshFileHeader* fileHeader = nullptr;
+    const MeshFileSection* sections = nullptr;
+
+    bool hasValidSections() const;
+};
+
+#endif // MESH_FILE_H
@@ -0,0 +1,269 @@
+#include "mesh_optimizer.h"
+#include <algorithm>
+#include <numeric>
+
+void MeshOptimizer::optimize(MeshData& mesh, float overdrawThreshold) {
+    std::vector<uint32_t> clusters;
+    for (const Submesh& submesh : mesh.submeshes) {
+        uint32_t* range = mesh.indices.data() + submesh.firstIndex;
+        clusters.clear();
+        optimizeVertexCache(range, submesh.indexCount, mesh.vertices.size(), &clusters);
+        optimizeOverdraw(range, submesh.indexCount, mesh.vertices, clusters, overdrawThreshold);
+    }
+    optimizeVertexFetch(mesh.vertices, mesh.indices);
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::analyzeVertexCache(const MeshData& mesh) {
+    return analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::analyzeVertexCache(const uint32_t* indices, size_t indexCount,
+    size_t vertexCount, uint32_t cacheSize) {
+    CacheStats stats;
+    if (indexCount < 3 || vertexCount == 0) {
+        return stats;
+    }
+
+    // FIFO cache simulated with insertion timestamps: a vertex is resident while fewer than
+    // cacheSize misses have happened since it was inserted
+    std::vector<uint32_t> insertedAt(vertexCount, 0);
+    std::vector<char> used(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    size_t misses = 0, unique = 0;
+
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t vertex = indices[i];
+        if (time - insertedAt[vertex] > cacheSize) {
+            insertedAt[vertex] = time++;
+            ++misses;
+        }
+        if (!used[vertex]) {
+            used[vertex] = 1;
+            ++unique;
+        }
+    }
+
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(unique);
+    return stats;
+}
+
+void MeshOptimizer::optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount,
+    std::vector<uint32_t>* clusters, uint32_t cacheSize) {
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // Vertex -> triangle adjacency in compressed rows
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        ++liveTriangles[indices[i]];
+    }
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+    }
+    std::vector<uint32_t> adjacency(adjacencyOffsets[vertexCount]);
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        for (int corner = 0; corner < 3; ++corner) {
+            adjacency[fill[indices[t * 3 + corner]]++] = static_cast<uint32_t>(t);
+        }
+    }
+
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<char> emitted(triangleCount, 0);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(triangleCount * 3);
+
+    uint32_t time = cacheSize + 1;
+    size_t cursor = 0;
+
+    // Next vertex that still has triangles: most recent dead end first, then input order
+    auto skipDeadEnd = [&]() -> int64_t {
+        while (!deadEnds.empty()) {
+            uint32_t vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangles[vertex] > 0) {
+                return vertex;
+            }
+        }
+        while (cursor < vertexCount) {
+            if (liveTriangles[cursor] > 0) {
+                return static_cast<int64_t>(cursor);
+            }
+            ++cursor;
+        }
+        return -1;
+    };
+
+    int64_t fanning = skipDeadEnd();
+    bool startsCluster = true;
+    while (fanning >= 0) {
+        if (startsCluster && clusters != nullptr) {
+            clusters->push_back(static_cast<uint32_t>(output.size() / 3));
+        }
+
+        candidates.clear();
+        for (uint32_t a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; ++a) {
+            uint32_t triangle = adjacency[a];
+            if (emitted[triangle]) {
+                continue;
+            }
+            emitted[triangle] = 1;
+            for (int corner = 0; corner < 3; ++corner) {
+                uint32_t vertex = indices[triangle * 3 + corner];
+                output.push_back(vertex);
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                --liveTriangles[vertex];
+                if (time - cacheTime[vertex] > cacheSize) {
+                    cacheTime[vertex] = time++;
+                }
+            }
+        }
+
+        // Prefer the candidate that is still in cache and will stay there while its fan is emitted
+        int64_t next = -1;
+        int64_t bestPriority = -1;
+        for (uint32_t vertex : candidates) {
+            if (liveTriangles[vertex] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            if (time - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+                priority = time - cacheTime[vertex];
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                next = vertex;
+            }
+        }
+
+        startsCluster = next < 0;
+        fanning = next >= 0 ? next : skipDeadEnd();
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void MeshOptimizer::optimizeOverdraw(uint32_t* indices, size_t indexCount, const std::vector<Vertex>& vertices,
+    const std::vector<uint32_t>& hardClusters, float threshold, uint32_t cacheSize) {
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2 || hardClusters.empty()) {
+        return;
+    }
+
+    // Split hard clusters further wherever the running ACMR from a cold cache is already within
+    // threshold of the whole cluster's ACMR; restarting there costs at most that much cache efficiency
+    std::vector<uint32_t> clusters;
+    std::vector<uint32_t> cacheTime(vertices.size(), 0);
+    uint32_t time = cacheSize + 1;
+    auto countMiss = [&](uint32_t vertex) -> uint32_t {
+        if (time - cacheTime[vertex] > cacheSize) {
+            cacheTime[vertex] = time++;
+            return 1;
+        }
+        return 0;
+    };
+    auto flushCache = [&]() { time += cacheSize + 1; };
+
+    for (size_t c = 0; c < hardClusters.size(); ++c) {
+        uint32_t begin = hardClusters[c];
+        uint32_t end = c + 1 < hardClusters.size() ? hardClusters[c + 1] : static_cast<uint32_t>(triangleCount);
+
+        flushCache();
+        uint32_t clusterMisses = 0;
+        for (uint32_t t = begin; t < end; ++t) {
+            clusterMisses += countMiss(indices[t * 3]) + countMiss(indices[t * 3 + 1]) + countMiss(indices[t * 3 + 2]);
+        }
+        float clusterAcmr = static_cast<float>(clusterMisses) / static_cast<float>(end - begin);
+
+        flushCache();
+        clusters.push_back(begin);
+        uint32_t start = begin, misses = 0;
+        for (uint32_t t = begin; t < end; ++t) {
+            misses += countMiss(indices[t * 3]) + countMiss(indices[t * 3 + 1]) + countMiss(indices[t * 3 + 2]);
+            if (t + 1 < end && static_cast<float>(misses) <= threshold * clusterAcmr * static_cast<float>(t + 1 - start)) {
+                clusters.push_back(t + 1);
+                start = t + 1;
+                misses = 0;
+                flushCache();
+            }
+        }
+    }
+
+    // Sort key: how far the cluster faces away from the mesh centre. Clusters on the outside
+    // facing out tend to occlude the rest, so they go first.
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    std::vector<glm::vec3> clusterCentroid(clusters.size(), glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormal(clusters.size(), glm::vec3(0.0f));
+    std::vector<float> clusterArea(clusters.size(), 0.0f);
+
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        uint32_t end = c + 1 < clusters.size() ? clusters[c + 1] : static_cast<uint32_t>(triangleCount);
+        for (uint32_t t = clusters[c]; t < end; ++t) {
+            const glm::vec3& a = vertices[indices[t * 3]].position;
+            const glm::vec3& b = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3& d = vertices[indices[t * 3 + 2]].position;
+            glm::vec3 normal = glm::cross(b - a, d - a);  // Length is twice the area
+            float area = glm::length(normal);
+            glm::vec3 centre = (a + b + d) / 3.0f;
+
+            clusterCentroid[c] += centre * area;
+            clusterNormal[c] += normal;
+            clusterArea[c] += area;
+            meshCentroid += centre * area;
+            meshArea += area;
+        }
+    }
+    if (meshArea > 0.0f) {
+        meshCentroid /= meshArea;
+    }
+
+    std::vector<float> sortKey(clusters.size(), 0.0f);
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        if (clusterArea[c] <= 0.0f) {
+            continue;
+        }
+        glm::vec3 centroid = clusterCentroid[c] / clusterArea[c];
+        float normalLength = glm::length(clusterNormal[c]);
+        if (normalLength > 0.0f) {
+            sortKey[c] = glm::dot(centroid - meshCentroid, clusterNormal[c] / normalLength);
+        }
+    }
+
+    std::vector<uint32_t> order(clusters.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&sortKey](uint32_t a, uint32_t b) { return sortKey[a] > sortKey[b]; });
+
+    std::vector<uint32_t> sorted;
+    sorted.reserve(triangleCount * 3);
+    for (uint32_t c : order) {
+        uint32_t end = c + 1 < clusters.size() ? clusters[c + 1] : static_cast<uint32_t>(triangleCount);
+        sorted.insert(sorted.end(), indices + clusters[c] * 3, indices + end * 3);
+    }
+    std::copy(sorted.begin(), sorted.end(), indices);
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    const uint32_t UNUSED = 0xFFFFFFFFu;
+    std::vector<uint32_t> remap(vertices.size(), UNUSED);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+
+    for (uint32_t& index : indices) {
+        if (remap[index] == UNUSED) {
+            remap[index] = static_cast<uint32_t>(reordered.size());
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    // Vertices no triangle references are dropped
+    vertices.swap(reordered);
+}
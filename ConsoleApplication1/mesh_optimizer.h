@@ -0,0 +1,43 @@
+#pragma once
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "mesh_data.h"
+
+// Reorders triangles and vertices for the GPU: post-transform cache order (Tipsify, Sander et al. 2007),
+// then overdraw-aware ordering of the resulting clusters, then vertex fetch order. Triangles never move
+// between submeshes. GL-free so the cooker and Model::loadFromFile share it.
+class MeshOptimizer {
+public:
+    struct CacheStats {
+        float acmr = 0.0f;  // Average cache miss ratio: vertex shader runs per triangle (0.5 ideal, 3 worst)
+        float atvr = 0.0f;  // Average transform to vertex ratio: vertex shader runs per unique vertex (1 ideal)
+    };
+
+    // Cache size Tipsify targets and the analysis simulates; 16 entries is a conservative FIFO for current GPUs
+    static const uint32_t CACHE_SIZE = 16;
+
+    // Runs all three stages in place. threshold bounds how much ACMR the overdraw stage may give up.
+    static void optimize(MeshData& mesh, float overdrawThreshold = 1.05f);
+
+    static CacheStats analyzeVertexCache(const MeshData& mesh);
+    static CacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+        uint32_t cacheSize = CACHE_SIZE);
+
+    // Tipsify over one index range. Writes the start triangle of every cluster that began at a dead end
+    // into clusters when it is not null.
+    static void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount,
+        std::vector<uint32_t>* clusters = nullptr, uint32_t cacheSize = CACHE_SIZE);
+
+    // Splits the cache-ordered range into clusters and sorts them so outward-facing ones draw first
+    static void optimizeOverdraw(uint32_t* indices, size_t indexCount, const std::vector<Vertex>& vertices,
+        const std::vector<uint32_t>& hardClusters, float threshold, uint32_t cacheSize = CACHE_SIZE);
+
+    // Renumbers vertices in order of first use so vertex fetch walks memory linearly
+    static void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+};
+
+#endif // MESH_OPTIMIZER_H
@@ -0,0 +1,312 @@
+#include "mesh_processing.h"
+#include "thread_pool.h"
+#include "vertex_dedup.h"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+
+bool MeshProcessor::loadObj(const std::string& objFilename, const std::string& mtlBasePath, MeshData& mesh,
+    ThreadPool& pool, std::vector<tinyobj::material_t>* materials) {
+    mesh.clear();
+
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> parsedMaterials;
+    std::string warn, err;
+
+    bool success = tinyobj::LoadObj(&attrib, &shapes, &parsedMaterials, &warn, &err, objFilename.c_str(),
+        mtlBasePath.empty() ? nullptr : mtlBasePath.c_str());
+
+    if (!warn.empty()) std::cout << "Warning: " << warn << std::endl;
+    if (!err.empty()) {
+        std::cerr << "Error: " << err << std::endl;
+        return false;
+    }
+    if (!success) {
+        std::cerr << "Failed to load model: " << objFilename << std::endl;
+        return false;
+    }
+
+    if (!buildVerticesParallel(attrib, shapes, mesh.vertices, mesh.indices, pool)) {
+        return false;
+    }
+    splitByMaterial(shapes, parsedMaterials, mesh);
+    mesh.ensureBaseLod();
+    mesh.computeBounds();
+
+    if (materials != nullptr) {
+        *materials = std::move(parsedMaterials);
+    }
+    return true;
+}
+
+Material MeshProcessor::makeMaterial(const tinyobj::material_t& objMaterial) {
+    Material material;
+    material.name = objMaterial.name;
+    material.ambient = { objMaterial.ambient[0], objMaterial.ambient[1], objMaterial.ambient[2] };
+    material.diffuse = { objMaterial.diffuse[0], objMaterial.diffuse[1], objMaterial.diffuse[2] };
+    material.specular = { objMaterial.specular[0], objMaterial.specular[1], objMaterial.specular[2] };
+    material.emission = { objMaterial.emission[0], objMaterial.emission[1], objMaterial.emission[2] };
+    material.shininess = objMaterial.shininess;
+    material.dissolve = objMaterial.dissolve;
+    material.diffuseTexture = objMaterial.diffuse_texname;
+    return material;
+}
+
+void MeshProcessor::splitByMaterial(const std::vector<tinyobj::shape_t>& shapes, const std::vector<tinyobj::material_t>& objMaterials,
+    MeshData& mesh) {
+    std::vector<Material> materials;
+    std::vector<bool> materialUsed(objMaterials.size(), false);
+    for (const auto& objMaterial : objMaterials) {
+        materials.push_back(makeMaterial(objMaterial));
+    }
+    for (const auto& shape : shapes) {
+        for (int id : shape.mesh.material_ids) {
+            if (id >= 0 && static_cast<size_t>(id) < objMaterials.size()) {
+                materialUsed[id] = true;
+            }
+        }
+    }
+    mesh.materials.clear();
+    std::vector<int32_t> materialRemap = mergeMaterials(materials, materialUsed, mesh.materials);
+
+    std::vector<int32_t> triangleMaterials(mesh.indices.size() / 3, -1);
+    size_t triangle = 0;
+    for (const auto& shape : shapes) {
+        size_t shapeTriangles = shape.mesh.indices.size() / 3;
+        for (size_t face = 0; face < shapeTriangles && triangle < triangleMaterials.size(); ++face, ++triangle) {
+            int id = face < shape.mesh.material_ids.size() ? shape.mesh.material_ids[face] : -1;
+            if (id >= 0 && static_cast<size_t>(id) < materialRemap.size()) {
+                triangleMaterials[triangle] = materialRemap[id];
+            }
+        }
+    }
+    groupByMaterial(mesh, triangleMaterials);
+}
+
+std::vector<int32_t> MeshProcessor::mergeMaterials(const std::vector<Material>& materials, const std::vector<bool>& used,
+    std::vector<Material>& merged) {
+    std::vector<int32_t> remap(materials.size(), -1);
+    for (size_t i = 0; i < materials.size(); ++i) {
+        if (i >= used.size() || !used[i]) {
+            continue;
+        }
+        size_t existing = 0;
+        while (existing < merged.size() && !merged[existing].sameLook(materials[i])) {
+            ++existing;
+        }
+        if (existing == merged.size()) {
+            merged.push_back(materials[i]);
+        }
+        remap[i] = static_cast<int32_t>(existing);
+    }
+    return remap;
+}
+
+void MeshProcessor::groupByMaterial(MeshData& mesh, const std::vector<int32_t>& triangleMaterials) {
+    mesh.submeshes.clear();
+
+    // Bucket 0 holds faces without a material, bucket m + 1 holds material m
+    size_t triangleCount = mesh.indices.size() / 3;
+    auto bucketOf = [&](size_t triangle) {
+        return triangle < triangleMaterials.size() ? static_cast<uint32_t>(triangleMaterials[triangle] + 1) : 0u;
+    };
+    std::vector<uint32_t> bucketStart(mesh.materials.size() + 2, 0);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        ++bucketStart[bucketOf(t) + 1];
+    }
+    for (size_t i = 1; i < bucketStart.size(); ++i) {
+        bucketStart[i] += bucketStart[i - 1];
+    }
+
+    for (size_t bucket = 0; bucket + 1 < bucketStart.size(); ++bucket) {
+        uint32_t count = bucketStart[bucket + 1] - bucketStart[bucket];
+        if (count > 0) {
+            mesh.submeshes.push_back({ bucketStart[bucket] * 3, count * 3, static_cast<int32_t>(bucket) - 1 });
+        }
+    }
+    if (mesh.submeshes.size() < 2) {
+        // Nothing to reorder
+        if (mesh.submeshes.empty()) {
+            mesh.submeshes.push_back({ 0, static_cast<uint32_t>(mesh.indices.size()), -1 });
+        }
+        return;
+    }
+
+    // Stable counting sort of the triangles by bucket
+    std::vector<uint32_t> sorted(mesh.indices.size());
+    std::vector<uint32_t> next(bucketStart.begin(), bucketStart.end() - 1);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        uint32_t destination = next[bucketOf(t)]++;
+        std::copy_n(mesh.indices.begin() + t * 3, 3, sorted.begin() + static_cast<size_t>(destination) * 3);
+    }
+    mesh.indices.swap(sorted);
+}
+
+bool MeshProcessor::makeVertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& index, Vertex& vertex) {
+    vertex = Vertex{};  // Zero-initialize the vertex so padding-free bit comparisons are stable
+
+    // Check array bounds before accessing
+    if (index.vertex_index < 0 || static_cast<size_t>(index.vertex_index) * 3 + 2 >= attrib.vertices.size()) {
+        return false;
+    }
+
+    // Get vertex position
+    vertex.position = {
+        attrib.vertices[3 * index.vertex_index + 0],
+        attrib.vertices[3 * index.vertex_index + 1],
+        attrib.vertices[3 * index.vertex_index + 2]
+    };
+
+    // Get vertex normal if available
+    if (index.normal_index >= 0 && static_cast<size_t>(index.normal_index) * 3 + 2 < attrib.normals.size()) {
+        vertex.normal = {
+            attrib.normals[3 * index.normal_index + 0],
+            attrib.normals[3 * index.normal_index + 1],
+            attrib.normals[3 * index.normal_index + 2]
+        };
+    }
+    else {
+        vertex.normal = { 0.0f, 1.0f, 0.0f };  // Default normal
+    }
+
+    // Get texture coordinates if available
+    if (index.texcoord_index >= 0 && static_cast<size_t>(index.texcoord_index) * 2 + 1 < attrib.texcoords.size()) {
+        vertex.texCoord = {
+            attrib.texcoords[2 * index.texcoord_index + 0],
+            attrib.texcoords[2 * index.texcoord_index + 1]
+        };
+    }
+    else {
+        vertex.texCoord = { 0.0f, 0.0f };  // Default UV
+    }
+
+    return true;
+}
+
+size_t MeshProcessor::estimateUniqueVertices(const tinyobj::attrib_t& attrib, size_t cornerCount) {
+    // Unique vertices are usually close to the largest attribute array, and never more than the corners
+    size_t expected = std::max({ attrib.vertices.size() / 3, attrib.normals.size() / 3, attrib.texcoords.size() / 2 });
+    return std::min(expected, cornerCount);
+}
+
+bool MeshProcessor::buildVertices(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes,
+    std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    vertices.clear();
+    indices.clear();
+
+    size_t cornerCount = 0;
+    for (const auto& shape : shapes) {
+        cornerCount += shape.mesh.indices.size();
+    }
+
+    size_t expectedVertices = estimateUniqueVertices(attrib, cornerCount);
+    VertexDeduplicator uniqueVertices;
+    uniqueVertices.reserve(expectedVertices);
+    vertices.reserve(expectedVertices);
+    indices.reserve(cornerCount);
+
+    for (const auto& shape : shapes) {
+        for (const auto& index : shape.mesh.indices) {
+            Vertex vertex;
+            if (!makeVertex(attrib, index, vertex)) {
+                std::cerr << "Vertex index out of bounds" << std::endl;
+                return false;
+            }
+
+            // Vertex deduplication on the exact bit pattern
+            indices.push_back(uniqueVertices.insert(vertex, vertices));
+        }
+    }
+
+    return !vertices.empty();
+}
+
+bool MeshProcessor::buildVerticesParallel(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes,
+    std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, ThreadPool& pool) {
+    // A chunk is a contiguous index range inside one shape
+    struct Chunk {
+        const tinyobj::shape_t* shape;
+        size_t begin;
+        size_t end;
+        size_t outputOffset;                  // Where this chunk's indices land in the final array
+        std::vector<Vertex> localVertices;    // Unique vertices in order of first use inside the chunk
+        std::vector<uint32_t> localIndices;   // Indices into localVertices
+        std::vector<uint32_t> remap;          // localVertices index -> final vertex index
+    };
+
+    std::vector<Chunk> chunks;
+    size_t cornerCount = 0;
+    for (const auto& shape : shapes) {
+        size_t shapeIndices = shape.mesh.indices.size();
+        for (size_t begin = 0; begin < shapeIndices; begin += CHUNK_INDICES) {
+            Chunk chunk;
+            chunk.shape = &shape;
+            chunk.begin = begin;
+            chunk.end = std::min(begin + CHUNK_INDICES, shapeIndices);
+            chunk.outputOffset = cornerCount + begin;
+            chunks.push_back(std::move(chunk));
+        }
+        cornerCount += shapeIndices;
+    }
+
+    if (chunks.size() < 2 || pool.threadCount() < 2) {
+        return buildVertices(attrib, shapes, vertices, indices);
+    }
+
+    // Pass 1: dedup every chunk independently
+    std::atomic<bool> outOfBounds{ false };
+    pool.parallelFor(chunks.size(), [&](size_t chunkIndex) {
+        Chunk& chunk = chunks[chunkIndex];
+        size_t chunkCorners = chunk.end - chunk.begin;
+
+        VertexDeduplicator uniqueVertices;
+        uniqueVertices.reserve(chunkCorners);
+        chunk.localVertices.reserve(chunkCorners);
+        chunk.localIndices.reserve(chunkCorners);
+
+        for (size_t i = chunk.begin; i < chunk.end; ++i) {
+            Vertex vertex;
+            if (!makeVertex(attrib, chunk.shape->mesh.indices[i], vertex)) {
+                outOfBounds = true;
+                return;
+            }
+            chunk.localIndices.push_back(uniqueVertices.insert(vertex, chunk.localVertices));
+        }
+    });
+
+    if (outOfBounds) {
+        std::cerr << "Vertex index out of bounds" << std::endl;
+        return false;
+    }
+
+    // Pass 2: merge in chunk order. Each chunk lists its vertices in order of first use, so
+    // inserting them chunk by chunk assigns the same ids the serial path would.
+    vertices.clear();
+    indices.clear();
+
+    size_t expectedVertices = estimateUniqueVertices(attrib, cornerCount);
+    VertexDeduplicator uniqueVertices;
+    uniqueVertices.reserve(expectedVertices);
+    vertices.reserve(expectedVertices);
+
+    for (Chunk& chunk : chunks) {
+        chunk.remap.resize(chunk.localVertices.size());
+        for (size_t i = 0; i < chunk.localVertices.size(); ++i) {
+            chunk.remap[i] = uniqueVertices.insert(chunk.localVertices[i], vertices);
+        }
+        std::vector<Vertex>().swap(chunk.localVertices);
+    }
+
+    // Pass 3: rewrite the indices in parallel, each chunk into its own slice
+    indices.resize(cornerCount);
+    pool.parallelFor(chunks.size(), [&](size_t chunkIndex) {
+        const Chunk& chunk = chunks[chunkIndex];
+        uint32_t* output = indices.data() + chunk.outputOffset;
+        for (size_t i = 0; i < chunk.localIndices.size(); ++i) {
+            output[i] = chunk.remap[chunk.localIndices[i]];
+        }
+    });
+
+    return !vertices.empty();
+}
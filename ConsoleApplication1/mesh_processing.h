@@ -0,0 +1,55 @@
+#pragma once
+#ifndef MESH_PROCESSING_H
+#define MESH_PROCESSING_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <tiny_obj_loader.h>
+#include "mesh_data.h"
+
+class ThreadPool;
+
+// Turns tinyobj output into a deduplicated vertex array and a triangle index list.
+// Kept free of GL so the same code can run outside the game.
+class MeshProcessor {
+public:
+    // Parses an OBJ (and its MTL files from mtlBasePath) and builds the final mesh, bounds and submesh table.
+    // materials is optional and receives the parsed MTL materials.
+    static bool loadObj(const std::string& objFilename, const std::string& mtlBasePath, MeshData& mesh,
+        ThreadPool& pool, std::vector<tinyobj::material_t>* materials = nullptr);
+
+    // Single-threaded reference path
+    static bool buildVertices(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes,
+        std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+    // Splits shapes (and large shapes into index ranges) across the pool, dedups each chunk
+    // locally and merges the chunks in order. Produces exactly the same output as buildVertices.
+    static bool buildVerticesParallel(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes,
+        std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, ThreadPool& pool);
+
+    // Groups the triangles of indices (built from shapes, in shape order) by material into one submesh per
+    // material, keeping triangle order inside each. Materials that look the same are merged into mesh.materials;
+    // faces without a material land in a leading submesh with materialId -1.
+    static void splitByMaterial(const std::vector<tinyobj::shape_t>& shapes, const std::vector<tinyobj::material_t>& objMaterials,
+        MeshData& mesh);
+
+    // Appends the used entries of materials to merged, folding ones that look the same; returns each
+    // material's index in merged, or -1 when unused
+    static std::vector<int32_t> mergeMaterials(const std::vector<Material>& materials, const std::vector<bool>& used,
+        std::vector<Material>& merged);
+
+    // Stably sorts mesh.indices by triangleMaterials (one mesh.materials index or -1 per triangle) and
+    // rebuilds mesh.submeshes with one range per material
+    static void groupByMaterial(MeshData& mesh, const std::vector<int32_t>& triangleMaterials);
+
+    // Number of OBJ indices per parallel chunk; smaller models take the serial path
+    static const size_t CHUNK_INDICES = 3 * 32768;
+
+private:
+    static bool makeVertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& index, Vertex& vertex);
+    static Material makeMaterial(const tinyobj::material_t& objMaterial);
+    static size_t estimateUniqueVertices(const tinyobj::attrib_t& attrib, size_t cornerCount);
+};
+
+#endif // MESH_PROCESSING_H
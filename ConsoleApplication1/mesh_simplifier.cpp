@@ -0,0 +1,347 @@
+#include "mesh_simplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+
+// Symmetric 4x4 error quadric for the plane equations of the triangles around a vertex, accumulated
+// with area weights. Dividing by the weight turns the error into a mean squared distance.
+struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+    double b0 = 0, b1 = 0, b2 = 0;
+    double c = 0;
+    double weight = 0;
+
+    void addPlane(const glm::vec3& normal, double d, double planeWeight) {
+        double nx = normal.x, ny = normal.y, nz = normal.z;
+        a00 += planeWeight * nx * nx; a01 += planeWeight * nx * ny; a02 += planeWeight * nx * nz;
+        a11 += planeWeight * ny * ny; a12 += planeWeight * ny * nz; a22 += planeWeight * nz * nz;
+        b0 += planeWeight * nx * d; b1 += planeWeight * ny * d; b2 += planeWeight * nz * d;
+        c += planeWeight * d * d;
+        weight += planeWeight;
+    }
+
+    void add(const Quadric& other) {
+        a00 += other.a00; a01 += other.a01; a02 += other.a02;
+        a11 += other.a11; a12 += other.a12; a22 += other.a22;
+        b0 += other.b0; b1 += other.b1; b2 += other.b2;
+        c += other.c;
+        weight += other.weight;
+    }
+
+    double evaluate(const glm::vec3& p) const {
+        double x = p.x, y = p.y, z = p.z;
+        double error = a00 * x * x + a11 * y * y + a22 * z * z
+            + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+            + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return std::max(0.0, error);
+    }
+};
+
+struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    double geometricError;  // Mean squared distance
+    double cost;            // Geometric error plus attribute penalty
+};
+
+struct PositionKey {
+    uint32_t bits[3];
+    bool operator==(const PositionKey& other) const { return std::memcmp(bits, other.bits, sizeof(bits)) == 0; }
+};
+
+struct PositionKeyHash {
+    size_t operator()(const PositionKey& key) const {
+        uint64_t h = (static_cast<uint64_t>(key.bits[0]) * 0x9E3779B97F4A7C15ull) ^
+            (static_cast<uint64_t>(key.bits[1]) * 0xC2B2AE3D27D4EB4Full) ^
+            (static_cast<uint64_t>(key.bits[2]) * 0x165667B19E3779F9ull);
+        return static_cast<size_t>(h ^ (h >> 29));
+    }
+};
+
+float attributeDistanceSquared(const Vertex& a, const Vertex& b) {
+    glm::vec3 normal = a.normal - b.normal;
+    glm::vec2 uv = a.texCoord - b.texCoord;
+    return glm::dot(normal, normal) + glm::dot(uv, uv);
+}
+
+} // namespace
+
+std::vector<uint32_t> MeshSimplifier::simplify(const std::vector<Vertex>& vertices, const uint32_t* indices, size_t indexCount,
+    size_t targetIndexCount, const Options& options, float* error) {
+    std::vector<uint32_t> result(indices, indices + indexCount - indexCount % 3);
+    if (error != nullptr) {
+        *error = 0.0f;
+    }
+    if (result.size() <= targetIndexCount || result.empty()) {
+        return result;
+    }
+
+    size_t vertexCount = vertices.size();
+
+    // Vertices that share a position form one node of the topology, so seams do not look like holes
+    std::vector<uint32_t> canonical(vertexCount);
+    std::vector<uint32_t> wedgeCount(vertexCount, 0);
+    {
+        std::unordered_map<PositionKey, uint32_t, PositionKeyHash> firstAtPosition;
+        std::vector<char> seen(vertexCount, 0);
+        for (uint32_t index : result) {
+            if (seen[index]) {
+                continue;
+            }
+            seen[index] = 1;
+            PositionKey key;
+            std::memcpy(key.bits, &vertices[index].position, sizeof(key.bits));
+            auto inserted = firstAtPosition.emplace(key, index);
+            canonical[index] = inserted.first->second;
+            ++wedgeCount[canonical[index]];
+        }
+    }
+
+    // Locks: attribute seams, and (optionally) open borders found from edges used by one triangle
+    std::vector<char> locked(vertexCount, 0);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        if (wedgeCount[v] > 1) {
+            locked[v] = 1;
+        }
+    }
+    if (options.lockBorders) {
+        std::unordered_map<uint64_t, int> edgeUses;
+        edgeUses.reserve(result.size());
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (int e = 0; e < 3; ++e) {
+                uint32_t a = canonical[result[i + e]], b = canonical[result[i + (e + 1) % 3]];
+                uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+                ++edgeUses[key];
+            }
+        }
+        for (const auto& [key, uses] : edgeUses) {
+            if (uses == 1) {
+                locked[static_cast<uint32_t>(key >> 32)] = 1;
+                locked[static_cast<uint32_t>(key)] = 1;
+            }
+        }
+    }
+
+    // Area-weighted plane quadrics per position
+    std::vector<Quadric> quadrics(vertexCount);
+    glm::vec3 boundsMin(1e30f), boundsMax(-1e30f);
+    for (size_t i = 0; i < result.size(); i += 3) {
+        const glm::vec3& p0 = vertices[result[i]].position;
+        const glm::vec3& p1 = vertices[result[i + 1]].position;
+        const glm::vec3& p2 = vertices[result[i + 2]].position;
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float doubleArea = glm::length(normal);
+        boundsMin = glm::min(boundsMin, glm::min(p0, glm::min(p1, p2)));
+        boundsMax = glm::max(boundsMax, glm::max(p0, glm::max(p1, p2)));
+        if (doubleArea <= 0.0f) {
+            continue;
+        }
+        normal /= doubleArea;
+        double d = -glm::dot(normal, p0);
+        for (int corner = 0; corner < 3; ++corner) {
+            quadrics[canonical[result[i + corner]]].addPlane(normal, d, doubleArea * 0.5);
+        }
+    }
+
+    // Attribute differences are unitless; scale them by the mesh size so the weight is size independent
+    double attributeScale = options.attributeWeight * glm::length(boundsMax - boundsMin);
+    attributeScale *= attributeScale;
+
+    double maxErrorSquared = static_cast<double>(options.maxError) * options.maxError;
+    double reachedError = 0.0;
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<char> touched(vertexCount);
+
+    while (result.size() > targetIndexCount) {
+        size_t triangleCount = result.size() / 3;
+
+        // Vertex -> triangle adjacency for the flip test
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (uint32_t index : result) {
+            ++adjacencyOffsets[index + 1];
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        }
+        adjacency.resize(result.size());
+        {
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < result.size(); ++i) {
+                adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        // Every edge in both directions; a collapse moves "from" onto "to"
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (int e = 0; e < 3; ++e) {
+                uint32_t a = result[i + e], b = result[i + (e + 1) % 3];
+                for (int direction = 0; direction < 2; ++direction) {
+                    uint32_t from = direction == 0 ? a : b;
+                    uint32_t to = direction == 0 ? b : a;
+                    uint32_t fromNode = canonical[from], toNode = canonical[to];
+                    if (locked[fromNode] || fromNode == toNode) {
+                        continue;
+                    }
+
+                    Quadric combined = quadrics[fromNode];
+                    combined.add(quadrics[toNode]);
+                    double geometric = combined.weight > 0.0 ? combined.evaluate(vertices[to].position) / combined.weight : 0.0;
+                    double cost = geometric + attributeScale * attributeDistanceSquared(vertices[from], vertices[to]);
+                    collapses.push_back({ from, to, geometric, cost });
+                }
+            }
+        }
+        if (collapses.empty()) {
+            break;
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+            return a.cost < b.cost || (a.cost == b.cost && (a.from < b.from || (a.from == b.from && a.to < b.to)));
+        });
+
+        // Apply the cheapest collapses whose neighbourhoods do not overlap, so each flip test stays valid
+        for (size_t v = 0; v < vertexCount; ++v) {
+            remap[v] = static_cast<uint32_t>(v);
+        }
+        std::fill(touched.begin(), touched.end(), 0);
+
+        size_t trianglesLeft = triangleCount;
+        size_t applied = 0;
+        for (const Collapse& collapse : collapses) {
+            if (trianglesLeft * 3 <= targetIndexCount) {
+                break;
+            }
+            if (collapse.geometricError > maxErrorSquared) {
+                break;
+            }
+            uint32_t fromNode = canonical[collapse.from], toNode = canonical[collapse.to];
+            if (touched[fromNode] || touched[toNode]) {
+                continue;
+            }
+
+            const glm::vec3& oldPosition = vertices[collapse.from].position;
+            const glm::vec3& newPosition = vertices[collapse.to].position;
+            bool flips = false;
+            size_t removed = 0;
+            for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1] && !flips; ++a) {
+                const uint32_t* triangle = &result[adjacency[a] * 3];
+                int corner = triangle[0] == collapse.from ? 0 : triangle[1] == collapse.from ? 1 : 2;
+                uint32_t next = triangle[(corner + 1) % 3], previous = triangle[(corner + 2) % 3];
+                if (canonical[next] == toNode || canonical[previous] == toNode) {
+                    ++removed;  // Triangles on the collapsed edge disappear
+                    continue;
+                }
+
+                const glm::vec3& pNext = vertices[next].position;
+                const glm::vec3& pPrevious = vertices[previous].position;
+                glm::vec3 before = glm::cross(pNext - oldPosition, pPrevious - oldPosition);
+                glm::vec3 after = glm::cross(pNext - newPosition, pPrevious - newPosition);
+                float beforeLength = glm::length(before), afterLength = glm::length(after);
+                if (afterLength <= 0.0f || glm::dot(before, after) < 0.25f * beforeLength * afterLength) {
+                    flips = true;
+                }
+            }
+            if (flips) {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[toNode].add(quadrics[fromNode]);
+            reachedError = std::max(reachedError, collapse.geometricError);
+            trianglesLeft -= std::min(trianglesLeft, removed);
+            ++applied;
+
+            // Freeze the whole one-ring: its triangles changed shape
+            for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1]; ++a) {
+                const uint32_t* triangle = &result[adjacency[a] * 3];
+                for (int corner = 0; corner < 3; ++corner) {
+                    touched[canonical[triangle[corner]]] = 1;
+                }
+            }
+        }
+
+        if (applied == 0) {
+            break;
+        }
+
+        // Rewrite triangles and drop the ones that became degenerate
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3) {
+            uint32_t a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+            if (canonical[a] == canonical[b] || canonical[b] == canonical[c] || canonical[a] == canonical[c]) {
+                continue;
+            }
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    if (error != nullptr) {
+        *error = static_cast<float>(std::sqrt(reachedError));
+    }
+    return result;
+}
+
+// A level has to drop at least this fraction of the previous level's triangles to be worth keeping
+static const float MIN_LOD_REDUCTION = 0.05f;
+
+void MeshSimplifier::buildLodChain(MeshData& mesh, const std::vector<float>& triangleRatios, const Options& options) {
+    mesh.ensureBaseLod();
+    if (mesh.lods.size() > 1) {
+        return;  // Chain already present (e.g. from a cooked file)
+    }
+
+    const MeshLod base = mesh.lods[0];
+    std::vector<Submesh> previousLevel(mesh.submeshes.begin() + base.firstSubmesh,
+        mesh.submeshes.begin() + base.firstSubmesh + base.submeshCount);
+    float previousError = 0.0f;
+    size_t previousIndexCount = mesh.lodIndexCount(0);
+
+    for (float ratio : triangleRatios) {
+        size_t levelStart = mesh.indices.size();
+        MeshLod lod;
+        lod.firstSubmesh = static_cast<uint32_t>(mesh.submeshes.size());
+        lod.submeshCount = 0;
+        lod.error = previousError;
+
+        std::vector<Submesh> level;
+        for (size_t s = 0; s < previousLevel.size(); ++s) {
+            const Submesh& baseSubmesh = mesh.submeshes[base.firstSubmesh + s];
+            size_t target = static_cast<size_t>(baseSubmesh.indexCount / 3 * ratio) * 3;
+
+            float submeshError = 0.0f;
+            std::vector<uint32_t> simplified = simplify(mesh.vertices, mesh.indices.data() + previousLevel[s].firstIndex,
+                previousLevel[s].indexCount, target, options, &submeshError);
+            lod.error = std::max(lod.error, previousError + submeshError);
+
+            Submesh submesh = { static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(simplified.size()), baseSubmesh.materialId };
+            mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.end());
+            level.push_back(submesh);
+        }
+
+        // Stop once simplification stalls (a mesh already at its minimum, or borders locked everywhere), since
+        // further levels would only repeat this one, or when nothing would be left to draw
+        size_t levelIndexCount = mesh.indices.size() - levelStart;
+        if (levelIndexCount == 0 || levelIndexCount > previousIndexCount * (1.0f - MIN_LOD_REDUCTION)) {
+            mesh.indices.resize(levelStart);
+            break;
+        }
+
+        mesh.submeshes.insert(mesh.submeshes.end(), level.begin(), level.end());
+        lod.submeshCount = static_cast<uint32_t>(level.size());
+        mesh.lods.push_back(lod);
+
+        previousLevel = level;
+        previousError = lod.error;
+        previousIndexCount = levelIndexCount;
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "mesh_data.h"
+
+// Quadric error metric simplification (Garland & Heckbert 1997) using half-edge collapses, so every
+// level of detail reuses the original vertices and only needs its own index ranges.
+// Vertices on open borders and on attribute seams (several vertices sharing one position) are locked,
+// which keeps silhouettes and UV/normal discontinuities intact.
+class MeshSimplifier {
+public:
+    struct Options {
+        float attributeWeight;  // Cost of normal/UV change relative to geometric error; 0 ignores attributes
+        bool lockBorders;
+        float maxError;         // Stop collapsing once the geometric error would exceed this (object units)
+    };
+
+    static Options defaultOptions() { return { 0.05f, true, 1e30f }; }
+
+    // 50%, 25% and 10% of the base triangles
+    static std::vector<float> defaultLodRatios() { return { 0.5f, 0.25f, 0.1f }; }
+
+    // Simplifies one index range towards targetIndexCount. Returns the new indices (into the same vertex
+    // array) and writes the geometric error reached, in object-space units, to error when not null.
+    static std::vector<uint32_t> simplify(const std::vector<Vertex>& vertices, const uint32_t* indices, size_t indexCount,
+        size_t targetIndexCount, const Options& options, float* error = nullptr);
+
+    // Appends one level per ratio (fraction of base triangles, e.g. 0.5, 0.25, 0.1) to mesh.lods.
+    // Each level is simplified from the previous one, submesh by submesh. The chain ends early when a
+    // level would remove less than 5% of the previous level's triangles.
+    static void buildLodChain(MeshData& mesh, const std::vector<float>& triangleRatios, const Options& options);
+};
+
+#endif // MESH_SIMPLIFIER_H
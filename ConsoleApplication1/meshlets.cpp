@@ -0,0 +1,275 @@
+#include "meshlets.h"
+#include "mesh_optimizer.h"
+#include <algorithm>
+#include <cmath>
+
+static void finishMeshlet(const MeshData& mesh, Meshlet& meshlet) {
+    const uint32_t* indices = mesh.indices.data() + meshlet.firstIndex;
+
+    // Sphere around the box of the meshlet's vertices
+    glm::vec3 boundsMin(1e30f), boundsMax(-1e30f);
+    for (uint32_t i = 0; i < meshlet.indexCount; ++i) {
+        const glm::vec3& p = mesh.vertices[indices[i]].position;
+        boundsMin = glm::min(boundsMin, p);
+        boundsMax = glm::max(boundsMax, p);
+    }
+    glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    float radiusSquared = 0.0f;
+    for (uint32_t i = 0; i < meshlet.indexCount; ++i) {
+        glm::vec3 offset = mesh.vertices[indices[i]].position - center;
+        radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+    }
+
+    // Normal cone from the triangle normals
+    glm::vec3 axis(0.0f);
+    std::vector<glm::vec3> normals;
+    normals.reserve(meshlet.indexCount / 3);
+    for (uint32_t i = 0; i + 2 < meshlet.indexCount; i += 3) {
+        const glm::vec3& p0 = mesh.vertices[indices[i]].position;
+        const glm::vec3& p1 = mesh.vertices[indices[i + 1]].position;
+        const glm::vec3& p2 = mesh.vertices[indices[i + 2]].position;
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float length = glm::length(normal);
+        if (length > 0.0f) {
+            normals.push_back(normal / length);
+            axis += normal / length;
+        }
+    }
+
+    float cutoff = 1.0f;
+    float axisLength = glm::length(axis);
+    if (axisLength > 0.0f && !normals.empty()) {
+        axis /= axisLength;
+        float minDot = 1.0f;
+        for (const glm::vec3& normal : normals) {
+            minDot = std::min(minDot, glm::dot(axis, normal));
+        }
+        // Cones of 90 degrees or more can never be entirely back-facing
+        cutoff = minDot <= 0.0f ? 1.0f : std::sqrt(std::max(0.0f, 1.0f - minDot * minDot));
+    }
+    else {
+        axis = glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+
+    meshlet.center[0] = center.x;
+    meshlet.center[1] = center.y;
+    meshlet.center[2] = center.z;
+    meshlet.radius = std::sqrt(radiusSquared);
+    meshlet.coneAxis[0] = axis.x;
+    meshlet.coneAxis[1] = axis.y;
+    meshlet.coneAxis[2] = axis.z;
+    meshlet.coneCutoff = cutoff;
+}
+
+// Growth order ignores the post-transform cache, so Tipsify each meshlet again on meshlet-local vertex
+// numbers (at most maxVertices of them) and map back. remap must hold UINT32_MAX for every vertex and
+// is left that way.
+static void restoreCacheOrder(MeshData& mesh, const Meshlet& meshlet, std::vector<uint32_t>& remap) {
+    uint32_t* indices = mesh.indices.data() + meshlet.firstIndex;
+    std::vector<uint32_t> globalIndex;
+    std::vector<uint32_t> local(meshlet.indexCount);
+    for (uint32_t i = 0; i < meshlet.indexCount; ++i) {
+        uint32_t v = indices[i];
+        if (remap[v] == UINT32_MAX) {
+            remap[v] = static_cast<uint32_t>(globalIndex.size());
+            globalIndex.push_back(v);
+        }
+        local[i] = remap[v];
+    }
+
+    MeshOptimizer::optimizeVertexCache(local.data(), local.size(), globalIndex.size());
+
+    for (uint32_t i = 0; i < meshlet.indexCount; ++i) {
+        indices[i] = globalIndex[local[i]];
+    }
+    for (uint32_t v : globalIndex) {
+        remap[v] = UINT32_MAX;
+    }
+}
+
+void MeshletBuilder::build(MeshData& mesh, uint32_t maxVertices, uint32_t maxTriangles) {
+    mesh.meshlets.clear();
+    mesh.meshletOffsets.assign(1, 0);
+
+    // Generation stamps tell whether a vertex is already in the open meshlet without clearing a set
+    std::vector<uint32_t> stamp(mesh.vertices.size(), 0);
+    uint32_t generation = 0;
+
+    std::vector<uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+    std::vector<uint32_t> adjacencyOffsets(mesh.vertices.size() + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<uint32_t> candidates;
+    std::vector<char> emitted;
+    std::vector<uint32_t> reordered;
+
+    for (const Submesh& submesh : mesh.submeshes) {
+        const uint32_t* indices = mesh.indices.data() + submesh.firstIndex;
+        uint32_t triangleCount = submesh.indexCount / 3;
+
+        // Vertex -> triangle adjacency of this submesh
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (uint32_t i = 0; i < triangleCount * 3; ++i) {
+            adjacencyOffsets[indices[i] + 1] += 1;
+        }
+        for (size_t v = 1; v < adjacencyOffsets.size(); ++v) {
+            adjacencyOffsets[v] += adjacencyOffsets[v - 1];
+        }
+        adjacency.resize(triangleCount * 3);
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (uint32_t i = 0; i < triangleCount * 3; ++i) {
+            adjacency[fill[indices[i]]++] = i / 3;
+        }
+
+        // Grow each meshlet from its seed by repeatedly taking the adjacent triangle that adds the fewest
+        // vertices, nearest the meshlet's centre on ties; the triangles are rewritten in meshlet order
+        emitted.assign(triangleCount, 0);
+        reordered.clear();
+        reordered.reserve(triangleCount * 3);
+        uint32_t cursor = 0;
+        uint32_t seed = 0;
+        bool haveSeed = false;
+
+        while (reordered.size() < triangleCount * 3) {
+            if (!haveSeed) {
+                while (emitted[cursor]) {
+                    ++cursor;
+                }
+                seed = cursor;
+            }
+
+            Meshlet meshlet{};
+            meshlet.firstIndex = submesh.firstIndex + static_cast<uint32_t>(reordered.size());
+            uint32_t vertexCount = 0;
+            glm::vec3 positionSum(0.0f);
+            candidates.clear();
+            ++generation;
+
+            uint32_t next = seed;
+            while (true) {
+                emitted[next] = 1;
+                for (int corner = 0; corner < 3; ++corner) {
+                    uint32_t v = indices[next * 3 + corner];
+                    reordered.push_back(v);
+                    if (stamp[v] != generation) {
+                        stamp[v] = generation;
+                        ++vertexCount;
+                        positionSum += mesh.vertices[v].position;
+                        for (uint32_t k = adjacencyOffsets[v]; k < adjacencyOffsets[v + 1]; ++k) {
+                            if (!emitted[adjacency[k]]) {
+                                candidates.push_back(adjacency[k]);
+                            }
+                        }
+                    }
+                }
+                meshlet.indexCount += 3;
+                if (meshlet.indexCount / 3 >= maxTriangles) {
+                    break;
+                }
+
+                glm::vec3 center = positionSum / static_cast<float>(vertexCount);
+                uint32_t best = UINT32_MAX;
+                uint32_t bestNew = 4;
+                float bestDistance = 0.0f;
+                size_t kept = 0;
+                for (size_t c = 0; c < candidates.size(); ++c) {
+                    uint32_t triangle = candidates[c];
+                    if (emitted[triangle]) {
+                        continue;
+                    }
+                    candidates[kept++] = triangle;
+
+                    const uint32_t* t = indices + triangle * 3;
+                    uint32_t newVertices = (stamp[t[0]] != generation) + (stamp[t[1]] != generation && t[1] != t[0])
+                        + (stamp[t[2]] != generation && t[2] != t[0] && t[2] != t[1]);
+                    if (vertexCount + newVertices > maxVertices || newVertices > bestNew) {
+                        continue;
+                    }
+                    glm::vec3 centroid = (mesh.vertices[t[0]].position + mesh.vertices[t[1]].position + mesh.vertices[t[2]].position) / 3.0f;
+                    glm::vec3 offset = centroid - center;
+                    float distance = glm::dot(offset, offset);
+                    if (newVertices < bestNew || distance < bestDistance) {
+                        best = triangle;
+                        bestNew = newVertices;
+                        bestDistance = distance;
+                    }
+                }
+                candidates.resize(kept);
+
+                if (best == UINT32_MAX) {
+                    break;
+                }
+                next = best;
+            }
+
+            // Seed the following meshlet next to this one so neighbours stay close in the index buffer
+            haveSeed = false;
+            for (uint32_t triangle : candidates) {
+                if (!emitted[triangle]) {
+                    seed = triangle;
+                    haveSeed = true;
+                    break;
+                }
+            }
+
+            mesh.meshlets.push_back(meshlet);
+        }
+
+        std::copy(reordered.begin(), reordered.end(), mesh.indices.begin() + submesh.firstIndex);
+        for (size_t i = mesh.meshletOffsets.back(); i < mesh.meshlets.size(); ++i) {
+            restoreCacheOrder(mesh, mesh.meshlets[i], remap);
+            finishMeshlet(mesh, mesh.meshlets[i]);
+        }
+        mesh.meshletOffsets.push_back(static_cast<uint32_t>(mesh.meshlets.size()));
+    }
+}
+
+bool MeshletCuller::isVisible(const Meshlet& meshlet, const Frustum& localFrustum, const glm::vec3& localCamera) {
+    glm::vec3 center(meshlet.center[0], meshlet.center[1], meshlet.center[2]);
+    if (!localFrustum.intersectsSphere(center, meshlet.radius)) {
+        return false;
+    }
+
+    // Every triangle faces away when the view direction to the sphere lies inside the back of the cone
+    glm::vec3 axis(meshlet.coneAxis[0], meshlet.coneAxis[1], meshlet.coneAxis[2]);
+    glm::vec3 toCenter = center - localCamera;
+    return glm::dot(toCenter, axis) < meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius;
+}
+
+void MeshletCuller::cull(const Meshlet* meshlets, size_t meshletCount, const Frustum& localFrustum, const glm::vec3& localCamera,
+    const IndexLayout& indexLayout, size_t submesh, DrawList& drawList, Stats& stats) {
+    uint32_t rangeStart = 0, rangeEnd = 0;
+    bool open = false;
+
+    auto flush = [&]() {
+        if (open) {
+            drawList.counts.push_back(static_cast<int32_t>(rangeEnd - rangeStart));
+            drawList.offsets.push_back(reinterpret_cast<const void*>(indexLayout.byteOffset(rangeStart)));
+            drawList.baseVertices.push_back(indexLayout.baseVertex(submesh));
+            open = false;
+        }
+    };
+
+    for (size_t i = 0; i < meshletCount; ++i) {
+        const Meshlet& meshlet = meshlets[i];
+        stats.meshletsTotal += 1;
+        stats.trianglesTotal += meshlet.indexCount / 3;
+
+        if (!isVisible(meshlet, localFrustum, localCamera)) {
+            flush();
+            continue;
+        }
+
+        stats.meshletsVisible += 1;
+        stats.trianglesVisible += meshlet.indexCount / 3;
+        if (open && rangeEnd == meshlet.firstIndex) {
+            rangeEnd += meshlet.indexCount;
+        }
+        else {
+            flush();
+            rangeStart = meshlet.firstIndex;
+            rangeEnd = meshlet.firstIndex + meshlet.indexCount;
+            open = true;
+        }
+    }
+    flush();
+}
@@ -0,0 +1,51 @@
+#pragma once
+#ifndef MESHLETS_H
+#define MESHLETS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "frustum.h"
+#include "index_buffer.h"
+#include "mesh_data.h"
+
+class MeshletBuilder {
+public:
+    static const uint32_t MAX_VERTICES = 64;
+    static const uint32_t MAX_TRIANGLES = 124;
+
+    // Groups each submesh's triangles into spatially compact meshlets and rewrites the submesh's index
+    // range so every meshlet is a contiguous run; fills mesh.meshlets / mesh.meshletOffsets. Run after
+    // MeshOptimizer, whose vertex order it keeps.
+    static void build(MeshData& mesh, uint32_t maxVertices = MAX_VERTICES, uint32_t maxTriangles = MAX_TRIANGLES);
+};
+
+// Frustum and normal-cone culling of meshlets into multi-draw ranges
+class MeshletCuller {
+public:
+    struct Stats {
+        size_t meshletsTotal = 0;
+        size_t meshletsVisible = 0;
+        size_t trianglesTotal = 0;
+        size_t trianglesVisible = 0;
+    };
+
+    // Ranges for glMultiDrawElementsBaseVertex, in bytes from the start of the index buffer
+    struct DrawList {
+        std::vector<int32_t> counts;
+        std::vector<const void*> offsets;
+        std::vector<int32_t> baseVertices;
+
+        void clear() { counts.clear(); offsets.clear(); baseVertices.clear(); }
+    };
+
+    // Culls the meshlets of one submesh. localFrustum and localCamera must be in the mesh's object
+    // space. Adjacent visible meshlets are merged into one range.
+    static void cull(const Meshlet* meshlets, size_t meshletCount, const Frustum& localFrustum, const glm::vec3& localCamera,
+        const IndexLayout& indexLayout, size_t submesh, DrawList& drawList, Stats& stats);
+
+    static bool isVisible(const Meshlet& meshlet, const Frustum& localFrustum, const glm::vec3& localCamera);
+};
+
+#endif // MESHLETS_H
@@ -0,0 +1,104 @@
+#include "model_loader.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <iostream>
+
+ModelLoader::LoadState ModelLoader::Handle::state() const {
+    return request != nullptr ? request->state.load() : LoadState::Failed;
+}
+
+float ModelLoader::Handle::uploadProgress() const {
+    if (request == nullptr) {
+        return 0.0f;
+    }
+    if (request->state == LoadState::Ready) {
+        return 1.0f;
+    }
+    size_t total = request->bytesTotal;
+    return total != 0 ? static_cast<float>(request->bytesUploaded) / static_cast<float>(total) : 0.0f;
+}
+
+ModelLoader::ModelLoader(size_t uploadBytesPerFrame) : ModelLoader(uploadBytesPerFrame, ThreadPool::shared()) {}
+
+ModelLoader::ModelLoader(size_t uploadBytesPerFrame, ThreadPool& pool)
+    : pool(pool), uploadBytesPerFrame(std::max<size_t>(uploadBytesPerFrame, 1)) {}
+
+ModelLoader::Handle ModelLoader::load(Model& model, const std::string& objFilename, const std::string& mtlBasePath) {
+    auto request = std::make_shared<Request>();
+    request->model = &model;
+    request->objFilename = objFilename;
+    request->mtlBasePath = mtlBasePath;
+    request->format = model.getVertexFormat();
+    request->depthStream = model.isDepthStreamEnabled();
+    request->startTime = std::chrono::high_resolution_clock::now();
+
+    // The worker only touches the request, never the model, so drawing other models is unaffected. Textures
+    // are decoded here too, leaving the GL thread only their upload.
+    request->processed = pool.submit([request]() {
+        MeshData& mesh = request->mesh;
+        if (!Model::processFile(request->objFilename, request->mtlBasePath, mesh) ||
+            !Model::prepareBuffers(mesh, mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size(),
+                request->format, request->depthStream, request->buffers)) {
+            return false;
+        }
+        Model::prepareTextures(mesh, Model::textureDirectoryFor(request->objFilename, request->mtlBasePath), false, nullptr,
+            request->buffers);
+        return true;
+    });
+
+    requests.push_back(request);
+    return Handle(request);
+}
+
+void ModelLoader::update() {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    frameStats = FrameStats();
+
+    size_t budget = uploadBytesPerFrame;
+    for (auto it = requests.begin(); it != requests.end() && budget > 0;) {
+        Request& request = **it;
+
+        if (request.state == LoadState::Processing) {
+            if (request.processed.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                ++it;
+                continue;
+            }
+
+            bool processed = request.processed.get();
+            const Model::PreparedBuffers& buffers = request.buffers;
+            request.bytesTotal = buffers.vertexByteCount + buffers.indexByteCount + buffers.depthVertices.size() + buffers.depthIndices.size() +
+                buffers.textureByteCount;
+            if (!processed || !request.model->beginUpload(std::move(request.mesh), std::move(request.buffers))) {
+                std::cerr << "Failed to load model: " << request.objFilename << std::endl;
+                request.state = LoadState::Failed;
+                it = requests.erase(it);
+                continue;
+            }
+            request.state = LoadState::Uploading;
+        }
+
+        size_t uploaded = 0;
+        bool done = request.model->uploadStep(budget, uploaded);
+        request.bytesUploaded += uploaded;
+        ++request.uploadFrames;
+        frameStats.bytesUploaded += uploaded;
+
+        if (!done) {
+            // The byte budget ran out, possibly on a texture that did not fit
+            budget = 0;
+            break;
+        }
+        budget -= std::min(budget, uploaded);
+
+        auto endTime = std::chrono::high_resolution_clock::now();
+        std::cout << "Loaded model " << request.objFilename << " in "
+            << std::chrono::duration<float, std::milli>(endTime - request.startTime).count() << " ms, uploaded over "
+            << request.uploadFrames << " frames" << std::endl;
+        request.state = LoadState::Ready;
+        it = requests.erase(it);
+    }
+
+    frameStats.pendingLoads = requests.size();
+    auto endTime = std::chrono::high_resolution_clock::now();
+    frameStats.uploadMilliseconds = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
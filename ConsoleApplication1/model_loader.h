@@ -0,0 +1,96 @@
+#pragma once
+#ifndef MODEL_LOADER_H
+#define MODEL_LOADER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+#include "mesh_data.h"
+#include "models.h"
+
+class ThreadPool;
+
+// Loads models without stalling the frame: parsing, processing, buffer preparation and texture decoding
+// run on a worker pool, and the results are copied into GL buffers and textures from update() on the GL
+// thread, at most uploadBytesPerFrame bytes per frame; a texture larger than that gets a frame to itself.
+class ModelLoader {
+public:
+    enum class LoadState {
+        Processing,  // Parsing and building LODs on a worker
+        Uploading,   // Waiting for or inside its per-frame upload slices
+        Ready,       // The model can be drawn
+        Failed,
+    };
+
+    struct Request;
+
+    // Returned by load() straight away; a default-constructed handle refers to no load
+    class Handle {
+    public:
+        Handle() = default;
+        bool valid() const { return request != nullptr; }
+        LoadState state() const;
+        bool ready() const { return valid() && state() == LoadState::Ready; }
+        bool failed() const { return valid() && state() == LoadState::Failed; }
+        // Fraction of the buffer and texture bytes uploaded so far
+        float uploadProgress() const;
+
+    private:
+        friend class ModelLoader;
+        explicit Handle(std::shared_ptr<Request> request) : request(std::move(request)) {}
+        std::shared_ptr<Request> request;
+    };
+
+    struct FrameStats {
+        size_t bytesUploaded = 0;
+        size_t pendingLoads = 0;
+        double uploadMilliseconds = 0.0;
+    };
+
+    static const size_t DEFAULT_UPLOAD_BYTES_PER_FRAME = 4 * 1024 * 1024;
+
+    explicit ModelLoader(size_t uploadBytesPerFrame = DEFAULT_UPLOAD_BYTES_PER_FRAME);
+    ModelLoader(size_t uploadBytesPerFrame, ThreadPool& pool);
+
+    // Starts loading an OBJ into model with its current vertex format and depth stream setting. model must
+    // outlive the load and should not be drawn before the handle is ready.
+    Handle load(Model& model, const std::string& objFilename, const std::string& mtlBasePath);
+
+    // Call once per frame on the GL thread. Processed loads are uploaded oldest first; one still processing
+    // does not hold up the ones behind it.
+    void update();
+
+    const FrameStats& lastFrameStats() const { return frameStats; }
+
+private:
+    ThreadPool& pool;
+    size_t uploadBytesPerFrame;
+    std::deque<std::shared_ptr<Request>> requests;
+    FrameStats frameStats;
+};
+
+// Shared between the loader, its worker task and the handles
+struct ModelLoader::Request {
+    Model* model = nullptr;
+    std::string objFilename;
+    std::string mtlBasePath;
+    VertexFormat format = VertexFormat::Float;
+    bool depthStream = false;
+
+    // Written by the worker, read on the GL thread once processed is ready
+    MeshData mesh;
+    Model::PreparedBuffers buffers;
+    std::future<bool> processed;
+
+    std::atomic<LoadState> state{ LoadState::Processing };
+    std::atomic<size_t> bytesUploaded{ 0 };
+    std::atomic<size_t> bytesTotal{ 0 };
+    size_t uploadFrames = 0;
+    std::chrono::high_resolution_clock::time_point startTime;
+};
+
+#endif // MODEL_LOADER_H
@@ -1,56 +1,380 @@
 #include "models.h"
+#include "lod_selector.h"
+#include "gltf_file.h"
+#include "index_buffer.h"
+#include "instance_buffer.h"
+#include "mesh_file.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "meshlets.h"
+#include "obj_parser.h"
+#include "position_stream.h"
+#include "renderer.h"
+#include "textures.h"
+#include "thread_pool.h"
+#include "triangle_bvh.h"
+#include "vertex_layout_gl.h"
+#include "vertex_quantization.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
-#include <unordered_map>
+#include <map>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-Model::Model() : VAO(0), VBO(0), EBO(0), isInitialized(false), modelMatrix(glm::mat4(1.0f)) {}
+Model::Model() : vertexStream(GeometryPool::Stream::Float), depthStreamEnabled(false), isInitialized(false), modelMatrix(glm::mat4(1.0f)), worldToObject(glm::mat4(1.0f)), vertexCount(0), indexCount(0), currentLod(0),
+    vertexFormat(VertexFormat::Float) {}
 
 Model::~Model() {
     cleanup();
 }
 
+// Everything up to and including the last path separator
+static std::string directoryOf(const std::string& path) {
+    size_t separator = path.find_last_of("/\\");
+    return separator == std::string::npos ? std::string() : path.substr(0, separator + 1);
+}
+
+std::string Model::textureDirectoryFor(const std::string& objFilename, const std::string& mtlBasePath) {
+    // MTL texture paths are relative to the MTL file; mtlBasePath is its directory when given as one
+    std::string textureDirectory = directoryOf(mtlBasePath);
+    if (textureDirectory.empty() || textureDirectory.size() != mtlBasePath.size()) {
+        textureDirectory = directoryOf(objFilename);
+    }
+    return textureDirectory;
+}
+
+bool Model::processFile(const std::string& objFilename, const std::string& mtlBasePath, MeshData& mesh) {
+    try {
+        // Streams the OBJ straight into deduplicated vertices instead of building tinyobj's arrays first
+        ObjParser::Stats parseStats;
+        if (!ObjParser::load(objFilename, mtlBasePath, mesh, &parseStats, &ThreadPool::shared())) {
+            std::cerr << "Failed to process model data" << std::endl;
+            return false;
+        }
+
+        std::cout << "Parsed " << parseStats.triangles << " triangles into " << mesh.vertices.size() << " unique vertices in "
+            << parseStats.milliseconds << " ms (" << parseStats.megabytesPerSecond() << " MB/s, " << parseStats.chunks << " slices)" << std::endl;
+
+        // Cooked meshes get their LOD chain and optimization from the cooker; OBJ loads pay for it here
+        auto startTime = std::chrono::high_resolution_clock::now();
+        MeshSimplifier::buildLodChain(mesh, MeshSimplifier::defaultLodRatios(), MeshSimplifier::defaultOptions());
+        auto endTime = std::chrono::high_resolution_clock::now();
+        std::cout << "Built " << mesh.lods.size() - 1 << " LODs in "
+            << std::chrono::duration<float, std::milli>(endTime - startTime).count() << " ms:";
+        for (size_t level = 0; level < mesh.lods.size(); ++level) {
+            std::cout << " [" << mesh.lodIndexCount(level) / 3 << " tris, error " << mesh.lods[level].error << "]";
+        }
+        std::cout << std::endl;
+
+        startTime = std::chrono::high_resolution_clock::now();
+        MeshOptimizer::CacheStats before = MeshOptimizer::analyzeVertexCache(mesh);
+        MeshOptimizer::optimize(mesh);
+        MeshOptimizer::CacheStats after = MeshOptimizer::analyzeVertexCache(mesh);
+        endTime = std::chrono::high_resolution_clock::now();
+        std::cout << "Optimized mesh in " << std::chrono::duration<float, std::milli>(endTime - startTime).count()
+            << " ms: ACMR " << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+
+        // Meshlets are cut from the final index order
+        MeshletBuilder::build(mesh);
+        std::cout << "Built " << mesh.meshlets.size() << " meshlets" << std::endl;
+
+        TriangleBvh::BuildStats bvhStats;
+        TriangleBvh::build(mesh, &ThreadPool::shared(), &bvhStats);
+        std::cout << "Built triangle BVH in " << bvhStats.milliseconds << " ms: " << bvhStats.nodes << " nodes, "
+            << bvhStats.packets << " packets, depth " << bvhStats.depth << std::endl;
+        std::cout << "Split into " << mesh.lods[0].submeshCount << " submeshes over " << mesh.materials.size()
+            << " materials" << std::endl;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Exception while loading model: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
 bool Model::loadFromFile(const std::string& objFilename, const std::string& mtlBasePath) {
     // Clean up any existing resources first
     cleanup();
 
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string warn, err;
+    MeshData mesh;
+    if (!processFile(objFilename, mtlBasePath, mesh)) {
+        return false;
+    }
+
+    // The same steps ModelLoader spreads over threads and frames, run back to back
+    PreparedBuffers buffers;
+    if (!prepareBuffers(mesh, mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size(),
+        vertexFormat, depthStreamEnabled, buffers)) {
+        std::cerr << "Failed to setup OpenGL buffers" << std::endl;
+        cleanup();
+        return false;
+    }
+    prepareTextures(mesh, textureDirectoryFor(objFilename, mtlBasePath), false, nullptr, buffers);
+    if (!beginUpload(std::move(mesh), std::move(buffers))) {
+        std::cerr << "Failed to setup OpenGL buffers" << std::endl;
+        cleanup();
+        return false;
+    }
+
+    size_t bytesUploaded = 0;
+    return uploadStep(SIZE_MAX, bytesUploaded);
+}
+
+bool Model::loadFromCookedFile(const std::string& meshFilename) {
+    cleanup();
 
-    bool success = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, objFilename.c_str(),
-        mtlBasePath.empty() ? nullptr : mtlBasePath.c_str());
+    auto startTime = std::chrono::high_resolution_clock::now();
 
-    if (!warn.empty()) std::cout << "Warning: " << warn << std::endl;
-    if (!err.empty()) {
-        std::cerr << "Error: " << err << std::endl;
+    MeshFile file;
+    if (!file.open(meshFilename)) {
+        std::cerr << "Failed to load cooked model: " << meshFilename << std::endl;
         return false;
     }
-    if (!success) {
-        std::cerr << "Failed to load model: " << objFilename << std::endl;
+    if (!file.hasVertexLayout()) {
+        std::cerr << "Cooked model has an unsupported vertex layout: " << meshFilename << std::endl;
         return false;
     }
 
-    // Process the loaded data
-    if (!processModelData(attrib, shapes)) {
-        std::cerr << "Failed to process model data" << std::endl;
+    // Only the small tables are copied; the blobs are uploaded from the mapping, the indices as the
+    // cooker packed them
+    const MeshFileHeader& header = file.header();
+    MeshData mesh;
+    mesh.boundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+    mesh.boundsMax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+
+    size_t sphereSize = 0;
+    const float* sphere = static_cast<const float*>(file.section(MESH_SECTION_SPHERE, sphereSize));
+    if (sphere != nullptr && sphereSize >= 4 * sizeof(float)) {
+        mesh.sphereCenter = glm::vec3(sphere[0], sphere[1], sphere[2]);
+        mesh.sphereRadius = sphere[3];
+    }
+    else {
+        mesh.sphereCenter = (mesh.boundsMin + mesh.boundsMax) * 0.5f;
+        mesh.sphereRadius = glm::length(mesh.boundsMax - mesh.boundsMin) * 0.5f;
+    }
+
+    size_t submeshCount = 0;
+    const Submesh* submeshes = file.submeshes(submeshCount);
+    mesh.submeshes.assign(submeshes, submeshes + submeshCount);
+    IndexLayout packedLayout = file.indexLayout();
+
+    size_t lodCount = 0;
+    const MeshLod* lods = file.lods(lodCount);
+    mesh.lods.assign(lods, lods + lodCount);
+    mesh.ensureBaseLod();
+
+    size_t meshletCount = 0, meshletOffsetCount = 0;
+    const Meshlet* meshlets = file.meshlets(meshletCount);
+    const uint32_t* meshletOffsets = file.meshletOffsets(meshletOffsetCount);
+    if (meshlets != nullptr && meshletOffsetCount == submeshCount + 1) {
+        mesh.meshlets.assign(meshlets, meshlets + meshletCount);
+        mesh.meshletOffsets.assign(meshletOffsets, meshletOffsets + meshletOffsetCount);
+    }
+
+    // Files cooked before the hierarchy was stored get one built from the mapping
+    size_t bvhNodeCount = 0, bvhPacketCount = 0;
+    const TriangleBvhNode* bvhNodes = file.bvhNodes(bvhNodeCount);
+    const TrianglePacket* bvhPackets = file.bvhPackets(bvhPacketCount);
+    if (bvhNodes != nullptr && bvhPackets != nullptr) {
+        mesh.bvhNodes.assign(bvhNodes, bvhNodes + bvhNodeCount);
+        mesh.bvhPackets.assign(bvhPackets, bvhPackets + bvhPacketCount);
+    }
+    else {
+        std::vector<uint32_t> indices;
+        IndexPacker::unpack(file.indexData(), static_cast<size_t>(header.indexCount), packedLayout, mesh.submeshes, indices);
+        TriangleBvh::build(mesh, static_cast<const Vertex*>(file.vertexData()), indices.data(), &ThreadPool::shared());
+    }
+
+    if (!file.materials(mesh.materials)) {
+        std::cerr << "Ignoring the materials of " << meshFilename << std::endl;
+    }
+
+    // The upload finishes before file goes out of scope, so float vertices and the indices can stay in the mapping
+    PreparedBuffers buffers;
+    size_t bytesUploaded = 0;
+    if (!prepareBuffers(mesh, file.vertexData(), static_cast<size_t>(header.vertexCount),
+        file.indexData(), static_cast<size_t>(header.indexCount), vertexFormat, depthStreamEnabled, buffers, &packedLayout)) {
+        std::cerr << "Failed to setup OpenGL buffers" << std::endl;
+        cleanup();
         return false;
     }
+    prepareTextures(mesh, directoryOf(meshFilename), true, nullptr, buffers);
+    if (!beginUpload(std::move(mesh), std::move(buffers)) || !uploadStep(SIZE_MAX, bytesUploaded)) {
+        std::cerr << "Failed to setup OpenGL buffers" << std::endl;
+        cleanup();
+        return false;
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    std::cout << "Loaded cooked model " << meshFilename << " (" << header.vertexCount << " vertices, "
+        << header.indexCount << " indices) in " << std::chrono::duration<float, std::milli>(endTime - startTime).count()
+        << " ms" << std::endl;
+    return true;
+}
+
+bool Model::loadFromGlbFile(const std::string& glbFilename) {
+    cleanup();
 
-    // Setup OpenGL buffers
-    if (!setupBuffers()) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    GltfFile file;
+    MeshData mesh;
+    GltfMeshSource source;
+    if (!file.open(glbFilename) || !file.readMesh(mesh, source)) {
+        std::cerr << "Failed to load glTF model: " << glbFilename << std::endl;
+        return false;
+    }
+
+    // Directly usable vertices stay in the mapping, which outlives the upload below
+    bool direct = source.directVertices != nullptr;
+    const void* vertices = direct ? static_cast<const void*>(source.directVertices) : static_cast<const void*>(mesh.vertices.data());
+    size_t triangleCount = mesh.indices.size() / 3;
+    TriangleBvh::build(mesh, direct ? source.directVertices : mesh.vertices.data(), mesh.indices.data(), &ThreadPool::shared());
+    size_t materialCount = mesh.materials.size();
+    PreparedBuffers buffers;
+    size_t bytesUploaded = 0;
+    if (!prepareBuffers(mesh, vertices, source.vertexCount, mesh.indices.data(), mesh.indices.size(), vertexFormat,
+        depthStreamEnabled, buffers)) {
+        std::cerr << "Failed to setup OpenGL buffers" << std::endl;
+        cleanup();
+        return false;
+    }
+    prepareTextures(mesh, directoryOf(glbFilename), false, &file, buffers);
+    if (!beginUpload(std::move(mesh), std::move(buffers)) || !uploadStep(SIZE_MAX, bytesUploaded)) {
         std::cerr << "Failed to setup OpenGL buffers" << std::endl;
         cleanup();
         return false;
     }
 
-    isInitialized = true;
+    auto endTime = std::chrono::high_resolution_clock::now();
+    std::cout << "Loaded glTF model " << glbFilename << " (" << source.vertexCount << " vertices, " << triangleCount << " triangles, "
+        << materialCount << " materials, " << (direct ? "direct" : "copied") << " vertices) in "
+        << std::chrono::duration<float, std::milli>(endTime - startTime).count() << " ms" << std::endl;
+    return true;
+}
+
+bool Model::saveCookedFile(const std::string& meshFilename) const {
+    if (meshData.vertices.empty()) {
+        std::cerr << "No CPU mesh data to save (cooked models are not kept in memory)" << std::endl;
+        return false;
+    }
+    return MeshFile::write(meshFilename, meshData);
+}
+
+void Model::draw(GLuint shaderProgram, RenderPass pass) const {
+    drawLevel(shaderProgram, 0, pass);
+}
+
+void Model::getWorldBounds(glm::vec3& boxMin, glm::vec3& boxMax) const {
+    // Each world axis spans the object extents weighted by the absolute matrix row
+    glm::vec3 center = glm::vec3(modelMatrix * glm::vec4((meshData.boundsMin + meshData.boundsMax) * 0.5f, 1.0f));
+    glm::vec3 extent = (meshData.boundsMax - meshData.boundsMin) * 0.5f;
+    glm::vec3 worldExtent(0.0f);
+    for (int column = 0; column < 3; ++column) {
+        worldExtent += glm::abs(glm::vec3(modelMatrix[column])) * extent[column];
+    }
+    boxMin = center - worldExtent;
+    boxMax = center + worldExtent;
+}
+
+float Model::maxAxisScale() const {
+    return std::max({ glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])),
+        glm::length(glm::vec3(modelMatrix[2])) });
+}
+
+void Model::getWorldBoundingSphere(glm::vec3& center, float& radius) const {
+    center = glm::vec3(modelMatrix * glm::vec4(meshData.sphereCenter, 1.0f));
+    radius = meshData.sphereRadius * maxAxisScale();
+}
+
+bool Model::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, TriangleBvh::RayHit& hit) const {
+    // An affine map keeps the ray parameter, so distances need no conversion; normals go back through the inverse transpose
+    glm::vec3 localOrigin = glm::vec3(worldToObject * glm::vec4(origin, 1.0f));
+    glm::vec3 localDirection = glm::vec3(worldToObject * glm::vec4(direction, 0.0f));
+    if (!TriangleBvh::raycast(meshData, localOrigin, localDirection, maxDistance, hit)) {
+        return false;
+    }
+    hit.normal = glm::normalize(glm::vec3(glm::transpose(worldToObject) * glm::vec4(hit.normal, 0.0f)));
     return true;
 }
 
-void Model::draw(GLuint shaderProgram) const {
+// Brings object-space contacts back to world space under a uniform scale
+static void contactsToWorld(const glm::mat4& modelMatrix, float scale, std::vector<TriangleBvh::Contact>& contacts) {
+    for (TriangleBvh::Contact& contact : contacts) {
+        contact.point = glm::vec3(modelMatrix * glm::vec4(contact.point, 1.0f));
+        contact.normal = glm::normalize(glm::vec3(modelMatrix * glm::vec4(contact.normal, 0.0f)));
+        contact.depth *= scale;
+    }
+}
+
+void Model::overlapSphere(const glm::vec3& center, float radius, std::vector<TriangleBvh::Contact>& contacts) const {
+    float scale = glm::length(glm::vec3(modelMatrix[0]));
+    TriangleBvh::overlapSphere(meshData, glm::vec3(worldToObject * glm::vec4(center, 1.0f)), radius / scale, contacts);
+    contactsToWorld(modelMatrix, scale, contacts);
+}
+
+void Model::overlapCapsule(const glm::vec3& a, const glm::vec3& b, float radius, std::vector<TriangleBvh::Contact>& contacts) const {
+    float scale = glm::length(glm::vec3(modelMatrix[0]));
+    TriangleBvh::overlapCapsule(meshData, glm::vec3(worldToObject * glm::vec4(a, 1.0f)), glm::vec3(worldToObject * glm::vec4(b, 1.0f)),
+        radius / scale, contacts);
+    contactsToWorld(modelMatrix, scale, contacts);
+}
+
+void Model::draw(GLuint shaderProgram, LodSelector& lodSelector, const glm::vec3& cameraPosition, const Frustum* frustum, RenderPass pass) {
+    if (!isInitialized) {
+        std::cerr << "Attempting to draw uninitialized model" << std::endl;
+        return;
+    }
+
+    glm::vec3 center;
+    float radius;
+    getWorldBoundingSphere(center, radius);
+
+    currentLod = lodSelector.select(meshData, center, radius, maxAxisScale(), cameraPosition, currentLod);
+    if (frustum != nullptr && !meshData.meshlets.empty()) {
+        drawLevelCulled(shaderProgram, currentLod, *frustum, cameraPosition, pass);
+        lodSelector.recordDraw(meshletStats.trianglesVisible, meshData.lodIndexCount(0) / 3);
+    }
+    else {
+        lodSelector.recordDraw(meshData.lodIndexCount(currentLod) / 3, meshData.lodIndexCount(0) / 3);
+        drawLevel(shaderProgram, currentLod, pass);
+    }
+}
+
+void Model::drawLevelCulled(GLuint shaderProgram, size_t level, const Frustum& frustum, const glm::vec3& cameraPosition, RenderPass pass) {
+    // Meshlet bounds are in object space, so bring the frustum and camera there instead
+    Frustum localFrustum = frustum.toLocalSpace(modelMatrix);
+    glm::vec3 localCamera = glm::vec3(worldToObject * glm::vec4(cameraPosition, 1.0f));
+
+    meshletDraws.clear();
+    meshletStats = MeshletCuller::Stats();
+    setShaderUniforms(shaderProgram, pass);
+    GeometryPool::shared().bindVertexArray(streamFor(pass));
+
+    // One multi-draw per submesh, so each material is still bound once
+    GLuint boundTexture = 0;
+    for (uint32_t submesh : drawOrder[level]) {
+        size_t firstDraw = meshletDraws.counts.size();
+        uint32_t first = meshData.meshletOffsets[submesh];
+        MeshletCuller::cull(meshData.meshlets.data() + first, meshData.meshletOffsets[submesh + 1] - first,
+            localFrustum, localCamera, indexLayoutFor(pass), submesh, meshletDraws, meshletStats);
+
+        size_t drawCount = meshletDraws.counts.size() - firstDraw;
+        if (drawCount == 0) {
+            continue;
+        }
+        if (pass == RenderPass::Color) {
+            bindMaterial(shaderProgram, meshData.submeshes[submesh].materialId, boundTexture);
+        }
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, meshletDraws.counts.data() + firstDraw, indexType(indexLayoutFor(pass)),
+            meshletDraws.offsets.data() + firstDraw, static_cast<GLsizei>(drawCount), meshletDraws.baseVertices.data() + firstDraw);
+    }
+}
+
+void Model::drawLevel(GLuint shaderProgram, size_t level, RenderPass pass) const {
     if (!isInitialized) {
         std::cerr << "Attempting to draw uninitialized model" << std::endl;
         return;
@@ -60,153 +384,484 @@ void Model::draw(GLuint shaderProgram) const {
     glm::mat4 tempModelMatrix = glm::translate(modelMatrix, glm::vec3(0.0f, 1.0f, 0.0f));  // Update the class member
 
     // Send the model matrix to the shader
-    GLint modelLoc = glGetUniformLocation(shaderProgram, "u_ModelMatrix");
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(modelMatrix));
+    setShaderUniforms(shaderProgram, pass);
+
+    // The pool's VAO stays bound afterwards, so the next model in the same format binds nothing
+    GeometryPool::shared().bindVertexArray(streamFor(pass));
+
+    if (indexCount != 0 && pass == RenderPass::Depth) {
+        // Without materials to bind between submeshes, the whole level is one base-vertex multi-draw
+        const IndexLayout& layout = indexLayoutFor(pass);
+        MeshletCuller::DrawList draws;
+        for (uint32_t submeshIndex : drawOrder[level]) {
+            const Submesh& submesh = meshData.submeshes[submeshIndex];
+            draws.counts.push_back(static_cast<GLsizei>(submesh.indexCount));
+            draws.offsets.push_back(reinterpret_cast<const void*>(layout.byteOffset(submesh.firstIndex)));
+            draws.baseVertices.push_back(layout.baseVertex(submeshIndex));
+        }
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, draws.counts.data(), indexType(layout), draws.offsets.data(),
+            static_cast<GLsizei>(draws.counts.size()), draws.baseVertices.data());
+    }
+    else if (indexCount != 0) {
+        // Each level's index ranges live in the shared index buffer; one range per material
+        const IndexLayout& layout = indexLayoutFor(pass);
+        GLuint boundTexture = 0;
+        for (uint32_t submeshIndex : drawOrder[level]) {
+            const Submesh& submesh = meshData.submeshes[submeshIndex];
+            if (pass == RenderPass::Color) {
+                bindMaterial(shaderProgram, submesh.materialId, boundTexture);
+            }
+            glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(submesh.indexCount), indexType(layout),
+                reinterpret_cast<const void*>(layout.byteOffset(submesh.firstIndex)), layout.baseVertex(submeshIndex));
+        }
+    }
+    else {
+        glDrawArrays(GL_TRIANGLES, static_cast<GLint>(vertexRange.offset), static_cast<GLsizei>(vertexCount));
+    }
+}
 
-    glBindVertexArray(VAO);
+void Model::drawInstanced(GLuint shaderProgram, const glm::mat4* transforms, size_t instanceCount, const glm::vec4* colors,
+    RenderPass pass, size_t level) const {
+    if (!isInitialized) {
+        std::cerr << "Attempting to draw uninitialized model" << std::endl;
+        return;
+    }
+    if (instanceCount == 0) {
+        return;
+    }
+    level = std::min(level, drawOrder.size() - 1);
+
+    setShaderUniforms(shaderProgram, pass);
+    GLint instancedLoc = glGetUniformLocation(shaderProgram, "u_Instanced");
+    glUniform1i(instancedLoc, 1);
+    GeometryPool::shared().bindVertexArray(streamFor(pass));
+    const IndexLayout& layout = indexLayoutFor(pass);
+
+    // Batches beyond the instance buffer's capacity go in several rounds of the same draws
+    InstanceBuffer& instances = InstanceBuffer::shared();
+    const size_t batchSize = InstanceBuffer::CAPACITY;
+    for (size_t first = 0; first < instanceCount; first += batchSize) {
+        size_t count = std::min(instanceCount - first, batchSize);
+        size_t offset = instances.upload(transforms + first, colors != nullptr ? colors + first : nullptr, count);
+        instances.bindAttributes(offset);
+
+        if (indexCount != 0) {
+            GLuint boundTexture = 0;
+            for (uint32_t submeshIndex : drawOrder[level]) {
+                const Submesh& submesh = meshData.submeshes[submeshIndex];
+                if (pass == RenderPass::Color) {
+                    bindMaterial(shaderProgram, submesh.materialId, boundTexture);
+                }
+                glDrawElementsInstancedBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(submesh.indexCount), indexType(layout),
+                    reinterpret_cast<const void*>(layout.byteOffset(submesh.firstIndex)), static_cast<GLsizei>(count),
+                    layout.baseVertex(submeshIndex));
+            }
+        }
+        else {
+            glDrawArraysInstanced(GL_TRIANGLES, static_cast<GLint>(vertexRange.offset), static_cast<GLsizei>(vertexCount),
+                static_cast<GLsizei>(count));
+        }
+    }
 
-    if (!indices.empty()) {
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
+    InstanceBuffer::unbindAttributes();
+    glUniform1i(instancedLoc, 0);
+}
+
+void Model::uploadMaterialTexture(size_t material, TextureImage& image) {
+    if (!image.empty()) {
+        materialTextures[material] = uploadTexture(image);
+        image = TextureImage();
+        return;
     }
-    else {
-        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices.size()));
+
+    // prepareTextures only reads a file for the first material naming it
+    const std::string& name = meshData.materials[material].diffuseTexture;
+    for (size_t other = 0; other < material && !name.empty(); ++other) {
+        if (meshData.materials[other].diffuseTexture == name) {
+            materialTextures[material] = materialTextures[other];
+            return;
+        }
+    }
+}
+
+void Model::buildDrawOrder() {
+    // Sorting by texture first keeps texture binds down when several materials share one
+    auto textureOf = [this](int32_t materialId) {
+        return materialId >= 0 && static_cast<size_t>(materialId) < materialTextures.size() ? materialTextures[materialId] : 0;
+    };
+
+    drawOrder.assign(meshData.lods.size(), std::vector<uint32_t>());
+    for (size_t level = 0; level < meshData.lods.size(); ++level) {
+        const MeshLod& lod = meshData.lods[level];
+        std::vector<uint32_t>& order = drawOrder[level];
+        for (uint32_t i = 0; i < lod.submeshCount; ++i) {
+            order.push_back(lod.firstSubmesh + i);
+        }
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            int32_t materialA = meshData.submeshes[a].materialId;
+            int32_t materialB = meshData.submeshes[b].materialId;
+            GLuint textureA = textureOf(materialA);
+            GLuint textureB = textureOf(materialB);
+            return textureA != textureB ? textureA < textureB : materialA < materialB;
+        });
+    }
+}
+
+void Model::bindMaterial(GLuint shaderProgram, int32_t materialId, GLuint& boundTexture) const {
+    glm::vec4 diffuse(1.0f);
+    GLuint texture = 0;
+    if (materialId >= 0 && static_cast<size_t>(materialId) < meshData.materials.size()) {
+        const Material& material = meshData.materials[materialId];
+        diffuse = glm::vec4(material.diffuse, material.dissolve);
+        texture = materialTextures[materialId];
     }
 
-    glBindVertexArray(0);
+    glUniform4fv(glGetUniformLocation(shaderProgram, "u_DiffuseColor"), 1, glm::value_ptr(diffuse));
+    glUniform1i(glGetUniformLocation(shaderProgram, "u_UseTexture"), texture != 0 ? 1 : 0);
+    if (texture != 0 && texture != boundTexture) {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glUniform1i(glGetUniformLocation(shaderProgram, "u_DiffuseTexture"), 0);
+        boundTexture = texture;
+    }
 }
 
+bool Model::usesDepthStream(RenderPass pass) const {
+    // Passes fall back to the full vertex stream when no dedicated one was built
+    return pass == RenderPass::Depth && depthVertexRange.valid();
+}
 
+GeometryPool::Stream Model::streamFor(RenderPass pass) const {
+    return usesDepthStream(pass) ? GeometryPool::Stream::Position : vertexStream;
+}
 
-bool Model::processModelData(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes) {
-    try {
-        vertices.clear();
-        indices.clear();
-        std::unordered_map<std::string, uint32_t> uniqueVertices;
-
-        for (const auto& shape : shapes) {
-            for (const auto& index : shape.mesh.indices) {
-                Vertex vertex{};  // Zero-initialize the vertex
-
-                // Check array bounds before accessing
-                if (index.vertex_index * 3 + 2 >= attrib.vertices.size()) {
-                    std::cerr << "Vertex index out of bounds" << std::endl;
-                    return false;
-                }
+const IndexLayout& Model::indexLayoutFor(RenderPass pass) const {
+    return usesDepthStream(pass) ? depthIndexLayout : indexLayout;
+}
 
-                // Get vertex position
-                vertex.position = {
-                    attrib.vertices[3 * index.vertex_index + 0],
-                    attrib.vertices[3 * index.vertex_index + 1],
-                    attrib.vertices[3 * index.vertex_index + 2]
-                };
-
-                // Get vertex normal if available
-                if (index.normal_index >= 0 && index.normal_index * 3 + 2 < attrib.normals.size()) {
-                    vertex.normal = {
-                        attrib.normals[3 * index.normal_index + 0],
-                        attrib.normals[3 * index.normal_index + 1],
-                        attrib.normals[3 * index.normal_index + 2]
-                    };
-                }
-                else {
-                    vertex.normal = { 0.0f, 1.0f, 0.0f };  // Default normal
-                }
+GLenum Model::indexType(const IndexLayout& layout) {
+    return layout.indexSize == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
 
-                // Get texture coordinates if available
-                if (index.texcoord_index >= 0 && index.texcoord_index * 2 + 1 < attrib.texcoords.size()) {
-                    vertex.texCoord = {
-                        attrib.texcoords[2 * index.texcoord_index + 0],
-                        attrib.texcoords[2 * index.texcoord_index + 1]
-                    };
-                }
-                else {
-                    vertex.texCoord = { 0.0f, 0.0f };  // Default UV
-                }
+void Model::setShaderUniforms(GLuint shaderProgram, RenderPass pass) const {
+    GLint modelLoc = glGetUniformLocation(shaderProgram, "u_ModelMatrix");
+    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(modelMatrix));
 
-                // Vertex deduplication
-                std::string vertexHash = std::to_string(vertex.position.x) + "," +
-                    std::to_string(vertex.position.y) + "," +
-                    std::to_string(vertex.position.z) + "," +
-                    std::to_string(vertex.normal.x) + "," +
-                    std::to_string(vertex.normal.y) + "," +
-                    std::to_string(vertex.normal.z) + "," +
-                    std::to_string(vertex.texCoord.x) + "," +
-                    std::to_string(vertex.texCoord.y);
-
-                if (uniqueVertices.count(vertexHash) == 0) {
-                    uniqueVertices[vertexHash] = static_cast<uint32_t>(vertices.size());
-                    vertices.push_back(vertex);
-                }
+    // The position stream is never quantized
+    VertexDecode decode = usesDepthStream(pass) ? VertexDecode() : vertexDecode;
 
-                indices.push_back(uniqueVertices[vertexHash]);
-            }
+    // Always set the decode state: it is per program, and other models may use another vertex format
+    glUniform3fv(glGetUniformLocation(shaderProgram, "u_PositionOffset"), 1, glm::value_ptr(decode.positionOffset));
+    glUniform3fv(glGetUniformLocation(shaderProgram, "u_PositionScale"), 1, glm::value_ptr(decode.positionScale));
+    glUniform1i(glGetUniformLocation(shaderProgram, "u_OctahedralNormals"), decode.octahedralNormals ? 1 : 0);
+    glUniform1f(glGetUniformLocation(shaderProgram, "u_NormalScale"), decode.normalScale);
+}
+
+static void logQuantization(size_t vertexCount, size_t vertexSize, const QuantizationError& error) {
+    std::cout << "Quantized " << vertexCount << " vertices to " << vertexSize << " bytes each ("
+        << vertexCount * sizeof(Vertex) / 1024 << " KB -> " << vertexCount * vertexSize / 1024 << " KB): position error max "
+        << error.maxPosition << " avg " << error.averagePosition << ", normal error max " << error.maxNormalDegrees
+        << " avg " << error.averageNormalDegrees << " deg, UV error max " << error.maxTexCoord << std::endl;
+}
+
+// Copies a typed vertex array into the byte blob of a PreparedBuffers
+template <typename T>
+static void storeVertices(const std::vector<T>& vertices, std::vector<uint8_t>& bytes) {
+    const uint8_t* begin = reinterpret_cast<const uint8_t*>(vertices.data());
+    bytes.assign(begin, begin + vertices.size() * sizeof(T));
+}
+
+bool Model::prepareBuffers(const MeshData& mesh, const void* vertexData, size_t numVertices, const void* indexData, size_t numIndices,
+    VertexFormat format, bool depthStream, PreparedBuffers& buffers, const IndexLayout* packedIndices) {
+    buffers = PreparedBuffers();
+    if (numVertices == 0) {
+        std::cerr << "No vertices to setup buffers" << std::endl;
+        return false;
+    }
+
+    try {
+        // Compact formats are quantized against the mesh bounds on the way to the GPU
+        const Vertex* vertices = static_cast<const Vertex*>(vertexData);
+        buffers.format = format;
+        buffers.vertexCount = numVertices;
+        buffers.indexCount = numIndices;
+        QuantizationError error;
+        switch (format) {
+        case VertexFormat::Compact16: {
+            std::vector<CompactVertex16> compact;
+            buffers.decode = VertexQuantizer::quantize(vertices, numVertices, mesh.boundsMin, mesh.boundsMax, compact, &error);
+            storeVertices(compact, buffers.vertexStorage);
+            logQuantization(numVertices, sizeof(CompactVertex16), error);
+            break;
+        }
+        case VertexFormat::Compact12: {
+            std::vector<CompactVertex12> compact;
+            buffers.decode = VertexQuantizer::quantize(vertices, numVertices, mesh.boundsMin, mesh.boundsMax, compact, &error);
+            storeVertices(compact, buffers.vertexStorage);
+            logQuantization(numVertices, sizeof(CompactVertex12), error);
+            break;
+        }
+        default:
+            buffers.decode = VertexDecode();
+            break;
+        }
+        if (buffers.vertexStorage.empty()) {
+            buffers.vertexBytes = static_cast<const uint8_t*>(vertexData);
+            buffers.vertexByteCount = numVertices * sizeof(Vertex);
+        }
+        else {
+            buffers.vertexBytes = buffers.vertexStorage.data();
+            buffers.vertexByteCount = buffers.vertexStorage.size();
         }
 
-        return !vertices.empty();
+        if (numIndices != 0 && packedIndices != nullptr) {
+            buffers.indexLayout = *packedIndices;
+            buffers.indexBytes = static_cast<const uint8_t*>(indexData);
+            buffers.indexByteCount = numIndices * packedIndices->indexSize;
+        }
+        else if (numIndices != 0) {
+            buffers.indexLayout = IndexPacker::pack(static_cast<const uint32_t*>(indexData), numIndices, mesh.submeshes, buffers.indexStorage);
+            buffers.indexBytes = buffers.indexStorage.data();
+            buffers.indexByteCount = buffers.indexStorage.size();
+            std::cout << "Packed " << numIndices << " indices as " << buffers.indexLayout.indexSize * 8 << "-bit ("
+                << numIndices * sizeof(uint32_t) / 1024 << " KB -> " << buffers.indexByteCount / 1024 << " KB)" << std::endl;
+        }
+
+        if (depthStream && numIndices != 0) {
+            // The position stream is rebuilt from absolute indices
+            std::vector<uint32_t> unpacked;
+            const uint32_t* indices = static_cast<const uint32_t*>(indexData);
+            if (packedIndices != nullptr) {
+                IndexPacker::unpack(indexData, numIndices, *packedIndices, mesh.submeshes, unpacked);
+                indices = unpacked.data();
+            }
+            std::vector<PositionVertex> positions;
+            std::vector<uint32_t> positionIndices;
+            buffers.depthStats = PositionStream::build(vertices, numVertices, indices, numIndices,
+                mesh.lodIndexCount(0), positions, positionIndices);
+            storeVertices(positions, buffers.depthVertices);
+            buffers.depthIndexLayout = IndexPacker::pack(positionIndices.data(), positionIndices.size(), mesh.submeshes, buffers.depthIndices);
+            buffers.depthIndexCount = positionIndices.size();
+
+            const PositionStreamStats& stats = buffers.depthStats;
+            std::cout << "Depth stream: " << stats.sourceVertices << " -> " << stats.positionVertices << " vertices, ACMR "
+                << stats.sourceAcmr << " -> " << stats.positionAcmr << ", " << stats.sourceBytesPerPass / 1024 << " KB -> "
+                << stats.positionBytesPerPass / 1024 << " KB per depth pass ("
+                << (stats.sourceBytesPerPass != 0 ? 100.0 - 100.0 * stats.positionBytesPerPass / stats.sourceBytesPerPass : 0.0)
+                << "% saved)" << std::endl;
+        }
+        return true;
     }
     catch (const std::exception& e) {
-        std::cerr << "Exception in processModelData: " << e.what() << std::endl;
+        std::cerr << "Exception in prepareBuffers: " << e.what() << std::endl;
+        buffers = PreparedBuffers();
         return false;
     }
 }
 
-bool Model::setupBuffers() {
-    if (vertices.empty()) {
-        std::cerr << "No vertices to setup buffers" << std::endl;
-        return false;
+void Model::prepareTextures(const MeshData& mesh, const std::string& textureDirectory, bool cookedTextures,
+    const GltfFile* embeddedImages, PreparedBuffers& buffers) {
+    const std::vector<Material>& materials = mesh.materials;
+    buffers.textures.assign(materials.size(), TextureImage());
+    buffers.textureByteCount = 0;
+
+    // Materials often share a texture; read each file once
+    std::vector<size_t> firstUses;
+    for (size_t material = 0; material < materials.size(); ++material) {
+        const std::string& name = materials[material].diffuseTexture;
+        bool first = !name.empty();
+        for (size_t other = 0; other < material && first; ++other) {
+            first = materials[other].diffuseTexture != name;
+        }
+        if (first) {
+            firstUses.push_back(material);
+        }
     }
 
-    // Clean up any existing buffers first
-    cleanup();
+    // Decoding dominates and the files are independent
+    ThreadPool::shared().parallelFor(firstUses.size(), [&](size_t i) {
+        size_t material = firstUses[i];
+        const std::string& name = materials[material].diffuseTexture;
+        TextureImage& image = buffers.textures[material];
+        size_t embeddedSize = 0;
+        const uint8_t* embedded = embeddedImages != nullptr ? embeddedImages->embeddedTexture(name, embeddedSize) : nullptr;
+        std::string path = textureDirectory + name;
+        bool loaded = false;
+        if (embedded != nullptr) {
+            loaded = decodeTextureFromMemory(embedded, embeddedSize, image);
+        }
+        else if (cookedTextures) {
+            // The cooker writes textures beside the mesh with a .tex extension
+            size_t dot = path.find_last_of('.');
+            size_t separator = path.find_last_of("/\\");
+            if (dot != std::string::npos && (separator == std::string::npos || dot > separator)) {
+                path.erase(dot);
+            }
+            path += ".tex";
+            loaded = readCookedTexture(path, image);
+        }
+        else {
+            loaded = decodeTexture(path, image);
+        }
+        if (!loaded) {
+            std::cerr << "Failed to load material texture: " << path << std::endl;
+        }
+    });
 
-    try {
-        // Generate and bind VAO
-        glGenVertexArrays(1, &VAO);
-        glBindVertexArray(VAO);
+    for (const TextureImage& image : buffers.textures) {
+        buffers.textureByteCount += image.byteCount();
+    }
+}
 
-        // Generate and setup VBO
-        glGenBuffers(1, &VBO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+bool Model::beginUpload(MeshData&& mesh, PreparedBuffers&& buffers) {
+    cleanup();
+    if (buffers.vertexCount == 0) {
+        std::cerr << "No vertices to setup buffers" << std::endl;
+        return false;
+    }
 
-        // Setup vertex attributes
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
-        glEnableVertexAttribArray(0);
+    // Moving the mesh keeps its vertex array in place, so borrowed float vertices stay valid
+    meshData = std::move(mesh);
+    pendingUpload.reset(new PendingUpload());
+    pendingUpload->buffers = std::move(buffers);
+    pendingUpload->buffers.textures.resize(meshData.materials.size());  // Untextured if prepareTextures was skipped
+    const PreparedBuffers& prepared = pendingUpload->buffers;
+
+    // Ranges are reserved in the shared pool now and filled by uploadStep
+    GeometryPool& pool = GeometryPool::shared();
+    vertexStream = GeometryPool::streamFor(prepared.format);
+    bool allocated = pool.allocateVertices(vertexStream, prepared.vertexCount, vertexRange) &&
+        (prepared.indexCount == 0 || pool.allocateIndices(prepared.indexByteCount, indexRange));
+    if (allocated && !prepared.depthVertices.empty()) {
+        allocated = pool.allocateVertices(GeometryPool::Stream::Position, prepared.depthVertices.size() / sizeof(PositionVertex), depthVertexRange) &&
+            pool.allocateIndices(prepared.depthIndices.size(), depthIndexRange);
+    }
+    if (!allocated) {
+        std::cerr << "Failed to allocate geometry pool ranges" << std::endl;
+        cleanup();
+        return false;
+    }
 
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-        glEnableVertexAttribArray(1);
+    vertexDecode = prepared.decode;
+    indexLayout = prepared.indexLayout;
+    indexLayout.firstByte = indexRange.offset;
+    indexLayout.firstVertex = static_cast<int32_t>(vertexRange.offset);
+    depthIndexLayout = prepared.depthIndexLayout;
+    depthIndexLayout.firstByte = depthIndexRange.offset;
+    depthIndexLayout.firstVertex = static_cast<int32_t>(depthVertexRange.offset);
+    depthStreamStats = prepared.depthStats;
+    vertexCount = prepared.vertexCount;
+    indexCount = prepared.indexCount;
+    trackMemory(prepared.vertexByteCount, prepared.indexByteCount, prepared.indexCount * sizeof(uint32_t));
+    trackMemory(prepared.depthVertices.size(), prepared.depthIndices.size(), prepared.depthIndexCount * sizeof(uint32_t));
+    return true;
+}
 
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
-        glEnableVertexAttribArray(2);
+bool Model::uploadStep(size_t byteBudget, size_t& bytesUploaded) {
+    bytesUploaded = 0;
+    if (pendingUpload == nullptr) {
+        return isInitialized;
+    }
 
-        if (!indices.empty()) {
-            glGenBuffers(1, &EBO);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+    PendingUpload& pending = *pendingUpload;
+    PreparedBuffers& prepared = pending.buffers;
+    struct Segment {
+        GLuint buffer;
+        size_t byteOffset;  // Of the model's range in the pool buffer
+        const uint8_t* data;
+        size_t size;
+    };
+    // Pool buffers may have been reallocated by other loads since the last step, so names are looked up each time
+    const GeometryPool& pool = GeometryPool::shared();
+    const GeometryPool::Stream depthStream = GeometryPool::Stream::Position;
+    const Segment segments[] = {
+        { pool.vertexBuffer(vertexStream), vertexRange.offset * GeometryPool::vertexSize(vertexStream), prepared.vertexBytes, prepared.vertexByteCount },
+        { pool.indexBuffer(), indexRange.offset, prepared.indexBytes, prepared.indexByteCount },
+        { pool.vertexBuffer(depthStream), depthVertexRange.offset * GeometryPool::vertexSize(depthStream), prepared.depthVertices.data(),
+            prepared.depthVertices.size() },
+        { pool.indexBuffer(), depthIndexRange.offset, prepared.depthIndices.data(), prepared.depthIndices.size() },
+    };
+    const size_t segmentCount = sizeof(segments) / sizeof(segments[0]);
+
+    // The copy-write target leaves the array and VAO element bindings alone
+    size_t remaining = byteBudget;
+    for (; pending.segment < segmentCount && remaining > 0; ++pending.segment, pending.offset = 0) {
+        const Segment& segment = segments[pending.segment];
+        if (segment.buffer == 0 || segment.size == 0) {
+            continue;
+        }
+        size_t chunk = std::min(remaining, segment.size - pending.offset);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, segment.buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, segment.byteOffset + pending.offset, chunk, segment.data + pending.offset);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        pending.offset += chunk;
+        remaining -= chunk;
+        bytesUploaded += chunk;
+        if (pending.offset < segment.size) {
+            return false;
         }
-
-        glBindVertexArray(0);
-        return true;
     }
-    catch (const std::exception& e) {
-        std::cerr << "Exception in setupBuffers: " << e.what() << std::endl;
-        cleanup();
+    if (pending.segment < segmentCount) {
         return false;
     }
+
+    // Then textures, already decoded. Each goes up whole, so one that does not fit waits for the next step,
+    // unless it is the first thing in the step, which could never fit it.
+    materialTextures.resize(meshData.materials.size(), 0);
+    for (; pending.nextMaterial < meshData.materials.size(); ++pending.nextMaterial) {
+        TextureImage& image = prepared.textures[pending.nextMaterial];
+        size_t imageBytes = image.byteCount();
+        if (imageBytes > remaining && bytesUploaded > 0) {
+            return false;
+        }
+        uploadMaterialTexture(pending.nextMaterial, image);
+        remaining -= std::min(remaining, imageBytes);
+        bytesUploaded += imageBytes;
+    }
+
+    buildDrawOrder();
+    pendingUpload.reset();
+    isInitialized = true;
+    return true;
+}
+
+Model::MemoryStats Model::memoryTotals;
+
+void Model::trackMemory(size_t vertexBytes, size_t indexBytes, size_t indexBytes32) {
+    memoryUsage.vertexBytes += vertexBytes;
+    memoryUsage.indexBytes += indexBytes;
+    memoryUsage.indexBytes32 += indexBytes32;
+    memoryTotals.vertexBytes += vertexBytes;
+    memoryTotals.indexBytes += indexBytes;
+    memoryTotals.indexBytes32 += indexBytes32;
 }
 
 void Model::cleanup() {
-    if (VAO != 0) {
-        glDeleteVertexArrays(1, &VAO);
-        VAO = 0;
-    }
-    if (VBO != 0) {
-        glDeleteBuffers(1, &VBO);
-        VBO = 0;
-    }
-    if (EBO != 0) {
-        glDeleteBuffers(1, &EBO);
-        EBO = 0;
+    // Ranges go back to the pool; other models keep drawing from the same buffers. Once the pool is
+    // released the context is gone with it, so the ranges and textures are only forgotten.
+    GeometryPool& pool = GeometryPool::shared();
+    pool.freeVertices(vertexStream, vertexRange);
+    pool.freeIndices(indexRange);
+    pool.freeVertices(GeometryPool::Stream::Position, depthVertexRange);
+    pool.freeIndices(depthIndexRange);
+    if (!materialTextures.empty() && !pool.isReleased()) {
+        // Shared textures appear once per material that uses them
+        std::sort(materialTextures.begin(), materialTextures.end());
+        materialTextures.erase(std::unique(materialTextures.begin(), materialTextures.end()), materialTextures.end());
+        materialTextures.erase(std::remove(materialTextures.begin(), materialTextures.end(), 0u), materialTextures.end());
+        glDeleteTextures(static_cast<GLsizei>(materialTextures.size()), materialTextures.data());
     }
+    materialTextures.clear();
+    drawOrder.clear();
+    pendingUpload.reset();
+    memoryTotals.vertexBytes -= memoryUsage.vertexBytes;
+    memoryTotals.indexBytes -= memoryUsage.indexBytes;
+    memoryTotals.indexBytes32 -= memoryUsage.indexBytes32;
+    memoryUsage = MemoryStats();
+    indexLayout = IndexLayout();
+    depthIndexLayout = IndexLayout();
+    vertexCount = 0;
+    indexCount = 0;
+    currentLod = 0;
     isInitialized = false;
 }
@@ -1,16 +1,29 @@
 #ifndef MODELS_H
 #define MODELS_H
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include <glm/glm.hpp>
 #include <GL/glew.h> // Make sure to include GLEW (or your OpenGL loader)
-#include <tiny_obj_loader.h> // Include TinyOBJ loader
+#include "frustum.h"
+#include "geometry_pool.h"
+#include "index_buffer.h"
+#include "mesh_data.h"
+#include "meshlets.h"
+#include "position_stream.h"
+#include "textures.h"
+#include "triangle_bvh.h"
+#include "vertex_quantization.h"
 
-struct Vertex {
-    glm::vec3 position;
-    glm::vec3 normal;
-    glm::vec2 texCoord;
+class GltfFile;
+class LodSelector;
+
+// Which vertex stream a draw reads. Depth covers depth-only and shadow passes, which only need positions.
+enum class RenderPass {
+    Color,
+    Depth,
 };
 
 class Model {
@@ -18,19 +31,156 @@ public:
     Model();
     ~Model();
     bool loadFromFile(const std::string& objFilename, const std::string& mtlBasePath);
-    void draw(GLuint shaderProgram) const;
+    // Loads a mesh written by saveCookedFile; the vertex and index blobs go straight from the file mapping to GL
+    bool loadFromCookedFile(const std::string& meshFilename);
+    // Loads the default scene of a binary glTF file. Vertices already in Vertex layout are uploaded straight
+    // from the file mapping; no LOD chain or meshlets are built.
+    bool loadFromGlbFile(const std::string& glbFilename);
+    bool saveCookedFile(const std::string& meshFilename) const;
+    void draw(GLuint shaderProgram, RenderPass pass = RenderPass::Color) const;
+    // Draws the level of detail the selector picks for this model as seen from cameraPosition. With a
+    // world-space frustum, meshlets outside it or facing away are skipped in a single multi-draw.
+    void draw(GLuint shaderProgram, LodSelector& lodSelector, const glm::vec3& cameraPosition, const Frustum* frustum = nullptr,
+        RenderPass pass = RenderPass::Color);
+    // Draws one copy of a level per transform in a single instanced draw per material, ignoring the model
+    // matrix. colors, when given, tint each copy.
+    void drawInstanced(GLuint shaderProgram, const glm::mat4* transforms, size_t instanceCount, const glm::vec4* colors = nullptr,
+        RenderPass pass = RenderPass::Color, size_t level = 0) const;
+    void setModelMatrix(const glm::mat4& matrix) { modelMatrix = matrix; worldToObject = glm::inverse(matrix); }
+    const glm::mat4& getModelMatrix() const { return modelMatrix; }
+    // False until the buffers are complete; ModelLoader fills them over several frames
+    bool isLoaded() const { return isInitialized; }
+    size_t getCurrentLod() const { return currentLod; }
+    // Object-space bounds, computed when the mesh is loaded
+    const glm::vec3& getBoundsMin() const { return meshData.boundsMin; }
+    const glm::vec3& getBoundsMax() const { return meshData.boundsMax; }
+    // The same bounds under the model matrix: the box enclosing the transformed box, and a sphere whose
+    // radius grows with the largest axis scale
+    void getWorldBounds(glm::vec3& boxMin, glm::vec3& boxMax) const;
+    void getWorldBoundingSphere(glm::vec3& center, float& radius) const;
+    // World-space hit tests against the base level's triangle hierarchy under the model matrix. Ray
+    // distances are in units of direction's length; sphere and capsule radii assume a uniform scale.
+    bool hasCollisionMesh() const { return !meshData.bvhNodes.empty(); }
+    // The CPU-side tables, including the hierarchy; vertices and indices are empty after a cooked load
+    const MeshData& getMeshData() const { return meshData; }
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, TriangleBvh::RayHit& hit) const;
+    void overlapSphere(const glm::vec3& center, float radius, std::vector<TriangleBvh::Contact>& contacts) const;
+    void overlapCapsule(const glm::vec3& a, const glm::vec3& b, float radius, std::vector<TriangleBvh::Contact>& contacts) const;
+    // GPU vertex layout used by the next load; compact formats trade a little precision for bandwidth
+    void setVertexFormat(VertexFormat format) { vertexFormat = format; }
+    VertexFormat getVertexFormat() const { return vertexFormat; }
+    // Keep a position-only stream for RenderPass::Depth, built on the next load
+    void setDepthStreamEnabled(bool enabled) { depthStreamEnabled = enabled; }
+    bool isDepthStreamEnabled() const { return depthStreamEnabled; }
+    const PositionStreamStats& getDepthStreamStats() const { return depthStreamStats; }
+
+    // GPU buffer bytes; indexBytes32 is what the indices would take without 16-bit packing
+    struct MemoryStats {
+        size_t vertexBytes = 0;
+        size_t indexBytes = 0;
+        size_t indexBytes32 = 0;
+    };
+    const MemoryStats& getMemoryUsage() const { return memoryUsage; }
+    // Sum over every loaded model
+    static const MemoryStats& getMemoryTotals() { return memoryTotals; }
+    // Meshlet culling counters from the last culled draw
+    const MeshletCuller::Stats& getMeshletStats() const { return meshletStats; }
+
+    // Vertex and index data in their final GPU form. Built without GL, so it can be made on any thread.
+    struct PreparedBuffers {
+        VertexFormat format = VertexFormat::Float;
+        VertexDecode decode;
+        size_t vertexCount = 0;
+        size_t indexCount = 0;
+        const uint8_t* vertexBytes = nullptr;  // vertexStorage, or the caller's float vertices when no conversion was needed
+        size_t vertexByteCount = 0;
+        std::vector<uint8_t> vertexStorage;
+        const uint8_t* indexBytes = nullptr;   // indexStorage, or the caller's indices when they came packed
+        size_t indexByteCount = 0;
+        std::vector<uint8_t> indexStorage;
+        IndexLayout indexLayout;
+        std::vector<uint8_t> depthVertices;   // Empty without a depth stream
+        std::vector<uint8_t> depthIndices;
+        size_t depthIndexCount = 0;
+        IndexLayout depthIndexLayout;
+        PositionStreamStats depthStats;
+        // Per material; empty for untextured materials and for ones sharing an earlier material's file
+        std::vector<TextureImage> textures;
+        size_t textureByteCount = 0;
+    };
+
+    // The load split into stages, as ModelLoader runs it: processFile, prepareBuffers and prepareTextures
+    // touch no GL state and can run on a worker; beginUpload and uploadStep must run on the GL thread.
+    static bool processFile(const std::string& objFilename, const std::string& mtlBasePath, MeshData& mesh);
+    // indexData holds 32-bit indices, or with packedIndices, indices already packed in that layout, which
+    // are uploaded from where they are like float vertices
+    static bool prepareBuffers(const MeshData& mesh, const void* vertexData, size_t numVertices, const void* indexData,
+        size_t numIndices, VertexFormat format, bool depthStream, PreparedBuffers& buffers, const IndexLayout* packedIndices = nullptr);
+    // Reads each material's diffuse texture into buffers.textures, after prepareBuffers, which resets them.
+    // Cooked models look for the cooked .tex next to the mesh; '#' names come from embeddedImages.
+    static void prepareTextures(const MeshData& mesh, const std::string& textureDirectory, bool cookedTextures,
+        const GltfFile* embeddedImages, PreparedBuffers& buffers);
+    // Takes over the mesh and creates empty GL buffers for the prepared data
+    bool beginUpload(MeshData&& mesh, PreparedBuffers&& buffers);
+    // Copies up to byteBudget more bytes into the buffers and then the textures, each texture whole; returns
+    // true once the model is drawable. SIZE_MAX finishes in one call.
+    bool uploadStep(size_t byteBudget, size_t& bytesUploaded);
+    // Where an OBJ's MTL texture paths are relative to
+    static std::string textureDirectoryFor(const std::string& objFilename, const std::string& mtlBasePath);
+    // Frees the model's pool ranges and textures. Safe to call again; global models should call it before
+    // GeometryPool::shared().release(), after which it touches no GL state.
+    void cleanup();
     // Other methods...
 
 private:
-    GLuint VAO, VBO, EBO;
+    // Where the model lives in GeometryPool::shared(); the depth ranges are empty without a position stream
+    GeometryPool::Stream vertexStream;
+    GeometryPool::Range vertexRange, indexRange;
+    GeometryPool::Range depthVertexRange, depthIndexRange;
+    bool depthStreamEnabled;
+    PositionStreamStats depthStreamStats;
+    IndexLayout indexLayout;       // How indexRange was packed, rebased onto the pool ranges
+    IndexLayout depthIndexLayout;  // Same for depthIndexRange
+    MemoryStats memoryUsage;
+    static MemoryStats memoryTotals;
     bool isInitialized;
     glm::mat4 modelMatrix;  // This should be a member variable
-    std::vector<Vertex> vertices;
-    std::vector<uint32_t> indices;
+    glm::mat4 worldToObject;  // Inverse of modelMatrix, for the hit tests and culled draws
+    MeshData meshData;      // No vertices or indices after a cooked load, which never copies the blobs to the CPU
+    size_t vertexCount;
+    size_t indexCount;
+    size_t currentLod;      // Level drawn last frame, for hysteresis
+    std::vector<GLuint> materialTextures;  // Diffuse texture per meshData.materials entry, 0 when untextured
+    std::vector<std::vector<uint32_t>> drawOrder;  // Per level: submesh indices sorted by texture, then material
+    MeshletCuller::DrawList meshletDraws;  // Reused between frames
+    MeshletCuller::Stats meshletStats;
+    VertexFormat vertexFormat;
+    VertexDecode vertexDecode;  // How the shader decodes the uploaded vertices
 
-    bool processModelData(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes);
-    bool setupBuffers();
-    void cleanup();
+    // Progress of an upload started by beginUpload
+    struct PendingUpload {
+        PreparedBuffers buffers;
+        size_t segment = 0;       // Buffer being filled: vertices, indices, depth vertices, depth indices
+        size_t offset = 0;        // Bytes of it already uploaded
+        size_t nextMaterial = 0;  // Textures are uploaded after the buffers
+    };
+    std::unique_ptr<PendingUpload> pendingUpload;
+
+    void drawLevel(GLuint shaderProgram, size_t level, RenderPass pass) const;
+    float maxAxisScale() const;  // Longest basis vector of modelMatrix
+    bool usesDepthStream(RenderPass pass) const;
+    GeometryPool::Stream streamFor(RenderPass pass) const;
+    const IndexLayout& indexLayoutFor(RenderPass pass) const;
+    static GLenum indexType(const IndexLayout& layout);
+    void trackMemory(size_t vertexBytes, size_t indexBytes, size_t indexBytes32);
+    void setShaderUniforms(GLuint shaderProgram, RenderPass pass) const;
+    void drawLevelCulled(GLuint shaderProgram, size_t level, const Frustum& frustum, const glm::vec3& cameraPosition, RenderPass pass);
+    // Uploads one material's decoded texture and frees the image, or shares the texture of an earlier
+    // material with the same file
+    void uploadMaterialTexture(size_t material, TextureImage& image);
+    void buildDrawOrder();
+    // Binds the material's uniforms, and its texture unless it is already bound
+    void bindMaterial(GLuint shaderProgram, int32_t materialId, GLuint& boundTexture) const;
 };
 
 
@@ -0,0 +1,563 @@
+#include "obj_parser.h"
+#include "mapped_file.h"
+#include "mesh_processing.h"
+#include "thread_pool.h"
+#include "vertex_dedup.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <unordered_map>
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static void skipSpaces(const char*& cursor, const char* end) {
+    while (cursor < end && isSpace(*cursor)) {
+        ++cursor;
+    }
+}
+
+// Splits [cursor, end) into lines without copying; lineEnd excludes the newline and any '\r'
+static bool nextLine(const char*& cursor, const char* end, const char*& lineBegin, const char*& lineEnd) {
+    if (cursor >= end) {
+        return false;
+    }
+    lineBegin = cursor;
+    const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+    lineEnd = newline != nullptr ? newline : end;
+    cursor = newline != nullptr ? newline + 1 : end;
+    if (lineEnd > lineBegin && lineEnd[-1] == '\r') {
+        --lineEnd;
+    }
+    return true;
+}
+
+// Reads the keyword at the start of a line and leaves cursor on its first argument
+static bool keyword(const char*& cursor, const char* end, const char* word) {
+    size_t length = std::strlen(word);
+    if (static_cast<size_t>(end - cursor) < length || std::memcmp(cursor, word, length) != 0 ||
+        (cursor + length < end && !isSpace(cursor[length]))) {
+        return false;
+    }
+    cursor += length;
+    skipSpaces(cursor, end);
+    return true;
+}
+
+// The rest of the line with trailing whitespace removed; names may contain spaces
+static std::string restOfLine(const char* cursor, const char* end) {
+    while (end > cursor && isSpace(end[-1])) {
+        --end;
+    }
+    return std::string(cursor, end);
+}
+
+// Everything up to and including the last path separator
+static std::string directoryOf(const std::string& path) {
+    size_t separator = path.find_last_of("/\\");
+    return separator == std::string::npos ? std::string() : path.substr(0, separator + 1);
+}
+
+bool ObjParser::parseFloat(const char*& cursor, const char* end, float& value) {
+    skipSpaces(cursor, end);
+    if (cursor < end && *cursor == '+') {
+        ++cursor;  // from_chars does not take an explicit plus sign
+    }
+    std::from_chars_result result = std::from_chars(cursor, end, value);
+    if (result.ec == std::errc::invalid_argument) {
+        return false;
+    }
+    if (result.ec == std::errc::result_out_of_range) {
+        value = 0.0f;  // In practice only denormal-range values, which the GPU flushes anyway
+    }
+    cursor = result.ptr;
+    return true;
+}
+
+bool ObjParser::parseInt(const char*& cursor, const char* end, int& value) {
+    skipSpaces(cursor, end);
+    bool negative = cursor < end && *cursor == '-';
+    if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+        ++cursor;
+    }
+    if (cursor >= end || *cursor < '0' || *cursor > '9') {
+        return false;
+    }
+    int result = 0;
+    while (cursor < end && *cursor >= '0' && *cursor <= '9') {
+        result = result * 10 + (*cursor - '0');
+        ++cursor;
+    }
+    value = negative ? -result : result;
+    return true;
+}
+
+// Parses up to count floats into values; missing trailing values keep what the caller put there
+static size_t parseFloats(const char*& cursor, const char* end, float* values, size_t count) {
+    size_t parsed = 0;
+    while (parsed < count && ObjParser::parseFloat(cursor, end, values[parsed])) {
+        ++parsed;
+    }
+    return parsed;
+}
+
+bool ObjParser::loadMtl(const std::string& filename, std::vector<Material>& materials, size_t* bytes) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        return false;
+    }
+    if (bytes != nullptr) {
+        *bytes = file.size();
+    }
+
+    const char* cursor = reinterpret_cast<const char*>(file.data());
+    const char* end = cursor + file.size();
+    const char* line = nullptr;
+    const char* lineEnd = nullptr;
+    Material* material = nullptr;
+    bool hasDissolve = false;
+
+    while (nextLine(cursor, end, line, lineEnd)) {
+        skipSpaces(line, lineEnd);
+        if (keyword(line, lineEnd, "newmtl")) {
+            // Same defaults as tinyobj, so both loaders produce the same materials
+            materials.emplace_back();
+            material = &materials.back();
+            material->name = restOfLine(line, lineEnd);
+            material->ambient = material->diffuse = material->specular = material->emission = glm::vec3(0.0f);
+            material->shininess = 1.0f;
+            material->dissolve = 1.0f;
+            hasDissolve = false;
+            continue;
+        }
+        if (material == nullptr) {
+            continue;
+        }
+
+        float values[3] = {};
+        if (keyword(line, lineEnd, "Ka")) {
+            parseFloats(line, lineEnd, values, 3);
+            material->ambient = glm::vec3(values[0], values[1], values[2]);
+        }
+        else if (keyword(line, lineEnd, "Kd")) {
+            parseFloats(line, lineEnd, values, 3);
+            material->diffuse = glm::vec3(values[0], values[1], values[2]);
+        }
+        else if (keyword(line, lineEnd, "Ks")) {
+            parseFloats(line, lineEnd, values, 3);
+            material->specular = glm::vec3(values[0], values[1], values[2]);
+        }
+        else if (keyword(line, lineEnd, "Ke")) {
+            parseFloats(line, lineEnd, values, 3);
+            material->emission = glm::vec3(values[0], values[1], values[2]);
+        }
+        else if (keyword(line, lineEnd, "Ns")) {
+            parseFloat(line, lineEnd, material->shininess);
+        }
+        else if (keyword(line, lineEnd, "d")) {
+            parseFloat(line, lineEnd, material->dissolve);
+            hasDissolve = true;
+        }
+        else if (keyword(line, lineEnd, "Tr")) {
+            // Transparency is the inverse of dissolve; d wins when both are given
+            if (!hasDissolve && parseFloat(line, lineEnd, values[0])) {
+                material->dissolve = 1.0f - values[0];
+            }
+        }
+        else if (keyword(line, lineEnd, "map_Kd")) {
+            std::string texture = restOfLine(line, lineEnd);
+            if (!texture.empty() && texture[0] == '-') {
+                // Texture options come first; the file name is the last word
+                size_t space = texture.find_last_of(" \t");
+                texture = space == std::string::npos ? std::string() : texture.substr(space + 1);
+            }
+            material->diffuseTexture = texture;
+        }
+    }
+    return true;
+}
+
+namespace {
+
+// A line-aligned slice of the OBJ. Slices are counted, parsed and deduplicated independently and then
+// merged in file order, which gives the same output as reading the file front to back.
+struct ObjChunk {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    size_t positionLines = 0, normalLines = 0, texCoordLines = 0, faceLines = 0;
+    size_t firstPosition = 0, firstNormal = 0, firstTexCoord = 0;  // Elements in the slices before this one
+
+    // Face corners with absolute element indices; UINT32_MAX when the corner has no normal or UV
+    struct Corner {
+        uint32_t position;
+        uint32_t normal;
+        uint32_t texCoord;
+    };
+    std::vector<Corner> corners;
+    std::vector<uint32_t> faceSizes;
+
+    // usemtl and mtllib lines, applied in order during the merge; triangle is how many of this slice's
+    // triangles come before the line
+    struct Statement {
+        size_t triangle;
+        bool library;
+        std::string argument;
+    };
+    std::vector<Statement> statements;
+
+    std::vector<Vertex> localVertices;   // Unique inside the slice, in order of first use
+    std::vector<uint32_t> localIndices;  // Fan-triangulated, into localVertices
+    std::vector<uint32_t> remap;         // localVertices index -> mesh.vertices index
+    size_t firstTriangle = 0;
+    bool outOfBounds = false;
+};
+
+}
+
+// Slices big enough that the merge and the per-slice tables stay cheap next to the parsing
+static const size_t CHUNK_BYTES = 4 * 1024 * 1024;
+
+// Recognises lines exactly as parseChunk does, since the counts place every slice's elements
+static void countLines(ObjChunk& chunk) {
+    const char* cursor = chunk.begin;
+    const char* line = nullptr;
+    const char* lineEnd = nullptr;
+    while (nextLine(cursor, chunk.end, line, lineEnd)) {
+        skipSpaces(line, lineEnd);
+        if (line == lineEnd || *line == '#') {
+            continue;
+        }
+
+        if (keyword(line, lineEnd, "v")) {
+            ++chunk.positionLines;
+        }
+        else if (keyword(line, lineEnd, "vn")) {
+            ++chunk.normalLines;
+        }
+        else if (keyword(line, lineEnd, "vt")) {
+            ++chunk.texCoordLines;
+        }
+        else if (keyword(line, lineEnd, "f")) {
+            ++chunk.faceLines;
+        }
+    }
+}
+
+// Fills the slice's elements in at its offsets and records its faces as element indices
+static void parseChunk(ObjChunk& chunk, std::vector<float>& positions, std::vector<float>& normals, std::vector<float>& texCoords) {
+    size_t positionCount = chunk.firstPosition;
+    size_t normalCount = chunk.firstNormal;
+    size_t texCoordCount = chunk.firstTexCoord;
+    size_t triangleCount = 0;
+    chunk.corners.reserve(chunk.faceLines * 3);
+    chunk.faceSizes.reserve(chunk.faceLines);
+
+    const char* cursor = chunk.begin;
+    const char* line = nullptr;
+    const char* lineEnd = nullptr;
+    while (nextLine(cursor, chunk.end, line, lineEnd)) {
+        skipSpaces(line, lineEnd);
+        if (line == lineEnd || *line == '#') {
+            continue;
+        }
+
+        if (keyword(line, lineEnd, "v")) {
+            float value[3] = {};
+            parseFloats(line, lineEnd, value, 3);
+            std::copy(value, value + 3, positions.begin() + positionCount * 3);
+            ++positionCount;
+        }
+        else if (keyword(line, lineEnd, "vn")) {
+            float value[3] = {};
+            parseFloats(line, lineEnd, value, 3);
+            std::copy(value, value + 3, normals.begin() + normalCount * 3);
+            ++normalCount;
+        }
+        else if (keyword(line, lineEnd, "vt")) {
+            float value[2] = {};
+            parseFloats(line, lineEnd, value, 2);
+            std::copy(value, value + 2, texCoords.begin() + texCoordCount * 2);
+            ++texCoordCount;
+        }
+        else if (keyword(line, lineEnd, "f")) {
+            size_t faceStart = chunk.corners.size();
+            int positionIndex = 0;
+            while (ObjParser::parseInt(line, lineEnd, positionIndex)) {
+                int texCoordIndex = 0;
+                int normalIndex = 0;
+                if (line < lineEnd && *line == '/') {
+                    ++line;
+                    if (line < lineEnd && *line != '/') {
+                        ObjParser::parseInt(line, lineEnd, texCoordIndex);
+                    }
+                    if (line < lineEnd && *line == '/') {
+                        ++line;
+                        ObjParser::parseInt(line, lineEnd, normalIndex);
+                    }
+                }
+
+                // 1-based, negative counts back from the latest element, 0 means absent
+                long long p = positionIndex > 0 ? positionIndex - 1LL : static_cast<long long>(positionCount) + positionIndex;
+                long long n = normalIndex > 0 ? normalIndex - 1LL
+                    : normalIndex < 0 ? static_cast<long long>(normalCount) + normalIndex : -1;
+                long long t = texCoordIndex > 0 ? texCoordIndex - 1LL
+                    : texCoordIndex < 0 ? static_cast<long long>(texCoordCount) + texCoordIndex : -1;
+                if (positionIndex == 0 || p < 0 || static_cast<size_t>(p) >= positionCount) {
+                    chunk.outOfBounds = true;
+                    return;
+                }
+
+                ObjChunk::Corner corner;
+                corner.position = static_cast<uint32_t>(p);
+                corner.normal = n >= 0 && static_cast<size_t>(n) < normalCount ? static_cast<uint32_t>(n) : UINT32_MAX;
+                corner.texCoord = t >= 0 && static_cast<size_t>(t) < texCoordCount ? static_cast<uint32_t>(t) : UINT32_MAX;
+                chunk.corners.push_back(corner);
+            }
+            size_t faceSize = chunk.corners.size() - faceStart;
+            chunk.faceSizes.push_back(static_cast<uint32_t>(faceSize));
+            triangleCount += faceSize > 2 ? faceSize - 2 : 0;
+        }
+        else if (keyword(line, lineEnd, "usemtl")) {
+            chunk.statements.push_back({ triangleCount, false, restOfLine(line, lineEnd) });
+        }
+        else if (keyword(line, lineEnd, "mtllib")) {
+            chunk.statements.push_back({ triangleCount, true, restOfLine(line, lineEnd) });
+        }
+        // o, g, s and other statements do not affect the mesh
+    }
+}
+
+// Turns the slice's corners into deduplicated vertices and fan-triangulated local indices
+static void buildChunkVertices(ObjChunk& chunk, const std::vector<float>& positions, const std::vector<float>& normals,
+    const std::vector<float>& texCoords) {
+    VertexDeduplicator uniqueVertices;
+    uniqueVertices.reserve(chunk.corners.size());
+    chunk.localVertices.reserve(chunk.corners.size());
+    std::vector<uint32_t> cornerVertices(chunk.corners.size());
+    for (size_t i = 0; i < chunk.corners.size(); ++i) {
+        const ObjChunk::Corner& corner = chunk.corners[i];
+        // Same defaults as MeshProcessor::makeVertex
+        Vertex vertex{};
+        size_t p = corner.position;
+        vertex.position = { positions[p * 3 + 0], positions[p * 3 + 1], positions[p * 3 + 2] };
+        if (corner.normal != UINT32_MAX) {
+            size_t n = corner.normal;
+            vertex.normal = { normals[n * 3 + 0], normals[n * 3 + 1], normals[n * 3 + 2] };
+        }
+        else {
+            vertex.normal = { 0.0f, 1.0f, 0.0f };
+        }
+        if (corner.texCoord != UINT32_MAX) {
+            size_t t = corner.texCoord;
+            vertex.texCoord = { texCoords[t * 2 + 0], texCoords[t * 2 + 1] };
+        }
+        cornerVertices[i] = uniqueVertices.insert(vertex, chunk.localVertices);
+    }
+    std::vector<ObjChunk::Corner>().swap(chunk.corners);
+
+    // Fan triangulation
+    size_t faceStart = 0;
+    for (uint32_t faceSize : chunk.faceSizes) {
+        for (size_t i = 2; i < faceSize; ++i) {
+            chunk.localIndices.push_back(cornerVertices[faceStart]);
+            chunk.localIndices.push_back(cornerVertices[faceStart + i - 1]);
+            chunk.localIndices.push_back(cornerVertices[faceStart + i]);
+        }
+        faceStart += faceSize;
+    }
+    std::vector<uint32_t>().swap(chunk.faceSizes);
+}
+
+// Loads the MTL files an mtllib line names into materials; returns the bytes read
+static size_t loadMtlLibrary(const std::string& objFilename, const std::string& mtlBasePath, const std::string& names,
+    std::vector<Material>& materials) {
+    std::string base = mtlBasePath.empty() ? directoryOf(objFilename) : mtlBasePath;
+
+    // Try the whole argument first, since names may contain spaces, then each word
+    std::vector<std::string> candidates = { names };
+    for (size_t start = 0; start < names.size();) {
+        size_t stop = std::min(names.find_first_of(" \t", start), names.size());
+        if (stop > start && stop - start != names.size()) {
+            candidates.push_back(names.substr(start, stop - start));
+        }
+        start = stop + 1;
+    }
+
+    size_t bytes = 0;
+    for (const std::string& candidate : candidates) {
+        if (ObjParser::loadMtl(base + candidate, materials, &bytes)) {
+            return bytes;
+        }
+    }
+    std::cout << "Warning: Material file [ " << names << " ] not found" << std::endl;
+    return 0;
+}
+
+bool ObjParser::load(const std::string& objFilename, const std::string& mtlBasePath, MeshData& mesh, Stats* stats, ThreadPool* pool) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    mesh.clear();
+
+    MappedFile file;
+    if (!file.open(objFilename)) {
+        std::cerr << "Failed to load model: " << objFilename << std::endl;
+        return false;
+    }
+
+    const char* begin = reinterpret_cast<const char*>(file.data());
+    const char* end = begin + file.size();
+
+    // Slice boundaries move forward to the next line start
+    size_t chunkCount = 1;
+    if (pool != nullptr && pool->threadCount() != 0) {
+        chunkCount = std::max<size_t>(1, file.size() / CHUNK_BYTES);
+    }
+    std::vector<ObjChunk> chunks(chunkCount);
+    const char* chunkBegin = begin;
+    for (size_t i = 0; i < chunkCount; ++i) {
+        const char* chunkEnd = i + 1 == chunkCount ? end : std::max(chunkBegin, begin + file.size() / chunkCount * (i + 1));
+        if (chunkEnd < end) {
+            const char* newline = static_cast<const char*>(std::memchr(chunkEnd, '\n', static_cast<size_t>(end - chunkEnd)));
+            chunkEnd = newline != nullptr ? newline + 1 : end;
+        }
+        chunks[i].begin = chunkBegin;
+        chunks[i].end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+    auto forEachChunk = [&](const std::function<void(size_t)>& body) {
+        if (pool != nullptr && chunkCount > 1) {
+            pool->parallelFor(chunkCount, body);
+        }
+        else {
+            for (size_t i = 0; i < chunkCount; ++i) {
+                body(i);
+            }
+        }
+    };
+
+    // Counting lines first costs one memchr pass and lets every array be allocated once, with each slice
+    // writing its elements at its own offset
+    forEachChunk([&](size_t i) { countLines(chunks[i]); });
+    size_t positionCount = 0, normalCount = 0, texCoordCount = 0;
+    for (ObjChunk& chunk : chunks) {
+        chunk.firstPosition = positionCount;
+        chunk.firstNormal = normalCount;
+        chunk.firstTexCoord = texCoordCount;
+        positionCount += chunk.positionLines;
+        normalCount += chunk.normalLines;
+        texCoordCount += chunk.texCoordLines;
+    }
+    std::vector<float> positions(positionCount * 3), normals(normalCount * 3), texCoords(texCoordCount * 2);
+
+    forEachChunk([&](size_t i) { parseChunk(chunks[i], positions, normals, texCoords); });
+    for (const ObjChunk& chunk : chunks) {
+        if (chunk.outOfBounds) {
+            std::cerr << "Vertex index out of bounds" << std::endl;
+            return false;
+        }
+    }
+    forEachChunk([&](size_t i) { buildChunkVertices(chunks[i], positions, normals, texCoords); });
+
+    // Statements and vertex ids are resolved in file order, so ids come out as a front-to-back read gives them
+    std::vector<Material> materials;
+    std::unordered_map<std::string, int32_t> materialIds;
+    std::vector<bool> materialUsed;
+    std::vector<int32_t> triangleMaterials;  // Stays empty until a usemtl names a known material
+    int32_t currentMaterial = -1;
+    size_t mtlBytes = 0;
+    size_t triangleCount = 0;
+    for (const ObjChunk& chunk : chunks) {
+        triangleCount += chunk.localIndices.size() / 3;
+    }
+    auto assignMaterial = [&](size_t first, size_t last) {
+        if (currentMaterial >= 0 && first < last) {
+            triangleMaterials.resize(triangleCount, -1);
+            std::fill(triangleMaterials.begin() + first, triangleMaterials.begin() + last, currentMaterial);
+        }
+    };
+
+    size_t expectedVertices = std::min(std::max({ positionCount, normalCount, texCoordCount }), triangleCount * 3);
+    VertexDeduplicator uniqueVertices;
+    if (chunkCount > 1) {
+        uniqueVertices.reserve(expectedVertices);
+        mesh.vertices.reserve(expectedVertices);
+    }
+    size_t firstTriangle = 0;
+    for (ObjChunk& chunk : chunks) {
+        chunk.firstTriangle = firstTriangle;
+        size_t chunkTriangles = chunk.localIndices.size() / 3;
+        size_t done = 0;
+        for (const ObjChunk::Statement& statement : chunk.statements) {
+            assignMaterial(firstTriangle + done, firstTriangle + statement.triangle);
+            done = statement.triangle;
+            if (statement.library) {
+                size_t firstNew = materials.size();
+                mtlBytes += loadMtlLibrary(objFilename, mtlBasePath, statement.argument, materials);
+                for (size_t m = firstNew; m < materials.size(); ++m) {
+                    materialIds[materials[m].name] = static_cast<int32_t>(m);
+                }
+                materialUsed.resize(materials.size(), false);
+            }
+            else {
+                auto found = materialIds.find(statement.argument);
+                currentMaterial = found != materialIds.end() ? found->second : -1;
+                if (currentMaterial >= 0) {
+                    materialUsed[currentMaterial] = true;
+                }
+            }
+        }
+        assignMaterial(firstTriangle + done, firstTriangle + chunkTriangles);
+        firstTriangle += chunkTriangles;
+
+        if (chunkCount == 1) {
+            mesh.vertices = std::move(chunk.localVertices);
+            mesh.indices = std::move(chunk.localIndices);
+            break;
+        }
+        // Each slice lists its vertices in order of first use, so inserting them slice by slice assigns
+        // the ids a single pass would
+        chunk.remap.resize(chunk.localVertices.size());
+        for (size_t i = 0; i < chunk.localVertices.size(); ++i) {
+            chunk.remap[i] = uniqueVertices.insert(chunk.localVertices[i], mesh.vertices);
+        }
+        std::vector<Vertex>().swap(chunk.localVertices);
+    }
+    if (chunkCount > 1) {
+        mesh.indices.resize(triangleCount * 3);
+        forEachChunk([&](size_t i) {
+            const ObjChunk& chunk = chunks[i];
+            uint32_t* output = mesh.indices.data() + chunk.firstTriangle * 3;
+            for (size_t index = 0; index < chunk.localIndices.size(); ++index) {
+                output[index] = chunk.remap[chunk.localIndices[index]];
+            }
+        });
+    }
+
+    if (mesh.vertices.empty()) {
+        std::cerr << "No faces in model: " << objFilename << std::endl;
+        return false;
+    }
+
+    std::vector<int32_t> materialRemap = MeshProcessor::mergeMaterials(materials, materialUsed, mesh.materials);
+    for (int32_t& material : triangleMaterials) {
+        material = material >= 0 ? materialRemap[material] : -1;
+    }
+    MeshProcessor::groupByMaterial(mesh, triangleMaterials);
+    mesh.ensureBaseLod();
+    mesh.computeBounds();
+
+    if (stats != nullptr) {
+        auto endTime = std::chrono::high_resolution_clock::now();
+        stats->bytes = file.size() + mtlBytes;
+        stats->positions = positionCount;
+        stats->normals = normalCount;
+        stats->texCoords = texCoordCount;
+        stats->triangles = mesh.indices.size() / 3;
+        stats->chunks = chunkCount;
+        stats->milliseconds = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+    }
+    return true;
+}
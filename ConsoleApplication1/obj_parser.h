@@ -0,0 +1,47 @@
+#pragma once
+#ifndef OBJ_PARSER_H
+#define OBJ_PARSER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "mesh_data.h"
+
+class ThreadPool;
+
+// Streaming OBJ/MTL reader. The file is memory mapped and parsed in place, one line at a time; face
+// corners go straight through a VertexDeduplicator into mesh.vertices / mesh.indices, so the only
+// intermediate storage is the raw position, normal and UV arrays the corners index into.
+// With a pool, line-aligned slices of the file are parsed and deduplicated on its threads and merged in
+// file order, so the output does not depend on the thread count.
+// Polygons are fan triangulated. For triangle meshes the output matches MeshProcessor::loadObj: the same
+// vertices, triangle order and material submeshes.
+class ObjParser {
+public:
+    struct Stats {
+        size_t bytes = 0;          // OBJ plus MTL bytes read
+        size_t positions = 0;
+        size_t normals = 0;
+        size_t texCoords = 0;
+        size_t triangles = 0;
+        size_t chunks = 0;         // Slices parsed separately
+        double milliseconds = 0.0;
+
+        double megabytesPerSecond() const {
+            return milliseconds > 0.0 ? bytes / (1024.0 * 1024.0) / (milliseconds / 1000.0) : 0.0;
+        }
+    };
+
+    // mtlBasePath is prepended to mtllib names as tinyobj does; when empty, they are looked up next to the OBJ
+    static bool load(const std::string& objFilename, const std::string& mtlBasePath, MeshData& mesh, Stats* stats = nullptr,
+        ThreadPool* pool = nullptr);
+
+    // Appends the materials of an MTL file; bytes receives the file size
+    static bool loadMtl(const std::string& filename, std::vector<Material>& materials, size_t* bytes = nullptr);
+
+    // Locale-independent number parsing; advance cursor past the number and return false when none is there
+    static bool parseFloat(const char*& cursor, const char* end, float& value);
+    static bool parseInt(const char*& cursor, const char* end, int& value);
+};
+
+#endif // OBJ_PARSER_H
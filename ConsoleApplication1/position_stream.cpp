@@ -0,0 +1,43 @@
+#include "position_stream.h"
+#include "mesh_optimizer.h"
+#include "vertex_dedup.h"
+#include <algorithm>
+
+PositionStreamStats PositionStream::build(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount,
+    size_t baseIndexCount, std::vector<PositionVertex>& positions, std::vector<uint32_t>& positionIndices) {
+    // Dedup on position bits alone by clearing everything else
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<Vertex> unique;
+    unique.reserve(vertexCount);
+    VertexDeduplicator deduplicator;
+    deduplicator.reserve(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        Vertex key{};
+        key.position = vertices[i].position;
+        remap[i] = deduplicator.insert(key, unique);
+    }
+
+    positionIndices.resize(indexCount);
+    for (size_t i = 0; i < indexCount; ++i) {
+        positionIndices[i] = remap[indices[i]];
+    }
+
+    // Fewer, merged vertices still want to be fetched in order of first use
+    MeshOptimizer::optimizeVertexFetch(unique, positionIndices);
+
+    positions.resize(unique.size());
+    convertVertices(unique.data(), unique.size(), positions.data());
+
+    PositionStreamStats stats;
+    stats.sourceVertices = vertexCount;
+    stats.positionVertices = positions.size();
+    baseIndexCount = std::min(baseIndexCount, indexCount);
+    size_t triangles = baseIndexCount / 3;
+    if (triangles != 0) {
+        stats.sourceAcmr = MeshOptimizer::analyzeVertexCache(indices, baseIndexCount, vertexCount).acmr;
+        stats.positionAcmr = MeshOptimizer::analyzeVertexCache(positionIndices.data(), baseIndexCount, positions.size()).acmr;
+    }
+    stats.sourceBytesPerPass = static_cast<size_t>(stats.sourceAcmr * triangles * sizeof(Vertex)) + baseIndexCount * sizeof(uint32_t);
+    stats.positionBytesPerPass = static_cast<size_t>(stats.positionAcmr * triangles * sizeof(PositionVertex)) + baseIndexCount * sizeof(uint32_t);
+    return stats;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#ifndef POSITION_STREAM_H
+#define POSITION_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "vertex.h"
+#include "vertex_layout.h"
+
+// Per-pass vertex traffic for the base level, full Vertex stream versus positions only
+struct PositionStreamStats {
+    size_t sourceVertices = 0;
+    size_t positionVertices = 0;  // After merging vertices that differ only in normal or UV
+    float sourceAcmr = 0.0f;      // Vertex shader invocations per triangle
+    float positionAcmr = 0.0f;
+    size_t sourceBytesPerPass = 0;    // Vertex fetch (invocations * stride) plus index bytes
+    size_t positionBytesPerPass = 0;
+};
+
+// Depth-only and shadow passes only read positions. This builds a tightly packed position stream
+// with its own index buffer: vertices split by normal or UV seams are merged again, and indices
+// keep the source's triangle order, so every submesh, LOD and meshlet range stays valid.
+class PositionStream {
+public:
+    // baseIndexCount is the number of leading indices one pass draws (the base level), used only for stats
+    static PositionStreamStats build(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount,
+        size_t baseIndexCount, std::vector<PositionVertex>& positions, std::vector<uint32_t>& positionIndices);
+};
+
+#endif // POSITION_STREAM_H
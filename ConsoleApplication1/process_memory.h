@@ -0,0 +1,12 @@
+#pragma once
+#ifndef PROCESS_MEMORY_H
+#define PROCESS_MEMORY_H
+
+#include <cstddef>
+
+// Resident memory of this process in bytes, 0 when the platform does not report it.
+// The peak never goes down, so comparisons between code paths must run the cheaper one first.
+size_t currentResidentBytes();
+size_t peakResidentBytes();
+
+#endif // PROCESS_MEMORY_H
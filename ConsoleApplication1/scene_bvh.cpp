@@ -0,0 +1,515 @@
+#include "scene_bvh.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+const uint32_t SceneBvh::NULL_NODE;
+
+static const size_t SAH_BINS = 12;
+static const size_t LOCAL_STACK_SIZE = 64;
+
+static float surfaceArea(const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    glm::vec3 size = boxMax - boxMin;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+static float unionArea(const glm::vec3& minA, const glm::vec3& maxA, const glm::vec3& minB, const glm::vec3& maxB) {
+    return surfaceArea(glm::min(minA, minB), glm::max(maxA, maxB));
+}
+
+SceneBvh::SceneBvh(float margin)
+    : root(NULL_NODE), freeNodes(NULL_NODE), objectCount(0), margin(margin) {
+}
+
+uint32_t SceneBvh::allocateNode() {
+    uint32_t node;
+    if (freeNodes != NULL_NODE) {
+        node = freeNodes;
+        freeNodes = parents[node];
+    }
+    else {
+        node = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+        parents.push_back(NULL_NODE);
+        heights.push_back(0);
+    }
+    parents[node] = NULL_NODE;
+    heights[node] = 0;
+    return node;
+}
+
+void SceneBvh::freeNode(uint32_t node) {
+    parents[node] = freeNodes;
+    freeNodes = node;
+}
+
+uint32_t SceneBvh::allocateLeaf(uint32_t object, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    uint32_t leaf = allocateNode();
+    Node& node = nodes[leaf];
+    node.boundsMin = boxMin;
+    node.boundsMax = boxMax;
+    node.left = NULL_NODE;
+    node.right = object;
+    if (object >= objectLeaves.size()) {
+        objectLeaves.resize(object + 1, NULL_NODE);
+    }
+    objectLeaves[object] = leaf;
+    ++objectCount;
+    return leaf;
+}
+
+void SceneBvh::setChildren(uint32_t node, uint32_t left, uint32_t right) {
+    Node& parent = nodes[node];
+    parent.left = left;
+    parent.right = right;
+    parent.boundsMin = glm::min(nodes[left].boundsMin, nodes[right].boundsMin);
+    parent.boundsMax = glm::max(nodes[left].boundsMax, nodes[right].boundsMax);
+    parents[left] = node;
+    parents[right] = node;
+    heights[node] = 1 + std::max(heights[left], heights[right]);
+}
+
+void SceneBvh::clear() {
+    nodes.clear();
+    parents.clear();
+    heights.clear();
+    objectLeaves.clear();
+    root = NULL_NODE;
+    freeNodes = NULL_NODE;
+    objectCount = 0;
+}
+
+bool SceneBvh::contains(uint32_t object) const {
+    return object < objectLeaves.size() && objectLeaves[object] != NULL_NODE;
+}
+
+void SceneBvh::build(const Item* items, size_t count) {
+    clear();
+    if (count == 0) {
+        return;
+    }
+    nodes.reserve(count * 2 - 1);
+    parents.reserve(count * 2 - 1);
+    heights.reserve(count * 2 - 1);
+    std::vector<uint32_t> leaves(count);
+    for (size_t i = 0; i < count; ++i) {
+        leaves[i] = allocateLeaf(items[i].object, items[i].boxMin, items[i].boxMax);
+    }
+    root = buildRange(leaves.data(), count);
+    parents[root] = NULL_NODE;
+}
+
+uint32_t SceneBvh::buildRange(uint32_t* leaves, size_t count) {
+    if (count == 1) {
+        return leaves[0];
+    }
+
+    glm::vec3 centroidMin(std::numeric_limits<float>::max());
+    glm::vec3 centroidMax(-std::numeric_limits<float>::max());
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec3 centroid = (nodes[leaves[i]].boundsMin + nodes[leaves[i]].boundsMax) * 0.5f;
+        centroidMin = glm::min(centroidMin, centroid);
+        centroidMax = glm::max(centroidMax, centroid);
+    }
+
+    // Bin the centroids along each axis and take the split with the lowest count-weighted area
+    int bestAxis = -1;
+    size_t bestSplit = 0;
+    float bestCost = std::numeric_limits<float>::max();
+    for (int axis = 0; axis < 3; ++axis) {
+        float extent = centroidMax[axis] - centroidMin[axis];
+        if (extent <= 0.0f) {
+            continue;
+        }
+        float binScale = SAH_BINS / extent;
+        size_t binCounts[SAH_BINS] = {};
+        glm::vec3 binMin[SAH_BINS], binMax[SAH_BINS];
+        std::fill(binMin, binMin + SAH_BINS, glm::vec3(std::numeric_limits<float>::max()));
+        std::fill(binMax, binMax + SAH_BINS, glm::vec3(-std::numeric_limits<float>::max()));
+        for (size_t i = 0; i < count; ++i) {
+            const Node& leaf = nodes[leaves[i]];
+            float centroid = (leaf.boundsMin[axis] + leaf.boundsMax[axis]) * 0.5f;
+            size_t bin = std::min(static_cast<size_t>((centroid - centroidMin[axis]) * binScale), SAH_BINS - 1);
+            ++binCounts[bin];
+            binMin[bin] = glm::min(binMin[bin], leaf.boundsMin);
+            binMax[bin] = glm::max(binMax[bin], leaf.boundsMax);
+        }
+
+        // Sweep from the right to get the cost of every right-hand side, then from the left
+        float rightArea[SAH_BINS];
+        size_t rightCount[SAH_BINS];
+        glm::vec3 sweepMin(std::numeric_limits<float>::max()), sweepMax(-std::numeric_limits<float>::max());
+        size_t sweepCount = 0;
+        for (size_t bin = SAH_BINS - 1; bin > 0; --bin) {
+            sweepMin = glm::min(sweepMin, binMin[bin]);
+            sweepMax = glm::max(sweepMax, binMax[bin]);
+            sweepCount += binCounts[bin];
+            rightArea[bin] = sweepCount != 0 ? surfaceArea(sweepMin, sweepMax) : 0.0f;
+            rightCount[bin] = sweepCount;
+        }
+        sweepMin = glm::vec3(std::numeric_limits<float>::max());
+        sweepMax = glm::vec3(-std::numeric_limits<float>::max());
+        sweepCount = 0;
+        for (size_t split = 1; split < SAH_BINS; ++split) {
+            sweepMin = glm::min(sweepMin, binMin[split - 1]);
+            sweepMax = glm::max(sweepMax, binMax[split - 1]);
+            sweepCount += binCounts[split - 1];
+            if (sweepCount == 0 || rightCount[split] == 0) {
+                continue;
+            }
+            float cost = sweepCount * surfaceArea(sweepMin, sweepMax) + rightCount[split] * rightArea[split];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = split;
+            }
+        }
+    }
+
+    size_t leftCount = 0;
+    if (bestAxis >= 0) {
+        float binScale = SAH_BINS / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+        uint32_t* middle = std::partition(leaves, leaves + count, [&](uint32_t leaf) {
+            float centroid = (nodes[leaf].boundsMin[bestAxis] + nodes[leaf].boundsMax[bestAxis]) * 0.5f;
+            return std::min(static_cast<size_t>((centroid - centroidMin[bestAxis]) * binScale), SAH_BINS - 1) < bestSplit;
+        });
+        leftCount = static_cast<size_t>(middle - leaves);
+    }
+    if (leftCount == 0 || leftCount == count) {
+        // Coincident centroids: any split is as good, halve the range to keep the tree shallow
+        leftCount = count / 2;
+    }
+
+    uint32_t left = buildRange(leaves, leftCount);
+    uint32_t right = buildRange(leaves + leftCount, count - leftCount);
+    uint32_t node = allocateNode();
+    setChildren(node, left, right);
+    return node;
+}
+
+void SceneBvh::insert(uint32_t object, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    if (contains(object)) {
+        update(object, boxMin, boxMax);
+        return;
+    }
+    uint32_t leaf = allocateLeaf(object, boxMin - glm::vec3(margin), boxMax + glm::vec3(margin));
+    insertLeaf(leaf);
+}
+
+bool SceneBvh::update(uint32_t object, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    if (!contains(object)) {
+        insert(object, boxMin, boxMax);
+        return true;
+    }
+    uint32_t leaf = objectLeaves[object];
+    Node& node = nodes[leaf];
+    if (glm::all(glm::greaterThanEqual(boxMin, node.boundsMin)) && glm::all(glm::lessThanEqual(boxMax, node.boundsMax))) {
+        return false;
+    }
+    removeLeaf(leaf);
+    node.boundsMin = boxMin - glm::vec3(margin);
+    node.boundsMax = boxMax + glm::vec3(margin);
+    insertLeaf(leaf);
+    return true;
+}
+
+void SceneBvh::remove(uint32_t object) {
+    if (!contains(object)) {
+        return;
+    }
+    uint32_t leaf = objectLeaves[object];
+    removeLeaf(leaf);
+    freeNode(leaf);
+    objectLeaves[object] = NULL_NODE;
+    --objectCount;
+}
+
+void SceneBvh::insertLeaf(uint32_t leaf) {
+    if (root == NULL_NODE) {
+        root = leaf;
+        parents[leaf] = NULL_NODE;
+        return;
+    }
+
+    // Descend towards the sibling whose pairing adds the least area, counting the growth of every
+    // ancestor on the way down
+    glm::vec3 leafMin = nodes[leaf].boundsMin;
+    glm::vec3 leafMax = nodes[leaf].boundsMax;
+    uint32_t sibling = root;
+    while (!isLeaf(sibling)) {
+        const Node& node = nodes[sibling];
+        float area = surfaceArea(node.boundsMin, node.boundsMax);
+        float combinedArea = unionArea(node.boundsMin, node.boundsMax, leafMin, leafMax);
+        float cost = 2.0f * combinedArea;            // Pair with this node itself
+        float inherited = 2.0f * (combinedArea - area);  // Growth every deeper choice pays here
+
+        auto descendCost = [&](uint32_t child) {
+            const Node& childNode = nodes[child];
+            float grown = unionArea(childNode.boundsMin, childNode.boundsMax, leafMin, leafMax);
+            return (isLeaf(child) ? grown : grown - surfaceArea(childNode.boundsMin, childNode.boundsMax)) + inherited;
+        };
+        float leftCost = descendCost(node.left);
+        float rightCost = descendCost(node.right);
+        if (cost < leftCost && cost < rightCost) {
+            break;
+        }
+        sibling = leftCost < rightCost ? node.left : node.right;
+    }
+
+    uint32_t oldParent = parents[sibling];
+    uint32_t newParent = allocateNode();
+    setChildren(newParent, sibling, leaf);
+    parents[newParent] = oldParent;
+    if (oldParent == NULL_NODE) {
+        root = newParent;
+    }
+    else if (nodes[oldParent].left == sibling) {
+        nodes[oldParent].left = newParent;
+    }
+    else {
+        nodes[oldParent].right = newParent;
+    }
+    refitAncestors(oldParent);
+}
+
+void SceneBvh::removeLeaf(uint32_t leaf) {
+    if (leaf == root) {
+        root = NULL_NODE;
+        return;
+    }
+
+    // The sibling takes the parent's place
+    uint32_t parent = parents[leaf];
+    uint32_t grandParent = parents[parent];
+    uint32_t sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+    parents[sibling] = grandParent;
+    if (grandParent == NULL_NODE) {
+        root = sibling;
+    }
+    else if (nodes[grandParent].left == parent) {
+        nodes[grandParent].left = sibling;
+    }
+    else {
+        nodes[grandParent].right = sibling;
+    }
+    freeNode(parent);
+    parents[leaf] = NULL_NODE;
+    refitAncestors(grandParent);
+}
+
+void SceneBvh::refitAncestors(uint32_t node) {
+    while (node != NULL_NODE) {
+        node = balance(node);
+        setChildren(node, nodes[node].left, nodes[node].right);
+        node = parents[node];
+    }
+}
+
+// AVL-style rotation: when one child is more than one level taller, its taller grandchild is swapped
+// with the other child. Returns the node now at this position.
+uint32_t SceneBvh::balance(uint32_t a) {
+    if (isLeaf(a)) {
+        return a;
+    }
+    uint32_t b = nodes[a].left;
+    uint32_t c = nodes[a].right;
+    int difference = static_cast<int>(heights[c]) - static_cast<int>(heights[b]);
+    if (difference >= -1 && difference <= 1) {
+        return a;
+    }
+
+    // Lift the taller child (up) into a's place; a keeps the shorter child and one of up's children
+    uint32_t up = difference > 1 ? c : b;
+    uint32_t keep = difference > 1 ? b : c;
+    uint32_t upLeft = nodes[up].left;
+    uint32_t upRight = nodes[up].right;
+    uint32_t parent = parents[a];
+    parents[up] = parent;
+    if (parent == NULL_NODE) {
+        root = up;
+    }
+    else if (nodes[parent].left == a) {
+        nodes[parent].left = up;
+    }
+    else {
+        nodes[parent].right = up;
+    }
+
+    uint32_t taller = heights[upLeft] > heights[upRight] ? upLeft : upRight;
+    uint32_t shorter = taller == upLeft ? upRight : upLeft;
+    setChildren(a, keep, shorter);
+    setChildren(up, a, taller);
+    return up;
+}
+
+uint32_t* SceneBvh::traversalStack(uint32_t* local, size_t localSize, std::vector<uint32_t>& overflow) const {
+    // A pop-one-push-two walk holds at most height + 1 nodes; frustum queries nest one more walk on top
+    size_t needed = heights[root] + 3;
+    if (needed <= localSize) {
+        return local;
+    }
+    overflow.resize(needed);
+    return overflow.data();
+}
+
+void SceneBvh::appendLeaves(uint32_t start, uint32_t* stack, std::vector<uint32_t>& objects) const {
+    size_t top = 0;
+    stack[top++] = start;
+    while (top != 0) {
+        const Node& node = nodes[stack[--top]];
+        if (node.left == NULL_NODE) {
+            objects.push_back(node.right);
+        }
+        else {
+            stack[top++] = node.left;
+            stack[top++] = node.right;
+        }
+    }
+}
+
+void SceneBvh::queryFrustum(const Frustum& frustum, std::vector<uint32_t>& objects) const {
+    objects.clear();
+    if (root == NULL_NODE) {
+        return;
+    }
+    uint32_t localStack[LOCAL_STACK_SIZE];
+    std::vector<uint32_t> overflow;
+    uint32_t* stack = traversalStack(localStack, LOCAL_STACK_SIZE, overflow);
+    glm::vec3 absNormals[Frustum::PLANE_COUNT];
+    for (int plane = 0; plane < Frustum::PLANE_COUNT; ++plane) {
+        absNormals[plane] = glm::abs(glm::vec3(frustum.planes[plane]));
+    }
+
+    size_t top = 0;
+    stack[top++] = root;
+    while (top != 0) {
+        uint32_t index = stack[--top];
+        const Node& node = nodes[index];
+        glm::vec3 center = (node.boundsMin + node.boundsMax) * 0.5f;
+        glm::vec3 extent = (node.boundsMax - node.boundsMin) * 0.5f;
+        bool outside = false;
+        bool inside = true;
+        for (int plane = 0; plane < Frustum::PLANE_COUNT; ++plane) {
+            const glm::vec4& p = frustum.planes[plane];
+            float distance = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
+            float radius = glm::dot(absNormals[plane], extent);
+            if (distance < -radius) {
+                outside = true;
+                break;
+            }
+            inside = inside && distance >= radius;
+        }
+        if (outside) {
+            continue;
+        }
+        if (node.left == NULL_NODE) {
+            objects.push_back(node.right);
+        }
+        else if (inside) {
+            // Nothing below can be cut by a plane; take the subtree without testing
+            appendLeaves(index, stack + top, objects);
+        }
+        else {
+            stack[top++] = node.left;
+            stack[top++] = node.right;
+        }
+    }
+}
+
+void SceneBvh::queryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<RayHit>& hits) const {
+    hits.clear();
+    if (root == NULL_NODE) {
+        return;
+    }
+    uint32_t localStack[LOCAL_STACK_SIZE];
+    std::vector<uint32_t> overflow;
+    uint32_t* stack = traversalStack(localStack, LOCAL_STACK_SIZE, overflow);
+    // A zero component would make 0 * inf = NaN for a ray starting on a box face; a huge finite inverse gives 0
+    glm::vec3 inverseDirection;
+    for (int axis = 0; axis < 3; ++axis) {
+        inverseDirection[axis] = 1.0f / (std::fabs(direction[axis]) > 1e-20f ? direction[axis] : std::copysign(1e-20f, direction[axis]));
+    }
+
+    size_t top = 0;
+    stack[top++] = root;
+    while (top != 0) {
+        const Node& node = nodes[stack[--top]];
+        // Slab test
+        glm::vec3 t0 = (node.boundsMin - origin) * inverseDirection;
+        glm::vec3 t1 = (node.boundsMax - origin) * inverseDirection;
+        glm::vec3 tNear = glm::min(t0, t1);
+        glm::vec3 tFar = glm::max(t0, t1);
+        float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+        if (enter > exit) {
+            continue;
+        }
+        if (node.left == NULL_NODE) {
+            hits.push_back({ node.right, enter });
+        }
+        else {
+            stack[top++] = node.left;
+            stack[top++] = node.right;
+        }
+    }
+    std::sort(hits.begin(), hits.end(), [](const RayHit& a, const RayHit& b) {
+        return a.distance < b.distance || (a.distance == b.distance && a.object < b.object);
+    });
+}
+
+void SceneBvh::queryRadius(const glm::vec3& center, float radius, std::vector<uint32_t>& objects) const {
+    objects.clear();
+    if (root == NULL_NODE) {
+        return;
+    }
+    uint32_t localStack[LOCAL_STACK_SIZE];
+    std::vector<uint32_t> overflow;
+    uint32_t* stack = traversalStack(localStack, LOCAL_STACK_SIZE, overflow);
+    float radiusSquared = radius * radius;
+
+    size_t top = 0;
+    stack[top++] = root;
+    while (top != 0) {
+        const Node& node = nodes[stack[--top]];
+        glm::vec3 offset = center - glm::clamp(center, node.boundsMin, node.boundsMax);
+        if (glm::dot(offset, offset) > radiusSquared) {
+            continue;
+        }
+        if (node.left == NULL_NODE) {
+            objects.push_back(node.right);
+        }
+        else {
+            stack[top++] = node.left;
+            stack[top++] = node.right;
+        }
+    }
+}
+
+SceneBvh::Stats SceneBvh::stats() const {
+    Stats stats;
+    stats.objects = objectCount;
+    if (root == NULL_NODE) {
+        return stats;
+    }
+    stats.height = heights[root];
+    stats.nodes = objectCount * 2 - 1;
+    float rootArea = surfaceArea(nodes[root].boundsMin, nodes[root].boundsMax);
+    if (rootArea <= 0.0f) {
+        return stats;
+    }
+
+    std::vector<uint32_t> stack;
+    stack.push_back(root);
+    double internalArea = 0.0;
+    while (!stack.empty()) {
+        uint32_t index = stack.back();
+        stack.pop_back();
+        if (!isLeaf(index)) {
+            internalArea += surfaceArea(nodes[index].boundsMin, nodes[index].boundsMax);
+            stack.push_back(nodes[index].left);
+            stack.push_back(nodes[index].right);
+        }
+    }
+    stats.sahCost = static_cast<float>(internalArea / rootArea);
+    return stats;
+}
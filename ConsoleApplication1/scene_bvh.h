@@ -0,0 +1,95 @@
+#pragma once
+#ifndef SCENE_BVH_H
+#define SCENE_BVH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "frustum.h"
+
+// Bounding volume hierarchy over world-space object boxes, one object per leaf. Static objects are
+// built top-down with a binned surface area heuristic; objects added or moved later are inserted next
+// to the sibling that grows the tree least and the path to the root is refitted and rebalanced with
+// tree rotations. Nodes live in one flat array, 32 bytes each, and are recycled through a free list.
+//
+// Object ids are the caller's (an index into its own object list); they should be small and dense.
+class SceneBvh {
+public:
+    static const uint32_t NULL_NODE = UINT32_MAX;
+
+    struct Item {
+        uint32_t object;
+        glm::vec3 boxMin;
+        glm::vec3 boxMax;
+    };
+
+    struct RayHit {
+        uint32_t object;
+        float distance;  // Where the ray enters the object's box, 0 when it starts inside
+    };
+
+    struct Stats {
+        size_t objects = 0;
+        size_t nodes = 0;
+        size_t height = 0;
+        float sahCost = 0.0f;  // Summed internal node area over root area; lower is a better tree
+    };
+
+    // Boxes of inserted objects are grown by margin on every side, so small movements need no update
+    explicit SceneBvh(float margin = 0.1f);
+
+    // Replaces the whole tree with an SAH build over tight boxes
+    void build(const Item* items, size_t count);
+    void insert(uint32_t object, const glm::vec3& boxMin, const glm::vec3& boxMax);
+    // Moves an object; returns false when the new box still fits the stored one and nothing changed
+    bool update(uint32_t object, const glm::vec3& boxMin, const glm::vec3& boxMax);
+    void remove(uint32_t object);
+    void clear();
+    bool contains(uint32_t object) const;
+    size_t size() const { return objectCount; }
+
+    // Queries replace their output. Results are conservative by up to the margin for inserted objects.
+    void queryFrustum(const Frustum& frustum, std::vector<uint32_t>& objects) const;
+    // Every object whose box the ray crosses within maxDistance, nearest entry first; direction need
+    // not be normalized, distances are in units of its length
+    void queryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<RayHit>& hits) const;
+    void queryRadius(const glm::vec3& center, float radius, std::vector<uint32_t>& objects) const;
+
+    Stats stats() const;
+
+private:
+    // Internal nodes hold two children; a leaf has left == NULL_NODE and keeps its object in right
+    struct Node {
+        glm::vec3 boundsMin;
+        uint32_t left;
+        glm::vec3 boundsMax;
+        uint32_t right;
+    };
+
+    // Parents and heights are only read by updates, so they stay out of the nodes the queries walk
+    std::vector<Node> nodes;
+    std::vector<uint32_t> parents;
+    std::vector<uint32_t> heights;
+    std::vector<uint32_t> objectLeaves;  // Leaf per object id, NULL_NODE when absent
+    uint32_t root;
+    uint32_t freeNodes;  // Chained through parents
+    size_t objectCount;
+    float margin;
+
+    bool isLeaf(uint32_t node) const { return nodes[node].left == NULL_NODE; }
+    uint32_t allocateNode();
+    void freeNode(uint32_t node);
+    uint32_t allocateLeaf(uint32_t object, const glm::vec3& boxMin, const glm::vec3& boxMax);
+    uint32_t buildRange(uint32_t* leaves, size_t count);
+    void setChildren(uint32_t node, uint32_t left, uint32_t right);
+    void insertLeaf(uint32_t leaf);
+    void removeLeaf(uint32_t leaf);
+    void refitAncestors(uint32_t node);
+    uint32_t balance(uint32_t node);
+    void appendLeaves(uint32_t node, uint32_t* stack, std::vector<uint32_t>& objects) const;
+    // Enough stack for a depth-first walk of the current tree, on the C++ stack unless the tree is very deep
+    uint32_t* traversalStack(uint32_t* local, size_t localSize, std::vector<uint32_t>& overflow) const;
+};
+
+#endif // SCENE_BVH_H
@@ -0,0 +1,115 @@
+#include "scene_picker.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+const uint32_t ScenePicker::NO_OBJECT;
+
+// Rays handed out at a time in a batch; the budget is checked after each chunk
+static const size_t CHUNK_RAYS = 64;
+
+ScenePicker::ScenePicker(const SceneBvh& scene) : scene(scene) {
+}
+
+void ScenePicker::setObjectMesh(uint32_t object, const MeshData& mesh, const glm::mat4& modelMatrix) {
+    if (object >= objectMeshes.size()) {
+        objectMeshes.resize(object + 1);
+    }
+    objectMeshes[object].mesh = &mesh;
+    objectMeshes[object].worldToObject = glm::inverse(modelMatrix);
+}
+
+void ScenePicker::clearObjectMesh(uint32_t object) {
+    if (object < objectMeshes.size()) {
+        objectMeshes[object] = ObjectMesh();
+    }
+}
+
+bool ScenePicker::castRay(const Ray& ray, Hit& hit, std::vector<SceneBvh::RayHit>& candidates, size_t& meshTests) const {
+    hit = Hit();
+    scene.queryRay(ray.origin, ray.direction, ray.maxDistance, candidates);
+    float bestDistance = ray.maxDistance;
+    for (const SceneBvh::RayHit& candidate : candidates) {
+        // Candidates come nearest box first, so nothing further on can beat the current hit
+        if (candidate.distance >= bestDistance) {
+            break;
+        }
+        const ObjectMesh* target = candidate.object < objectMeshes.size() ? &objectMeshes[candidate.object] : nullptr;
+        if (target == nullptr || target->mesh == nullptr) {
+            bestDistance = candidate.distance;
+            hit = Hit();
+            hit.object = candidate.object;
+            hit.distance = candidate.distance;
+            continue;
+        }
+
+        // An affine map keeps the ray parameter, so the mesh's distances are world distances
+        ++meshTests;
+        glm::vec3 localOrigin = glm::vec3(target->worldToObject * glm::vec4(ray.origin, 1.0f));
+        glm::vec3 localDirection = glm::vec3(target->worldToObject * glm::vec4(ray.direction, 0.0f));
+        TriangleBvh::RayHit meshHit;
+        if (TriangleBvh::raycast(*target->mesh, localOrigin, localDirection, bestDistance, meshHit)) {
+            bestDistance = meshHit.distance;
+            hit.object = candidate.object;
+            hit.triangle = meshHit.triangle;
+            hit.distance = meshHit.distance;
+            hit.normal = glm::normalize(glm::vec3(glm::transpose(target->worldToObject) * glm::vec4(meshHit.normal, 0.0f)));
+        }
+    }
+    return hit.isHit();
+}
+
+bool ScenePicker::pick(const Ray& ray, Hit& hit) const {
+    std::vector<SceneBvh::RayHit> candidates;
+    size_t meshTests = 0;
+    return castRay(ray, hit, candidates, meshTests);
+}
+
+size_t ScenePicker::pick(const Ray* rays, size_t count, Hit* hits, double budgetMilliseconds, ThreadPool* pool) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    auto deadline = startTime + std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+        std::chrono::duration<double, std::milli>(budgetMilliseconds));
+    size_t chunkCount = (count + CHUNK_RAYS - 1) / CHUNK_RAYS;
+
+    // Chunks are claimed in order and every claimed chunk is finished, so the finished rays are a prefix
+    std::atomic<size_t> nextChunk(0);
+    std::atomic<bool> outOfTime(false);
+    std::atomic<size_t> hitCount(0);
+    std::atomic<size_t> meshTestCount(0);
+    auto worker = [&](size_t) {
+        std::vector<SceneBvh::RayHit> candidates;
+        size_t workerHits = 0;
+        size_t workerMeshTests = 0;
+        while (!outOfTime.load(std::memory_order_relaxed)) {
+            size_t chunk = nextChunk.fetch_add(1);
+            if (chunk >= chunkCount) {
+                break;
+            }
+            size_t end = std::min(count, (chunk + 1) * CHUNK_RAYS);
+            for (size_t i = chunk * CHUNK_RAYS; i < end; ++i) {
+                workerHits += castRay(rays[i], hits[i], candidates, workerMeshTests) ? 1 : 0;
+            }
+            if (budgetMilliseconds > 0.0 && std::chrono::high_resolution_clock::now() >= deadline) {
+                outOfTime.store(true, std::memory_order_relaxed);
+            }
+        }
+        hitCount += workerHits;
+        meshTestCount += workerMeshTests;
+    };
+    if (pool != nullptr && pool->threadCount() != 0 && chunkCount > 1) {
+        pool->parallelFor(std::min(pool->threadCount() + 1, chunkCount), worker);
+    }
+    else {
+        worker(0);
+    }
+
+    size_t cast = std::min(std::min(nextChunk.load(), chunkCount) * CHUNK_RAYS, count);
+    auto endTime = std::chrono::high_resolution_clock::now();
+    batchStats.rays = count;
+    batchStats.raysCast = cast;
+    batchStats.hits = hitCount.load();
+    batchStats.meshTests = meshTestCount.load();
+    batchStats.milliseconds = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+    return cast;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#ifndef SCENE_PICKER_H
+#define SCENE_PICKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "mesh_data.h"
+#include "scene_bvh.h"
+#include "triangle_bvh.h"
+
+class ThreadPool;
+
+// Ray casts into the scene, for the crosshair and for batches such as AI line-of-sight checks. The
+// SceneBvh gives the objects whose boxes a ray crosses, nearest first; objects with a mesh are tested
+// against its TriangleBvh and the rest are hit where the ray enters their box. Candidates are dropped as
+// soon as their box starts beyond the nearest hit so far.
+class ScenePicker {
+public:
+    static const uint32_t NO_OBJECT = UINT32_MAX;
+
+    struct Ray {
+        glm::vec3 origin;
+        glm::vec3 direction;  // Need not be normalized; distances are in units of its length
+        float maxDistance;
+    };
+
+    struct Hit {
+        uint32_t object = NO_OBJECT;
+        uint32_t triangle = TriangleBvh::INVALID_TRIANGLE;  // INVALID_TRIANGLE for box hits
+        float distance = 0.0f;
+        glm::vec3 normal{ 0.0f };  // World-space unit normal facing the ray; zero for box hits
+
+        bool isHit() const { return object != NO_OBJECT; }
+    };
+
+    // Counters from the last batch
+    struct Stats {
+        size_t rays = 0;          // Asked for
+        size_t raysCast = 0;      // Finished within the budget
+        size_t hits = 0;
+        size_t meshTests = 0;     // Object meshes a ray was tested against
+        double milliseconds = 0.0;
+    };
+
+    explicit ScenePicker(const SceneBvh& scene);
+
+    // Tests object against the mesh's triangle hierarchy placed by modelMatrix instead of its box. The mesh
+    // is not copied and must stay alive and unchanged until the object is cleared or set again.
+    void setObjectMesh(uint32_t object, const MeshData& mesh, const glm::mat4& modelMatrix);
+    void clearObjectMesh(uint32_t object);
+
+    // Nearest hit along one ray; false (and an empty hit) when it hits nothing
+    bool pick(const Ray& ray, Hit& hit) const;
+    // Casts rays in order until budgetMilliseconds is spent (0 for no limit) and returns how many finished;
+    // hits is filled for those. The rest can be passed again next frame. With a pool, chunks of rays are
+    // spread over its threads. The scene and meshes must not change until this returns.
+    size_t pick(const Ray* rays, size_t count, Hit* hits, double budgetMilliseconds = 0.0, ThreadPool* pool = nullptr);
+
+    const Stats& lastStats() const { return batchStats; }
+
+private:
+    struct ObjectMesh {
+        const MeshData* mesh = nullptr;
+        glm::mat4 worldToObject{ 1.0f };
+    };
+
+    const SceneBvh& scene;
+    std::vector<ObjectMesh> objectMeshes;  // By object id
+    Stats batchStats;
+
+    bool castRay(const Ray& ray, Hit& hit, std::vector<SceneBvh::RayHit>& candidates, size_t& meshTests) const;
+};
+
+#endif // SCENE_PICKER_H
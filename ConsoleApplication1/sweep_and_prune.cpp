@@ -0,0 +1,194 @@
+#include "sweep_and_prune.h"
+#include <algorithm>
+#include <chrono>
+
+// The sort axis only changes when another axis spreads the boxes this much more, so bodies drifting
+// around the tie do not force a full sort every tick
+static const float AXIS_SWITCH_RATIO = 1.5f;
+
+SweepAndPrune::SweepAndPrune() : bodyCount(0), sortedCount(0), removedSinceSort(false), axis(0) {
+}
+
+bool SweepAndPrune::isAlive(uint32_t body) const {
+    return body < generations.size() && (generations[body] & 1) != 0;
+}
+
+uint32_t SweepAndPrune::add(const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    uint32_t body;
+    if (!freeBodies.empty()) {
+        body = freeBodies.back();
+        freeBodies.pop_back();
+    }
+    else {
+        body = static_cast<uint32_t>(generations.size());
+        bodyMin.emplace_back();
+        bodyMax.emplace_back();
+        generations.push_back(0);
+    }
+    bodyMin[body] = boxMin;
+    bodyMax[body] = boxMax;
+    ++generations[body];
+    ++bodyCount;
+    // A recycled id gets a new entry rather than the old one, which sits where the last body was
+    Entry entry;
+    entry.body = body;
+    entry.generation = generations[body];
+    entries.push_back(entry);
+    return body;
+}
+
+void SweepAndPrune::update(uint32_t body, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    if (!isAlive(body)) {
+        return;
+    }
+    bodyMin[body] = boxMin;
+    bodyMax[body] = boxMax;
+}
+
+void SweepAndPrune::remove(uint32_t body) {
+    if (!isAlive(body)) {
+        return;
+    }
+    ++generations[body];
+    freeBodies.push_back(body);
+    --bodyCount;
+    removedSinceSort = true;
+}
+
+void SweepAndPrune::clear() {
+    entries.clear();
+    bodyMin.clear();
+    bodyMax.clear();
+    generations.clear();
+    freeBodies.clear();
+    bodyCount = 0;
+    sortedCount = 0;
+    removedSinceSort = false;
+}
+
+int SweepAndPrune::chooseAxis() const {
+    if (entries.size() < 2) {
+        return axis;
+    }
+    // Centres doubled, which scales every variance alike
+    double sum[3] = { 0.0, 0.0, 0.0 };
+    double sumSquares[3] = { 0.0, 0.0, 0.0 };
+    for (const Entry& entry : entries) {
+        for (int k = 0; k < 3; ++k) {
+            double centre = static_cast<double>(entry.boxMin[k]) + entry.boxMax[k];
+            sum[k] += centre;
+            sumSquares[k] += centre * centre;
+        }
+    }
+    double count = static_cast<double>(entries.size());
+    double variance[3];
+    for (int k = 0; k < 3; ++k) {
+        double mean = sum[k] / count;
+        variance[k] = sumSquares[k] / count - mean * mean;
+    }
+    int best = axis;
+    for (int k = 0; k < 3; ++k) {
+        if (variance[k] > variance[best]) {
+            best = k;
+        }
+    }
+    return variance[best] > variance[axis] * AXIS_SWITCH_RATIO ? best : axis;
+}
+
+void SweepAndPrune::findPairs(std::vector<Pair>& pairs) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    tickStats = Stats();
+    pairs.clear();
+
+    if (removedSinceSort) {
+        // Dropping entries keeps the rest in order
+        size_t kept = 0;
+        size_t keptSorted = 0;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (entries[i].generation == generations[entries[i].body]) {
+                entries[kept++] = entries[i];
+                keptSorted += i < sortedCount ? 1 : 0;
+            }
+        }
+        entries.resize(kept);
+        sortedCount = keptSorted;
+        removedSinceSort = false;
+    }
+    for (Entry& entry : entries) {
+        const glm::vec3& boxMin = bodyMin[entry.body];
+        const glm::vec3& boxMax = bodyMax[entry.body];
+        for (int k = 0; k < 3; ++k) {
+            entry.boxMin[k] = boxMin[k];
+            entry.boxMax[k] = boxMax[k];
+        }
+    }
+
+    int newAxis = chooseAxis();
+    const int a = newAxis;
+    auto byMin = [a](const Entry& left, const Entry& right) {
+        return left.boxMin[a] < right.boxMin[a];
+    };
+    if (newAxis != axis) {
+        axis = newAxis;
+        std::sort(entries.begin(), entries.end(), byMin);
+        tickStats.fullSort = true;
+    }
+    else {
+        // Bodies moved a little since the last tick, so each entry travels a short way
+        size_t swaps = 0;
+        for (size_t i = 1; i < sortedCount; ++i) {
+            if (entries[i - 1].boxMin[a] <= entries[i].boxMin[a]) {
+                continue;
+            }
+            Entry entry = entries[i];
+            size_t j = i;
+            do {
+                entries[j] = entries[j - 1];
+                --j;
+                ++swaps;
+            } while (j > 0 && entries[j - 1].boxMin[a] > entry.boxMin[a]);
+            entries[j] = entry;
+        }
+        tickStats.swaps = swaps;
+
+        // New bodies can land anywhere, so they are sorted apart and merged in
+        if (sortedCount < entries.size()) {
+            std::sort(entries.begin() + sortedCount, entries.end(), byMin);
+            std::inplace_merge(entries.begin(), entries.begin() + sortedCount, entries.end(), byMin);
+        }
+    }
+    sortedCount = entries.size();
+    auto sortTime = std::chrono::high_resolution_clock::now();
+
+    // Each entry meets the ones after it that start before it ends on the sort axis; the other two axes
+    // decide the pair
+    const int b = (a + 1) % 3;
+    const int c = (a + 2) % 3;
+    size_t comparisons = 0;
+    const size_t count = entries.size();
+    for (size_t i = 0; i < count; ++i) {
+        const Entry& first = entries[i];
+        float end = first.boxMax[a];
+        for (size_t j = i + 1; j < count && entries[j].boxMin[a] <= end; ++j) {
+            const Entry& second = entries[j];
+            ++comparisons;
+            // Non-short-circuit, since which test fails is unpredictable and most pairs fail one
+            bool overlap = (first.boxMin[b] <= second.boxMax[b]) & (second.boxMin[b] <= first.boxMax[b]) &
+                (first.boxMin[c] <= second.boxMax[c]) & (second.boxMin[c] <= first.boxMax[c]);
+            if (overlap) {
+                Pair pair;
+                pair.a = std::min(first.body, second.body);
+                pair.b = std::max(first.body, second.body);
+                pairs.push_back(pair);
+            }
+        }
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    tickStats.bodies = count;
+    tickStats.pairs = pairs.size();
+    tickStats.comparisons = comparisons;
+    tickStats.axis = axis;
+    tickStats.sortMilliseconds = std::chrono::duration<double, std::milli>(sortTime - startTime).count();
+    tickStats.sweepMilliseconds = std::chrono::duration<double, std::milli>(endTime - sortTime).count();
+}
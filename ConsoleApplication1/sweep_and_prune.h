@@ -0,0 +1,73 @@
+#pragma once
+#ifndef SWEEP_AND_PRUNE_H
+#define SWEEP_AND_PRUNE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Broadphase for many moving boxes, such as crates and debris. Boxes are kept sorted by their lower
+// bound along the axis where box centres spread the most; finding pairs sweeps that order and only
+// compares boxes whose intervals on that axis overlap. Bodies move little between ticks, so the order is
+// repaired with an insertion sort that costs about one pass plus the swaps; new bodies are sorted on
+// their own and merged in. Changing axis sorts from scratch.
+//
+// The pairs are for a narrowphase to test exactly; the boxes themselves only have to be conservative.
+class SweepAndPrune {
+public:
+    struct Pair {
+        uint32_t a;  // a < b
+        uint32_t b;
+    };
+
+    struct Stats {
+        size_t bodies = 0;
+        size_t pairs = 0;
+        size_t swaps = 0;         // Insertion sort moves this tick
+        size_t comparisons = 0;   // Box pairs whose sort-axis intervals overlapped
+        int axis = 0;
+        bool fullSort = false;    // The order was rebuilt rather than repaired
+        double sortMilliseconds = 0.0;
+        double sweepMilliseconds = 0.0;
+    };
+
+    SweepAndPrune();
+
+    // Body ids are small and dense; removed ids are handed out again
+    uint32_t add(const glm::vec3& boxMin, const glm::vec3& boxMax);
+    void update(uint32_t body, const glm::vec3& boxMin, const glm::vec3& boxMax);
+    void remove(uint32_t body);
+    void clear();
+    size_t size() const { return bodyCount; }
+
+    // Brings the order up to date with every add, update and remove since the last call and replaces
+    // pairs with each pair of bodies whose boxes overlap, touching included
+    void findPairs(std::vector<Pair>& pairs);
+
+    const Stats& lastStats() const { return tickStats; }
+
+private:
+    // Sorted by boxMin[axis]; each entry carries its box so the sweep reads memory in order
+    struct Entry {
+        float boxMin[3];
+        float boxMax[3];
+        uint32_t body;
+        uint32_t generation;  // Stale once the body is removed, even if its id is handed out again
+    };
+
+    std::vector<Entry> entries;  // Sorted up to sortedCount, then the bodies added since
+    std::vector<glm::vec3> bodyMin, bodyMax;
+    std::vector<uint32_t> generations;  // Bumped on every add and remove, so odd while the body is alive
+    std::vector<uint32_t> freeBodies;
+    size_t bodyCount;
+    size_t sortedCount;
+    bool removedSinceSort;
+    int axis;
+    Stats tickStats;
+
+    bool isAlive(uint32_t body) const;
+    int chooseAxis() const;
+};
+
+#endif // SWEEP_AND_PRUNE_H
@@ -0,0 +1,150 @@
+#include "texture_file.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const char TEXTURE_FILE_MAGIC[4] = { 'O', 'G', 'L', 'T' };
+
+static uint64_t alignUp(uint64_t value) {
+    return (value + 15) & ~static_cast<uint64_t>(15);
+}
+
+bool TextureFile::cook(const std::string& imageFilename, const std::string& textureFilename) {
+    int width = 0, height = 0, channels = 0;
+    stbi_uc* pixels = stbi_load(imageFilename.c_str(), &width, &height, &channels, 0);
+    if (pixels == nullptr) {
+        std::cerr << "Failed to decode image " << imageFilename << ": " << stbi_failure_reason() << std::endl;
+        return false;
+    }
+
+    std::vector<std::vector<uint8_t>> mips(1);
+    mips[0].assign(pixels, pixels + static_cast<size_t>(width) * height * channels);
+    stbi_image_free(pixels);
+
+    buildMipChain(mips, width, height, channels);
+    return write(textureFilename, width, height, channels, mips);
+}
+
+void TextureFile::buildMipChain(std::vector<std::vector<uint8_t>>& mips, uint32_t width, uint32_t height, uint32_t channels) {
+    mips.resize(1);
+    while (width > 1 || height > 1) {
+        uint32_t nextWidth = std::max(1u, width / 2);
+        uint32_t nextHeight = std::max(1u, height / 2);
+        const std::vector<uint8_t>& source = mips.back();
+        std::vector<uint8_t> level(static_cast<size_t>(nextWidth) * nextHeight * channels);
+
+        // 2x2 box filter; odd edges reuse the last row/column
+        for (uint32_t y = 0; y < nextHeight; ++y) {
+            uint32_t y0 = std::min(y * 2, height - 1);
+            uint32_t y1 = std::min(y * 2 + 1, height - 1);
+            for (uint32_t x = 0; x < nextWidth; ++x) {
+                uint32_t x0 = std::min(x * 2, width - 1);
+                uint32_t x1 = std::min(x * 2 + 1, width - 1);
+                for (uint32_t c = 0; c < channels; ++c) {
+                    uint32_t sum = source[(static_cast<size_t>(y0) * width + x0) * channels + c] +
+                        source[(static_cast<size_t>(y0) * width + x1) * channels + c] +
+                        source[(static_cast<size_t>(y1) * width + x0) * channels + c] +
+                        source[(static_cast<size_t>(y1) * width + x1) * channels + c];
+                    level[(static_cast<size_t>(y) * nextWidth + x) * channels + c] = static_cast<uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+
+        mips.push_back(std::move(level));
+        width = nextWidth;
+        height = nextHeight;
+    }
+}
+
+bool TextureFile::write(const std::string& filename, uint32_t width, uint32_t height, uint32_t channels,
+    const std::vector<std::vector<uint8_t>>& mips) {
+    TextureFileHeader header{};
+    std::memcpy(header.magic, TEXTURE_FILE_MAGIC, sizeof(header.magic));
+    header.version = TEXTURE_FILE_VERSION;
+    header.width = width;
+    header.height = height;
+    header.channels = channels;
+    header.mipCount = static_cast<uint32_t>(mips.size());
+
+    std::vector<TextureFileMip> table(mips.size());
+    uint64_t offset = alignUp(sizeof(TextureFileHeader) + table.size() * sizeof(TextureFileMip));
+    uint32_t levelWidth = width, levelHeight = height;
+    for (size_t i = 0; i < mips.size(); ++i) {
+        table[i] = { levelWidth, levelHeight, offset, mips[i].size() };
+        offset = alignUp(offset + mips[i].size());
+        levelWidth = std::max(1u, levelWidth / 2);
+        levelHeight = std::max(1u, levelHeight / 2);
+    }
+
+    std::ofstream output(filename, std::ios::binary | std::ios::trunc);
+    if (!output) {
+        std::cerr << "Failed to create texture file: " << filename << std::endl;
+        return false;
+    }
+
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(TextureFileMip));
+
+    static const char padding[16] = {};
+    uint64_t written = sizeof(TextureFileHeader) + table.size() * sizeof(TextureFileMip);
+    for (size_t i = 0; i < mips.size(); ++i) {
+        output.write(padding, static_cast<std::streamsize>(table[i].offset - written));
+        output.write(reinterpret_cast<const char*>(mips[i].data()), static_cast<std::streamsize>(mips[i].size()));
+        written = table[i].offset + mips[i].size();
+    }
+
+    if (!output) {
+        std::cerr << "Failed to write texture file: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool TextureFile::open(const std::string& filename) {
+    close();
+
+    if (!file.open(filename)) {
+        return false;
+    }
+
+    const TextureFileHeader* header = reinterpret_cast<const TextureFileHeader*>(file.data());
+    if (file.size() < sizeof(TextureFileHeader) || std::memcmp(header->magic, TEXTURE_FILE_MAGIC, sizeof(header->magic)) != 0) {
+        std::cerr << "Not a cooked texture file: " << filename << std::endl;
+        close();
+        return false;
+    }
+    if (header->version != TEXTURE_FILE_VERSION || header->channels < 1 || header->channels > 4 || header->mipCount == 0) {
+        std::cerr << "Unsupported texture file: " << filename << std::endl;
+        close();
+        return false;
+    }
+
+    uint64_t tableEnd = sizeof(TextureFileHeader) + static_cast<uint64_t>(header->mipCount) * sizeof(TextureFileMip);
+    if (tableEnd > file.size()) {
+        std::cerr << "Corrupt mip table in texture file: " << filename << std::endl;
+        close();
+        return false;
+    }
+
+    const TextureFileMip* table = reinterpret_cast<const TextureFileMip*>(file.data() + sizeof(TextureFileHeader));
+    for (uint32_t i = 0; i < header->mipCount; ++i) {
+        uint64_t expected = static_cast<uint64_t>(table[i].width) * table[i].height * header->channels;
+        if (table[i].size != expected || table[i].offset > file.size() || table[i].size > file.size() - table[i].offset) {
+            std::cerr << "Corrupt mip level in texture file: " << filename << std::endl;
+            close();
+            return false;
+        }
+    }
+
+    fileHeader = header;
+    mipTable = table;
+    return true;
+}
+
+void TextureFile::close() {
+    file.close();
+    fileHeader = nullptr;
+    mipTable = nullptr;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#ifndef TEXTURE_FILE_H
+#define TEXTURE_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+
+// Cooked texture: decoded 8-bit pixels with a prebuilt mip chain, so the game never runs an image
+// decoder or glGenerateMipmap at load time. Layout: TextureFileHeader, TextureFileMip[mipCount],
+// then each level's tightly packed rows starting on a 16-byte boundary.
+
+const uint32_t TEXTURE_FILE_VERSION = 1;
+
+struct TextureFileHeader {
+    char magic[4];       // "OGLT"
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;   // 1 to 4, 8 bits each
+    uint32_t mipCount;
+};
+
+struct TextureFileMip {
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset;     // From the start of the file
+    uint64_t size;
+};
+
+static_assert(sizeof(TextureFileHeader) == 24, "TextureFileHeader layout changed");
+static_assert(sizeof(TextureFileMip) == 24, "TextureFileMip layout changed");
+
+class TextureFile {
+public:
+    // Decodes a PNG/JPG with stb_image and writes the cooked texture
+    static bool cook(const std::string& imageFilename, const std::string& textureFilename);
+
+    // Box-filters level 0 down to 1x1; mips[0] must already hold the full image
+    static void buildMipChain(std::vector<std::vector<uint8_t>>& mips, uint32_t width, uint32_t height, uint32_t channels);
+
+    static bool write(const std::string& filename, uint32_t width, uint32_t height, uint32_t channels,
+        const std::vector<std::vector<uint8_t>>& mips);
+
+    bool open(const std::string& filename);
+    void close();
+
+    const TextureFileHeader& header() const { return *fileHeader; }
+    const TextureFileMip& mip(uint32_t level) const { return mipTable[level]; }
+    const uint8_t* mipData(uint32_t level) const { return file.data() + mipTable[level].offset; }
+
+private:
+    MappedFile file;
+    const TextureFileHeader* fileHeader = nullptr;
+    const TextureFileMip* mipTable = nullptr;
+};
+
+#endif // TEXTURE_FILE_H
@@ -0,0 +1,111 @@
+#include "textures.h"
+#include "texture_file.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <climits>
+#include <iostream>
+
+size_t TextureImage::byteCount() const {
+    size_t bytes = 0;
+    for (const Level& level : levels) {
+        bytes += level.pixels.size();
+    }
+    return bytes;
+}
+
+bool readCookedTexture(const std::string& filename, TextureImage& image) {
+    image = TextureImage();
+    TextureFile file;
+    if (!file.open(filename)) {
+        std::cerr << "Failed to load cooked texture: " << filename << std::endl;
+        return false;
+    }
+
+    // Copied out of the mapping, which closes with file
+    const TextureFileHeader& header = file.header();
+    image.channels = header.channels;
+    image.levels.resize(header.mipCount);
+    for (uint32_t level = 0; level < header.mipCount; ++level) {
+        const TextureFileMip& mip = file.mip(level);
+        image.levels[level].width = mip.width;
+        image.levels[level].height = mip.height;
+        image.levels[level].pixels.assign(file.mipData(level), file.mipData(level) + mip.size);
+    }
+    return true;
+}
+
+// Takes over stb_image's pixels and adds the mip chain glGenerateMipmap would otherwise build on the GL thread
+static void storeDecoded(stbi_uc* pixels, int width, int height, int channels, TextureImage& image) {
+    std::vector<std::vector<uint8_t>> mips(1);
+    mips[0].assign(pixels, pixels + static_cast<size_t>(width) * height * channels);
+    stbi_image_free(pixels);
+    TextureFile::buildMipChain(mips, width, height, channels);
+
+    image.channels = static_cast<uint32_t>(channels);
+    image.levels.resize(mips.size());
+    uint32_t levelWidth = static_cast<uint32_t>(width), levelHeight = static_cast<uint32_t>(height);
+    for (size_t level = 0; level < mips.size(); ++level) {
+        image.levels[level].width = levelWidth;
+        image.levels[level].height = levelHeight;
+        image.levels[level].pixels = std::move(mips[level]);
+        levelWidth = std::max(1u, levelWidth / 2);
+        levelHeight = std::max(1u, levelHeight / 2);
+    }
+}
+
+bool decodeTexture(const std::string& filename, TextureImage& image) {
+    image = TextureImage();
+    int width = 0, height = 0, channels = 0;
+    stbi_uc* pixels = stbi_load(filename.c_str(), &width, &height, &channels, 0);
+    if (pixels == nullptr) {
+        std::cerr << "Failed to decode image " << filename << ": " << stbi_failure_reason() << std::endl;
+        return false;
+    }
+    storeDecoded(pixels, width, height, channels, image);
+    return true;
+}
+
+bool decodeTextureFromMemory(const unsigned char* data, size_t size, TextureImage& image) {
+    image = TextureImage();
+    int width = 0, height = 0, channels = 0;
+    stbi_uc* pixels = size <= INT_MAX ? stbi_load_from_memory(data, static_cast<int>(size), &width, &height, &channels, 0) : nullptr;
+    if (pixels == nullptr) {
+        std::cerr << "Failed to decode embedded image: " << (size <= INT_MAX ? stbi_failure_reason() : "too large") << std::endl;
+        return false;
+    }
+    storeDecoded(pixels, width, height, channels, image);
+    return true;
+}
+
+GLuint uploadTexture(const TextureImage& image) {
+    if (image.empty() || image.channels < 1 || image.channels > 4) {
+        return 0;
+    }
+
+    static const GLenum formats[] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+    static const GLint internalFormats[] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+    GLenum format = formats[image.channels - 1];
+    GLint internalFormat = internalFormats[image.channels - 1];
+
+    GLuint textureID = 0;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+
+    // Rows are tightly packed
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t level = 0; level < image.levels.size(); ++level) {
+        const TextureImage::Level& mip = image.levels[level];
+        glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), internalFormat, mip.width, mip.height, 0, format, GL_UNSIGNED_BYTE,
+            mip.pixels.data());
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.levels.size()) - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return textureID;
+}
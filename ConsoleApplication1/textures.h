@@ -0,0 +1,35 @@
+#pragma once
+#ifndef TEXTURES_H
+#define TEXTURES_H
+
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 8-bit pixels with their whole mip chain, ready for glTexImage2D. Filling one touches no GL state, so
+// files can be read and decoded on a worker and only uploadTexture left for the GL thread.
+struct TextureImage {
+    struct Level {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> pixels;  // Tightly packed rows
+    };
+    uint32_t channels = 0;  // 1 to 4
+    std::vector<Level> levels;
+
+    bool empty() const { return levels.empty(); }
+    size_t byteCount() const;
+};
+
+// Reads a texture written by the asset cooker, including its prebuilt mip chain
+bool readCookedTexture(const std::string& filename, TextureImage& image);
+// Decode a PNG/JPG from disk or from memory, such as an image embedded in a .glb, and box-filter the mips
+// the same way the cooker does
+bool decodeTexture(const std::string& filename, TextureImage& image);
+bool decodeTextureFromMemory(const unsigned char* data, size_t size, TextureImage& image);
+// Creates a mipmapped, repeating texture. Returns 0 for an empty image.
+GLuint uploadTexture(const TextureImage& image);
+
+#endif // TEXTURES_H
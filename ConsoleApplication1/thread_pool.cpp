@@ -0,0 +1,100 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+
+ThreadPool::ThreadPool(size_t threadCount) : stopping(false) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCondition.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        tasks.push(std::move(task));
+    }
+    queueCondition.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+    if (count == 1 || workers.empty()) {
+        for (size_t i = 0; i < count; ++i) {
+            body(i);
+        }
+        return;
+    }
+
+    // Helpers may start after the loop is already done (e.g. when every worker is busy),
+    // so the shared state outlives this call and late helpers simply find no work left
+    struct LoopState {
+        std::atomic<size_t> next{ 0 };
+        std::atomic<size_t> finished{ 0 };
+        size_t count = 0;
+        const std::function<void(size_t)>* body = nullptr;
+        std::mutex doneMutex;
+        std::condition_variable doneCondition;
+    };
+    auto state = std::make_shared<LoopState>();
+    state->count = count;
+    state->body = &body;
+
+    auto runItems = [](LoopState& loop) {
+        size_t completed = 0;
+        for (size_t i = loop.next.fetch_add(1); i < loop.count; i = loop.next.fetch_add(1)) {
+            (*loop.body)(i);
+            ++completed;
+        }
+        if (completed != 0 && loop.finished.fetch_add(completed) + completed == loop.count) {
+            std::lock_guard<std::mutex> lock(loop.doneMutex);
+            loop.doneCondition.notify_all();
+        }
+    };
+
+    size_t helperCount = std::min(workers.size(), count - 1);
+    for (size_t i = 0; i < helperCount; ++i) {
+        enqueue([state, runItems]() { runItems(*state); });
+    }
+    runItems(*state);
+
+    std::unique_lock<std::mutex> lock(state->doneMutex);
+    state->doneCondition.wait(lock, [&state]() { return state->finished.load() == state->count; });
+}
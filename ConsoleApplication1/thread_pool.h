@@ -0,0 +1,55 @@
+#pragma once
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads fed from a single FIFO queue
+class ThreadPool {
+public:
+    // threadCount == 0 uses one worker per hardware thread
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Queues a task and returns a future for its result
+    template <typename Function>
+    auto submit(Function&& function) -> std::future<decltype(function())> {
+        using Result = decltype(function());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+        std::future<Result> result = task->get_future();
+        enqueue([task]() { (*task)(); });
+        return result;
+    }
+
+    // Runs body(i) for every i in [0, count) and returns once all calls have finished.
+    // The calling thread takes part in the work, so this is safe to call from inside a task.
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    size_t threadCount() const { return workers.size(); }
+
+    // Process-wide pool shared by the loaders
+    static ThreadPool& shared();
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    bool stopping;
+
+    void enqueue(std::function<void()> task);
+    void workerLoop();
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,698 @@
+#include "triangle_bvh.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TRIANGLE_BVH_SSE
+#include <immintrin.h>
+#endif
+
+const uint32_t TriangleBvh::INVALID_TRIANGLE;
+
+static const size_t PACKET_WIDTH = 4;
+static const size_t MAX_LEAF_TRIANGLES = 2 * PACKET_WIDTH;  // Leaves this small may be kept when SAH prefers them
+static const size_t MAX_DEPTH = 48;                        // Deeper ranges become leaves, which bounds the traversal stack
+static const size_t STACK_SIZE = MAX_DEPTH + 2;
+static const size_t SAH_BINS = 12;
+static const float TRAVERSAL_COST = 1.0f;                  // Relative to one triangle test
+static const size_t PARALLEL_TRIANGLES = 16 * 1024;       // Subtrees at least this big build their halves on two threads
+
+namespace {
+
+struct BuildTriangle {
+    glm::vec3 v0, v1, v2;
+    glm::vec3 boundsMin, boundsMax;
+    glm::vec3 centroid;
+    uint32_t id;
+};
+
+// Intermediate node; children are adjacent like the final layout, but numbered in allocation order
+struct BuildNode {
+    glm::vec3 boundsMin, boundsMax;
+    uint32_t left = 0;
+    uint32_t begin = 0;
+    uint32_t count = 0;  // 0 for internal nodes
+};
+
+struct Builder {
+    const std::vector<BuildTriangle>& triangles;
+    std::vector<uint32_t>& order;
+    std::vector<BuildNode> nodes;
+    std::atomic<uint32_t> nodeCount;
+    ThreadPool* pool;
+
+    Builder(const std::vector<BuildTriangle>& triangles, std::vector<uint32_t>& order, ThreadPool* pool)
+        : triangles(triangles), order(order), nodes(std::max<size_t>(triangles.size() * 2, 1)), nodeCount(1), pool(pool) {
+    }
+
+    void buildNode(uint32_t node, uint32_t begin, uint32_t count, size_t depth);
+};
+
+}
+
+static float surfaceArea(const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    glm::vec3 size = boxMax - boxMin;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+void Builder::buildNode(uint32_t node, uint32_t begin, uint32_t count, size_t depth) {
+    glm::vec3 boundsMin(std::numeric_limits<float>::max()), boundsMax(-std::numeric_limits<float>::max());
+    glm::vec3 centroidMin(std::numeric_limits<float>::max()), centroidMax(-std::numeric_limits<float>::max());
+    for (uint32_t i = begin; i < begin + count; ++i) {
+        const BuildTriangle& triangle = triangles[order[i]];
+        boundsMin = glm::min(boundsMin, triangle.boundsMin);
+        boundsMax = glm::max(boundsMax, triangle.boundsMax);
+        centroidMin = glm::min(centroidMin, triangle.centroid);
+        centroidMax = glm::max(centroidMax, triangle.centroid);
+    }
+    nodes[node].boundsMin = boundsMin;
+    nodes[node].boundsMax = boundsMax;
+    nodes[node].begin = begin;
+    nodes[node].count = count;
+    if (count <= PACKET_WIDTH || depth >= MAX_DEPTH) {
+        return;
+    }
+
+    // Same binned sweep as SceneBvh, with costs scaled by the node's area instead of divided by it
+    int bestAxis = -1;
+    size_t bestSplit = 0;
+    float bestCost = std::numeric_limits<float>::max();
+    for (int axis = 0; axis < 3; ++axis) {
+        float extent = centroidMax[axis] - centroidMin[axis];
+        if (extent <= 0.0f) {
+            continue;
+        }
+        float binScale = SAH_BINS / extent;
+        size_t binCounts[SAH_BINS] = {};
+        glm::vec3 binMin[SAH_BINS], binMax[SAH_BINS];
+        std::fill(binMin, binMin + SAH_BINS, glm::vec3(std::numeric_limits<float>::max()));
+        std::fill(binMax, binMax + SAH_BINS, glm::vec3(-std::numeric_limits<float>::max()));
+        for (uint32_t i = begin; i < begin + count; ++i) {
+            const BuildTriangle& triangle = triangles[order[i]];
+            size_t bin = std::min(static_cast<size_t>((triangle.centroid[axis] - centroidMin[axis]) * binScale), SAH_BINS - 1);
+            ++binCounts[bin];
+            binMin[bin] = glm::min(binMin[bin], triangle.boundsMin);
+            binMax[bin] = glm::max(binMax[bin], triangle.boundsMax);
+        }
+
+        float rightArea[SAH_BINS];
+        size_t rightCount[SAH_BINS];
+        glm::vec3 sweepMin(std::numeric_limits<float>::max()), sweepMax(-std::numeric_limits<float>::max());
+        size_t sweepCount = 0;
+        for (size_t bin = SAH_BINS - 1; bin > 0; --bin) {
+            sweepMin = glm::min(sweepMin, binMin[bin]);
+            sweepMax = glm::max(sweepMax, binMax[bin]);
+            sweepCount += binCounts[bin];
+            rightArea[bin] = sweepCount != 0 ? surfaceArea(sweepMin, sweepMax) : 0.0f;
+            rightCount[bin] = sweepCount;
+        }
+        sweepMin = glm::vec3(std::numeric_limits<float>::max());
+        sweepMax = glm::vec3(-std::numeric_limits<float>::max());
+        sweepCount = 0;
+        for (size_t split = 1; split < SAH_BINS; ++split) {
+            sweepMin = glm::min(sweepMin, binMin[split - 1]);
+            sweepMax = glm::max(sweepMax, binMax[split - 1]);
+            sweepCount += binCounts[split - 1];
+            if (sweepCount == 0 || rightCount[split] == 0) {
+                continue;
+            }
+            float cost = sweepCount * surfaceArea(sweepMin, sweepMax) + rightCount[split] * rightArea[split];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = split;
+            }
+        }
+    }
+
+    float area = surfaceArea(boundsMin, boundsMax);
+    uint32_t leftCount = 0;
+    if (bestAxis >= 0) {
+        if (count <= MAX_LEAF_TRIANGLES && count * area <= TRAVERSAL_COST * area + bestCost) {
+            return;
+        }
+        float binScale = SAH_BINS / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+        uint32_t* middle = std::partition(order.data() + begin, order.data() + begin + count, [&](uint32_t triangle) {
+            float centroid = triangles[triangle].centroid[bestAxis];
+            return std::min(static_cast<size_t>((centroid - centroidMin[bestAxis]) * binScale), SAH_BINS - 1) < bestSplit;
+        });
+        leftCount = static_cast<uint32_t>(middle - (order.data() + begin));
+    }
+    else if (count <= MAX_LEAF_TRIANGLES) {
+        return;
+    }
+    if (leftCount == 0 || leftCount == count) {
+        leftCount = count / 2;  // Coincident centroids
+    }
+
+    uint32_t children = nodeCount.fetch_add(2);
+    nodes[node].left = children;
+    nodes[node].count = 0;
+    uint32_t rightCount = count - leftCount;
+    if (pool != nullptr && count >= PARALLEL_TRIANGLES) {
+        // parallelFor works on the calling thread too, so nested splits cannot starve the pool
+        pool->parallelFor(2, [&](size_t child) {
+            if (child == 0) {
+                buildNode(children, begin, leftCount, depth + 1);
+            }
+            else {
+                buildNode(children + 1, begin + leftCount, rightCount, depth + 1);
+            }
+        });
+    }
+    else {
+        buildNode(children, begin, leftCount, depth + 1);
+        buildNode(children + 1, begin + leftCount, rightCount, depth + 1);
+    }
+}
+
+// Renumbers the nodes depth first, so the output does not depend on which thread allocated what
+static void flatten(const Builder& builder, uint32_t buildIndex, uint32_t outIndex, size_t depth, MeshData& mesh, size_t& maxDepth) {
+    const BuildNode& node = builder.nodes[buildIndex];
+    for (int axis = 0; axis < 3; ++axis) {
+        mesh.bvhNodes[outIndex].boundsMin[axis] = node.boundsMin[axis];
+        mesh.bvhNodes[outIndex].boundsMax[axis] = node.boundsMax[axis];
+    }
+    maxDepth = std::max(maxDepth, depth);
+
+    if (node.count != 0) {
+        mesh.bvhNodes[outIndex].first = static_cast<uint32_t>(mesh.bvhPackets.size());
+        mesh.bvhNodes[outIndex].packetCount = static_cast<uint32_t>((node.count + PACKET_WIDTH - 1) / PACKET_WIDTH);
+        for (uint32_t first = 0; first < node.count; first += PACKET_WIDTH) {
+            TrianglePacket packet = {};
+            for (size_t lane = 0; lane < PACKET_WIDTH; ++lane) {
+                packet.triangle[lane] = TriangleBvh::INVALID_TRIANGLE;
+                if (first + lane >= node.count) {
+                    continue;
+                }
+                const BuildTriangle& triangle = builder.triangles[builder.order[node.begin + first + lane]];
+                glm::vec3 edge1 = triangle.v1 - triangle.v0;
+                glm::vec3 edge2 = triangle.v2 - triangle.v0;
+                for (int axis = 0; axis < 3; ++axis) {
+                    packet.v0[axis][lane] = triangle.v0[axis];
+                    packet.edge1[axis][lane] = edge1[axis];
+                    packet.edge2[axis][lane] = edge2[axis];
+                }
+                packet.triangle[lane] = triangle.id;
+            }
+            mesh.bvhPackets.push_back(packet);
+        }
+        return;
+    }
+
+    uint32_t pair = static_cast<uint32_t>(mesh.bvhNodes.size());
+    mesh.bvhNodes.resize(pair + 2);
+    mesh.bvhNodes[outIndex].first = pair;
+    mesh.bvhNodes[outIndex].packetCount = 0;
+    flatten(builder, node.left, pair, depth + 1, mesh, maxDepth);
+    flatten(builder, node.left + 1, pair + 1, depth + 1, mesh, maxDepth);
+}
+
+void TriangleBvh::build(MeshData& mesh, ThreadPool* pool, BuildStats* stats) {
+    build(mesh, mesh.vertices.data(), mesh.indices.data(), pool, stats);
+}
+
+void TriangleBvh::build(MeshData& mesh, const Vertex* vertices, const uint32_t* indices, ThreadPool* pool, BuildStats* stats) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    mesh.bvhNodes.clear();
+    mesh.bvhPackets.clear();
+
+    // The base level's index ranges; a mesh without submeshes is one range
+    std::vector<BuildTriangle> triangles;
+    auto addRange = [&](size_t firstIndex, size_t indexCount) {
+        for (size_t i = firstIndex; i + 3 <= firstIndex + indexCount; i += 3) {
+            BuildTriangle triangle;
+            triangle.v0 = vertices[indices[i]].position;
+            triangle.v1 = vertices[indices[i + 1]].position;
+            triangle.v2 = vertices[indices[i + 2]].position;
+            triangle.boundsMin = glm::min(triangle.v0, glm::min(triangle.v1, triangle.v2));
+            triangle.boundsMax = glm::max(triangle.v0, glm::max(triangle.v1, triangle.v2));
+            triangle.centroid = (triangle.boundsMin + triangle.boundsMax) * 0.5f;
+            triangle.id = static_cast<uint32_t>(i / 3);
+            triangles.push_back(triangle);
+        }
+    };
+    if (mesh.submeshes.empty()) {
+        addRange(0, mesh.indices.size());
+    }
+    else {
+        size_t firstSubmesh = mesh.lods.empty() ? 0 : mesh.lods[0].firstSubmesh;
+        size_t submeshCount = mesh.lods.empty() ? mesh.submeshes.size() : mesh.lods[0].submeshCount;
+        for (size_t submesh = firstSubmesh; submesh < firstSubmesh + submeshCount; ++submesh) {
+            addRange(mesh.submeshes[submesh].firstIndex, mesh.submeshes[submesh].indexCount);
+        }
+    }
+
+    size_t depth = 0;
+    if (!triangles.empty()) {
+        std::vector<uint32_t> order(triangles.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = static_cast<uint32_t>(i);
+        }
+        Builder builder(triangles, order, pool);
+        builder.buildNode(0, 0, static_cast<uint32_t>(triangles.size()), 0);
+
+        mesh.bvhNodes.reserve(builder.nodeCount.load());
+        mesh.bvhPackets.reserve((triangles.size() + PACKET_WIDTH - 1) / PACKET_WIDTH * 2);
+        mesh.bvhNodes.resize(1);
+        flatten(builder, 0, 0, 0, mesh, depth);
+        mesh.bvhPackets.shrink_to_fit();
+    }
+
+    if (stats != nullptr) {
+        auto endTime = std::chrono::high_resolution_clock::now();
+        stats->triangles = triangles.size();
+        stats->nodes = mesh.bvhNodes.size();
+        stats->packets = mesh.bvhPackets.size();
+        stats->depth = depth;
+        stats->milliseconds = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+    }
+}
+
+bool TriangleBvh::isValid(const TriangleBvhNode* nodes, size_t nodeCount, const TrianglePacket* packets, size_t packetCount, size_t triangleCount) {
+    // Children always come after their parent, so one pass in order sees every parent's depth first
+    std::vector<uint32_t> depths(nodeCount, 0);
+    for (size_t i = 0; i < nodeCount; ++i) {
+        const TriangleBvhNode& node = nodes[i];
+        if (node.packetCount != 0) {
+            if (static_cast<uint64_t>(node.first) + node.packetCount > packetCount) {
+                return false;
+            }
+            continue;
+        }
+        if (node.first <= i || static_cast<uint64_t>(node.first) + 1 >= nodeCount || depths[i] >= MAX_DEPTH) {
+            return false;
+        }
+        depths[node.first] = std::max(depths[node.first], depths[i] + 1);
+        depths[node.first + 1] = std::max(depths[node.first + 1], depths[i] + 1);
+    }
+    for (size_t i = 0; i < packetCount; ++i) {
+        for (size_t lane = 0; lane < PACKET_WIDTH; ++lane) {
+            uint32_t triangle = packets[i].triangle[lane];
+            if (triangle != INVALID_TRIANGLE && triangle >= triangleCount) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Slab test; returns the entry distance, or a negative value when the ray misses within maxDistance
+static float rayEntersNode(const TriangleBvhNode& node, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance) {
+    glm::vec3 t0 = (glm::vec3(node.boundsMin[0], node.boundsMin[1], node.boundsMin[2]) - origin) * inverseDirection;
+    glm::vec3 t1 = (glm::vec3(node.boundsMax[0], node.boundsMax[1], node.boundsMax[2]) - origin) * inverseDirection;
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar = glm::max(t0, t1);
+    float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+    return enter <= exit ? enter : -1.0f;
+}
+
+// Moller-Trumbore against the four lanes of a packet; narrows bestDistance and returns the lane hit,
+// or -1 when no lane is closer than bestDistance
+static int intersectPacket(const TrianglePacket& packet, const glm::vec3& origin, const glm::vec3& direction, float& bestDistance,
+    float& bestU, float& bestV) {
+    float t[PACKET_WIDTH], u[PACKET_WIDTH], v[PACKET_WIDTH];
+    int mask = 0;
+#ifdef TRIANGLE_BVH_SSE
+    __m128 dx = _mm_set1_ps(direction.x), dy = _mm_set1_ps(direction.y), dz = _mm_set1_ps(direction.z);
+    __m128 e1x = _mm_loadu_ps(packet.edge1[0]), e1y = _mm_loadu_ps(packet.edge1[1]), e1z = _mm_loadu_ps(packet.edge1[2]);
+    __m128 e2x = _mm_loadu_ps(packet.edge2[0]), e2y = _mm_loadu_ps(packet.edge2[1]), e2z = _mm_loadu_ps(packet.edge2[2]);
+
+    // p = d x e2, det = e1 . p
+    __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+    __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+    __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+    __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+    __m128 inverseDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+    __m128 sx = _mm_sub_ps(_mm_set1_ps(origin.x), _mm_loadu_ps(packet.v0[0]));
+    __m128 sy = _mm_sub_ps(_mm_set1_ps(origin.y), _mm_loadu_ps(packet.v0[1]));
+    __m128 sz = _mm_sub_ps(_mm_set1_ps(origin.z), _mm_loadu_ps(packet.v0[2]));
+    __m128 uu = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inverseDet);
+
+    // q = s x e1
+    __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+    __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+    __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+    __m128 vv = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inverseDet);
+    __m128 tt = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverseDet);
+
+    // A zero determinant (parallel ray or padding lane) makes everything NaN or infinite and fails below
+    __m128 zero = _mm_setzero_ps();
+    __m128 hit = _mm_cmpneq_ps(det, zero);
+    hit = _mm_and_ps(hit, _mm_cmpge_ps(uu, zero));
+    hit = _mm_and_ps(hit, _mm_cmpge_ps(vv, zero));
+    hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(uu, vv), _mm_set1_ps(1.0f)));
+    hit = _mm_and_ps(hit, _mm_cmpge_ps(tt, zero));
+    hit = _mm_and_ps(hit, _mm_cmplt_ps(tt, _mm_set1_ps(bestDistance)));
+    mask = _mm_movemask_ps(hit);
+    if (mask == 0) {
+        return -1;
+    }
+    _mm_storeu_ps(t, tt);
+    _mm_storeu_ps(u, uu);
+    _mm_storeu_ps(v, vv);
+#else
+    for (size_t lane = 0; lane < PACKET_WIDTH; ++lane) {
+        glm::vec3 edge1(packet.edge1[0][lane], packet.edge1[1][lane], packet.edge1[2][lane]);
+        glm::vec3 edge2(packet.edge2[0][lane], packet.edge2[1][lane], packet.edge2[2][lane]);
+        glm::vec3 p = glm::cross(direction, edge2);
+        float det = glm::dot(edge1, p);
+        if (det == 0.0f) {
+            continue;
+        }
+        float inverseDet = 1.0f / det;
+        glm::vec3 s = origin - glm::vec3(packet.v0[0][lane], packet.v0[1][lane], packet.v0[2][lane]);
+        glm::vec3 q = glm::cross(s, edge1);
+        u[lane] = glm::dot(s, p) * inverseDet;
+        v[lane] = glm::dot(direction, q) * inverseDet;
+        t[lane] = glm::dot(edge2, q) * inverseDet;
+        if (u[lane] >= 0.0f && v[lane] >= 0.0f && u[lane] + v[lane] <= 1.0f && t[lane] >= 0.0f && t[lane] < bestDistance) {
+            mask |= 1 << lane;
+        }
+    }
+#endif
+
+    int bestLane = -1;
+    for (size_t lane = 0; lane < PACKET_WIDTH; ++lane) {
+        if ((mask & (1 << lane)) && t[lane] < bestDistance) {
+            bestDistance = t[lane];
+            bestU = u[lane];
+            bestV = v[lane];
+            bestLane = static_cast<int>(lane);
+        }
+    }
+    return bestLane;
+}
+
+static glm::vec3 laneVertex(const float (&values)[3][4], size_t lane) {
+    return glm::vec3(values[0][lane], values[1][lane], values[2][lane]);
+}
+
+bool TriangleBvh::raycast(const MeshData& mesh, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) {
+    hit = RayHit();
+    if (mesh.bvhNodes.empty()) {
+        return false;
+    }
+    // A zero component would make 0 * inf = NaN for a ray starting on a node's face; a huge finite inverse gives 0
+    glm::vec3 inverseDirection;
+    for (int axis = 0; axis < 3; ++axis) {
+        inverseDirection[axis] = 1.0f / (std::fabs(direction[axis]) > 1e-20f ? direction[axis] : std::copysign(1e-20f, direction[axis]));
+    }
+    float bestDistance = maxDistance;
+    const TrianglePacket* bestPacket = nullptr;
+    int bestLane = -1;
+
+    struct Entry {
+        uint32_t node;
+        float distance;
+    };
+    Entry stack[STACK_SIZE];
+    size_t top = 0;
+    float rootDistance = rayEntersNode(mesh.bvhNodes[0], origin, inverseDirection, bestDistance);
+    if (rootDistance >= 0.0f) {
+        stack[top++] = { 0, rootDistance };
+    }
+    while (top != 0) {
+        Entry entry = stack[--top];
+        if (entry.distance >= bestDistance) {
+            continue;
+        }
+        const TriangleBvhNode& node = mesh.bvhNodes[entry.node];
+        if (node.packetCount != 0) {
+            for (uint32_t packet = node.first; packet < node.first + node.packetCount; ++packet) {
+                int lane = intersectPacket(mesh.bvhPackets[packet], origin, direction, bestDistance, hit.u, hit.v);
+                if (lane >= 0) {
+                    bestPacket = &mesh.bvhPackets[packet];
+                    bestLane = lane;
+                }
+            }
+            continue;
+        }
+
+        // Nearer child on top of the stack, so it can shorten the ray before the other is opened
+        float leftDistance = rayEntersNode(mesh.bvhNodes[node.first], origin, inverseDirection, bestDistance);
+        float rightDistance = rayEntersNode(mesh.bvhNodes[node.first + 1], origin, inverseDirection, bestDistance);
+        Entry left = { node.first, leftDistance };
+        Entry right = { node.first + 1, rightDistance };
+        if (leftDistance > rightDistance) {
+            std::swap(left, right);
+        }
+        if (right.distance >= 0.0f) {
+            stack[top++] = right;
+        }
+        if (left.distance >= 0.0f) {
+            stack[top++] = left;
+        }
+    }
+
+    if (bestPacket == nullptr) {
+        hit = RayHit();
+        return false;
+    }
+    hit.triangle = bestPacket->triangle[bestLane];
+    hit.distance = bestDistance;
+    glm::vec3 normal = glm::normalize(glm::cross(laneVertex(bestPacket->edge1, bestLane), laneVertex(bestPacket->edge2, bestLane)));
+    hit.normal = glm::dot(normal, direction) > 0.0f ? -normal : normal;
+    return true;
+}
+
+glm::vec3 TriangleBvh::closestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    // Voronoi regions of the vertices, then the edges, then the face (Ericson, Real-Time Collision Detection 5.1.5)
+    glm::vec3 ab = b - a;
+    glm::vec3 ac = c - a;
+    glm::vec3 ap = p - a;
+    float d1 = glm::dot(ab, ap);
+    float d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) {
+        return a;
+    }
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp);
+    float d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3) {
+        return b;
+    }
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        return a + ab * (d1 / (d1 - d3));
+    }
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp);
+    float d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6) {
+        return c;
+    }
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        return a + ac * (d2 / (d2 - d6));
+    }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    }
+    float denominator = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+// Closest points of segments p1-q1 and p2-q2 (Ericson 5.1.9); returns the squared distance
+static float closestPointsOfSegments(const glm::vec3& p1, const glm::vec3& q1, const glm::vec3& p2, const glm::vec3& q2,
+    glm::vec3& c1, glm::vec3& c2) {
+    const float epsilon = 1e-12f;
+    glm::vec3 d1 = q1 - p1;
+    glm::vec3 d2 = q2 - p2;
+    glm::vec3 r = p1 - p2;
+    float a = glm::dot(d1, d1);
+    float e = glm::dot(d2, d2);
+    float f = glm::dot(d2, r);
+    float s = 0.0f;
+    float t = 0.0f;
+    if (a <= epsilon && e <= epsilon) {
+        // Both are points
+    }
+    else if (a <= epsilon) {
+        t = glm::clamp(f / e, 0.0f, 1.0f);
+    }
+    else {
+        float c = glm::dot(d1, r);
+        if (e <= epsilon) {
+            s = glm::clamp(-c / a, 0.0f, 1.0f);
+        }
+        else {
+            float b = glm::dot(d1, d2);
+            float denominator = a * e - b * b;
+            s = denominator != 0.0f ? glm::clamp((b * f - c * e) / denominator, 0.0f, 1.0f) : 0.0f;
+            t = (b * s + f) / e;
+            if (t < 0.0f) {
+                t = 0.0f;
+                s = glm::clamp(-c / a, 0.0f, 1.0f);
+            }
+            else if (t > 1.0f) {
+                t = 1.0f;
+                s = glm::clamp((b - c) / a, 0.0f, 1.0f);
+            }
+        }
+    }
+    c1 = p1 + d1 * s;
+    c2 = p2 + d2 * t;
+    glm::vec3 offset = c1 - c2;
+    return glm::dot(offset, offset);
+}
+
+// Lanes of a packet whose plane passes within radius of segment a-b (a point when a == b). Cheap enough
+// to run on every packet the traversal reaches; the exact distance is only worked out for these.
+static int packetNearSegment(const TrianglePacket& packet, const glm::vec3& a, const glm::vec3& b, float radius) {
+    int mask = 0;
+#ifdef TRIANGLE_BVH_SSE
+    __m128 e1x = _mm_loadu_ps(packet.edge1[0]), e1y = _mm_loadu_ps(packet.edge1[1]), e1z = _mm_loadu_ps(packet.edge1[2]);
+    __m128 e2x = _mm_loadu_ps(packet.edge2[0]), e2y = _mm_loadu_ps(packet.edge2[1]), e2z = _mm_loadu_ps(packet.edge2[2]);
+    __m128 nx = _mm_sub_ps(_mm_mul_ps(e1y, e2z), _mm_mul_ps(e1z, e2y));
+    __m128 ny = _mm_sub_ps(_mm_mul_ps(e1z, e2x), _mm_mul_ps(e1x, e2z));
+    __m128 nz = _mm_sub_ps(_mm_mul_ps(e1x, e2y), _mm_mul_ps(e1y, e2x));
+    __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz));
+    __m128 limit = _mm_mul_ps(_mm_set1_ps(radius), _mm_sqrt_ps(lengthSquared));
+
+    __m128 v0x = _mm_loadu_ps(packet.v0[0]), v0y = _mm_loadu_ps(packet.v0[1]), v0z = _mm_loadu_ps(packet.v0[2]);
+    __m128 distanceA = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, _mm_sub_ps(_mm_set1_ps(a.x), v0x)), _mm_mul_ps(ny, _mm_sub_ps(_mm_set1_ps(a.y), v0y))),
+        _mm_mul_ps(nz, _mm_sub_ps(_mm_set1_ps(a.z), v0z)));
+    __m128 distanceB = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, _mm_sub_ps(_mm_set1_ps(b.x), v0x)), _mm_mul_ps(ny, _mm_sub_ps(_mm_set1_ps(b.y), v0y))),
+        _mm_mul_ps(nz, _mm_sub_ps(_mm_set1_ps(b.z), v0z)));
+
+    // Rejected when both ends are beyond the radius on the same side; degenerate lanes are rejected too
+    __m128 negativeLimit = _mm_sub_ps(_mm_setzero_ps(), limit);
+    __m128 above = _mm_and_ps(_mm_cmpgt_ps(distanceA, limit), _mm_cmpgt_ps(distanceB, limit));
+    __m128 below = _mm_and_ps(_mm_cmplt_ps(distanceA, negativeLimit), _mm_cmplt_ps(distanceB, negativeLimit));
+    __m128 valid = _mm_cmpgt_ps(lengthSquared, _mm_setzero_ps());
+    mask = _mm_movemask_ps(_mm_andnot_ps(_mm_or_ps(above, below), valid));
+#else
+    for (size_t lane = 0; lane < PACKET_WIDTH; ++lane) {
+        glm::vec3 normal = glm::cross(laneVertex(packet.edge1, lane), laneVertex(packet.edge2, lane));
+        float lengthSquared = glm::dot(normal, normal);
+        float limit = radius * std::sqrt(lengthSquared);
+        glm::vec3 v0 = laneVertex(packet.v0, lane);
+        float distanceA = glm::dot(normal, a - v0);
+        float distanceB = glm::dot(normal, b - v0);
+        bool above = distanceA > limit && distanceB > limit;
+        bool below = distanceA < -limit && distanceB < -limit;
+        if (lengthSquared > 0.0f && !above && !below) {
+            mask |= 1 << lane;
+        }
+    }
+#endif
+    return mask;
+}
+
+// Exact test of one triangle against segment a-b (a point when a == b) with the given radius
+static bool segmentContact(const TrianglePacket& packet, size_t lane, const glm::vec3& a, const glm::vec3& b, float radius,
+    TriangleBvh::Contact& contact) {
+    glm::vec3 v0 = laneVertex(packet.v0, lane);
+    glm::vec3 edge1 = laneVertex(packet.edge1, lane);
+    glm::vec3 edge2 = laneVertex(packet.edge2, lane);
+    glm::vec3 v1 = v0 + edge1;
+    glm::vec3 v2 = v0 + edge2;
+    glm::vec3 faceNormal = glm::normalize(glm::cross(edge1, edge2));
+    float distanceA = glm::dot(faceNormal, a - v0);
+    float distanceB = glm::dot(faceNormal, b - v0);
+    contact.triangle = packet.triangle[lane];
+
+    // A segment through the face: push out to the side its longer part is on
+    if (distanceA * distanceB < 0.0f) {
+        float t = distanceA / (distanceA - distanceB);
+        glm::vec3 crossing = a + (b - a) * t;
+        glm::vec3 onFace = TriangleBvh::closestPointOnTriangle(crossing, v0, v1, v2);
+        glm::vec3 offset = crossing - onFace;
+        if (glm::dot(offset, offset) <= 1e-10f * glm::dot(edge1, edge1)) {
+            bool aSide = std::fabs(distanceA) >= std::fabs(distanceB);
+            contact.point = crossing;
+            contact.normal = (aSide ? distanceA : distanceB) > 0.0f ? faceNormal : -faceNormal;
+            contact.depth = radius + std::min(std::fabs(distanceA), std::fabs(distanceB));
+            return true;
+        }
+    }
+
+    // Otherwise the closest pair involves an end of the segment or an edge of the triangle
+    glm::vec3 onSegment = a;
+    glm::vec3 onTriangle = TriangleBvh::closestPointOnTriangle(a, v0, v1, v2);
+    float bestSquared = glm::dot(a - onTriangle, a - onTriangle);
+    if (b != a) {
+        glm::vec3 candidate = TriangleBvh::closestPointOnTriangle(b, v0, v1, v2);
+        float squared = glm::dot(b - candidate, b - candidate);
+        if (squared < bestSquared) {
+            bestSquared = squared;
+            onSegment = b;
+            onTriangle = candidate;
+        }
+        const glm::vec3 corners[3] = { v0, v1, v2 };
+        for (int edge = 0; edge < 3; ++edge) {
+            glm::vec3 segmentPoint, edgePoint;
+            squared = closestPointsOfSegments(a, b, corners[edge], corners[(edge + 1) % 3], segmentPoint, edgePoint);
+            if (squared < bestSquared) {
+                bestSquared = squared;
+                onSegment = segmentPoint;
+                onTriangle = edgePoint;
+            }
+        }
+    }
+    if (bestSquared > radius * radius) {
+        return false;
+    }
+
+    float distance = std::sqrt(bestSquared);
+    contact.point = onTriangle;
+    if (distance > 1e-6f) {
+        contact.normal = (onSegment - onTriangle) / distance;
+    }
+    else {
+        contact.normal = glm::dot(faceNormal, onSegment - v0) + glm::dot(faceNormal, (a + b) * 0.5f - v0) >= 0.0f ? faceNormal : -faceNormal;
+    }
+    contact.depth = radius - distance;
+    return true;
+}
+
+static void overlapSegment(const MeshData& mesh, const glm::vec3& a, const glm::vec3& b, float radius, std::vector<TriangleBvh::Contact>& contacts) {
+    contacts.clear();
+    if (mesh.bvhNodes.empty()) {
+        return;
+    }
+    // Nodes are tested against the box around the swept sphere
+    glm::vec3 queryMin = glm::min(a, b) - glm::vec3(radius);
+    glm::vec3 queryMax = glm::max(a, b) + glm::vec3(radius);
+
+    uint32_t stack[STACK_SIZE];
+    size_t top = 0;
+    stack[top++] = 0;
+    while (top != 0) {
+        const TriangleBvhNode& node = mesh.bvhNodes[stack[--top]];
+        if (node.boundsMin[0] > queryMax.x || node.boundsMin[1] > queryMax.y || node.boundsMin[2] > queryMax.z ||
+            node.boundsMax[0] < queryMin.x || node.boundsMax[1] < queryMin.y || node.boundsMax[2] < queryMin.z) {
+            continue;
+        }
+        if (node.packetCount == 0) {
+            stack[top++] = node.first;
+            stack[top++] = node.first + 1;
+            continue;
+        }
+        for (uint32_t packet = node.first; packet < node.first + node.packetCount; ++packet) {
+            int mask = packetNearSegment(mesh.bvhPackets[packet], a, b, radius);
+            for (size_t lane = 0; lane < PACKET_WIDTH; ++lane) {
+                TriangleBvh::Contact contact;
+                if ((mask & (1 << lane)) && segmentContact(mesh.bvhPackets[packet], lane, a, b, radius, contact)) {
+                    contacts.push_back(contact);
+                }
+            }
+        }
+    }
+}
+
+void TriangleBvh::overlapSphere(const MeshData& mesh, const glm::vec3& center, float radius, std::vector<Contact>& contacts) {
+    overlapSegment(mesh, center, center, radius, contacts);
+}
+
+void TriangleBvh::overlapCapsule(const MeshData& mesh, const glm::vec3& a, const glm::vec3& b, float radius, std::vector<Contact>& contacts) {
+    overlapSegment(mesh, a, b, radius, contacts);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#ifndef TRIANGLE_BVH_H
+#define TRIANGLE_BVH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "mesh_data.h"
+
+class ThreadPool;
+
+// Bounding volume hierarchy over the triangles of a mesh's base level, for ray casts and sphere and
+// capsule overlap tests in object space. Built top-down with a binned surface area heuristic; leaves
+// hold up to two packets of four triangles that are tested together with SSE. The hierarchy lives in
+// MeshData::bvhNodes / bvhPackets and is stored in cooked mesh files.
+class TriangleBvh {
+public:
+    static const uint32_t INVALID_TRIANGLE = UINT32_MAX;
+
+    struct BuildStats {
+        size_t triangles = 0;
+        size_t nodes = 0;
+        size_t packets = 0;
+        size_t depth = 0;
+        double milliseconds = 0.0;
+    };
+
+    struct RayHit {
+        uint32_t triangle = INVALID_TRIANGLE;
+        float distance = 0.0f;  // In units of the ray direction's length
+        float u = 0.0f;         // Barycentrics of the hit: weight of the second and third vertex
+        float v = 0.0f;
+        glm::vec3 normal{ 0.0f };  // Unit geometric normal, facing the ray origin
+    };
+
+    struct Contact {
+        uint32_t triangle;
+        glm::vec3 point;   // Closest point on the triangle
+        glm::vec3 normal;  // Unit direction from the triangle towards the shape
+        float depth;       // How far the shape reaches past the triangle
+    };
+
+    // Builds over the base level of mesh. With a pool, large subtrees are built in parallel; the result
+    // is the same either way. The second form reads vertices and indices from elsewhere, such as a
+    // file mapping, laid out as mesh.vertices and mesh.indices would be.
+    static void build(MeshData& mesh, ThreadPool* pool, BuildStats* stats = nullptr);
+    static void build(MeshData& mesh, const Vertex* vertices, const uint32_t* indices, ThreadPool* pool, BuildStats* stats = nullptr);
+
+    // Nearest triangle along the ray within maxDistance; both sides of a triangle are hit
+    static bool raycast(const MeshData& mesh, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit);
+    // Replace contacts with one entry per triangle within radius of the point or the segment a-b
+    static void overlapSphere(const MeshData& mesh, const glm::vec3& center, float radius, std::vector<Contact>& contacts);
+    static void overlapCapsule(const MeshData& mesh, const glm::vec3& a, const glm::vec3& b, float radius, std::vector<Contact>& contacts);
+
+    // Checks a stored hierarchy before it is used: children after their parent and in range, leaf packets
+    // in range, triangles below triangleCount and no deeper than the traversal stack allows
+    static bool isValid(const TriangleBvhNode* nodes, size_t nodeCount, const TrianglePacket* packets, size_t packetCount, size_t triangleCount);
+
+    static glm::vec3 closestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+};
+
+#endif // TRIANGLE_BVH_H
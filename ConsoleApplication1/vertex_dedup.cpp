@@ -0,0 +1,97 @@
+#include "vertex_dedup.h"
+#include <cstring>
+
+static_assert(sizeof(Vertex) == 8 * sizeof(float), "Vertex must be tightly packed for bitwise hashing");
+
+VertexDeduplicator::VertexDeduplicator() : mask(0), count(0) {}
+
+static size_t nextPowerOfTwo(size_t value) {
+    size_t result = 16;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+void VertexDeduplicator::reserve(size_t expectedUniqueVertices) {
+    size_t capacity = nextPowerOfTwo(expectedUniqueVertices * 2);
+    if (capacity <= slots.size()) {
+        return;
+    }
+    rehash(capacity);
+}
+
+void VertexDeduplicator::clear() {
+    for (Slot& slot : slots) {
+        slot.index = EMPTY_SLOT;
+    }
+    count = 0;
+}
+
+uint32_t VertexDeduplicator::hashVertex(const Vertex& vertex) {
+    uint32_t words[8];
+    std::memcpy(words, &vertex, sizeof(words));
+
+    // Four 64-bit words folded with a murmur3-style finalizer
+    uint64_t h = 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < 8; i += 2) {
+        uint64_t k = (static_cast<uint64_t>(words[i + 1]) << 32) | words[i];
+        k *= 0xFF51AFD7ED558CCDull;
+        k ^= k >> 33;
+        h ^= k;
+        h = (h << 27) | (h >> 37);
+        h = h * 5 + 0x52DCE729;
+    }
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return static_cast<uint32_t>(h);
+}
+
+bool VertexDeduplicator::sameBits(const Vertex& a, const Vertex& b) {
+    return std::memcmp(&a, &b, sizeof(Vertex)) == 0;
+}
+
+uint32_t VertexDeduplicator::insert(const Vertex& vertex, std::vector<Vertex>& vertices) {
+    if ((count + 1) * 2 > slots.size()) {
+        rehash(nextPowerOfTwo((count + 1) * 2));
+    }
+
+    uint32_t hash = hashVertex(vertex);
+    size_t slotIndex = hash & mask;
+
+    // Linear probing; the table is at most half full so chains stay short
+    while (true) {
+        Slot& slot = slots[slotIndex];
+        if (slot.index == EMPTY_SLOT) {
+            slot.hash = hash;
+            slot.index = static_cast<uint32_t>(vertices.size());
+            vertices.push_back(vertex);
+            ++count;
+            return slot.index;
+        }
+        if (slot.hash == hash && sameBits(vertices[slot.index], vertex)) {
+            return slot.index;
+        }
+        slotIndex = (slotIndex + 1) & mask;
+    }
+}
+
+void VertexDeduplicator::rehash(size_t newCapacity) {
+    std::vector<Slot> oldSlots;
+    oldSlots.swap(slots);
+
+    slots.assign(newCapacity, Slot{ 0, EMPTY_SLOT });
+    mask = newCapacity - 1;
+
+    for (const Slot& slot : oldSlots) {
+        if (slot.index == EMPTY_SLOT) {
+            continue;
+        }
+        size_t slotIndex = slot.hash & mask;
+        while (slots[slotIndex].index != EMPTY_SLOT) {
+            slotIndex = (slotIndex + 1) & mask;
+        }
+        slots[slotIndex] = slot;
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#ifndef VERTEX_DEDUP_H
+#define VERTEX_DEDUP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "vertex.h"
+
+// Open-addressing hash table mapping a vertex to its index in an output vertex array.
+// Vertices are hashed and compared by their exact bit pattern, so two vertices are only
+// merged when the GPU would see identical data. The table stores indices into the caller's
+// vertex array instead of copies, and never allocates per vertex once reserved.
+class VertexDeduplicator {
+public:
+    VertexDeduplicator();
+
+    // Sizes the table for up to expectedUniqueVertices entries at a load factor of at most 1/2
+    void reserve(size_t expectedUniqueVertices);
+    void clear();
+
+    // Returns the index of vertex in vertices, appending it first if it has not been seen yet
+    uint32_t insert(const Vertex& vertex, std::vector<Vertex>& vertices);
+
+    size_t size() const { return count; }
+
+    static uint32_t hashVertex(const Vertex& vertex);
+    static bool sameBits(const Vertex& a, const Vertex& b);
+
+private:
+    struct Slot {
+        uint32_t hash;
+        uint32_t index;  // EMPTY_SLOT when unused
+    };
+
+    static constexpr uint32_t EMPTY_SLOT = 0xFFFFFFFFu;
+
+    std::vector<Slot> slots;
+    size_t mask;
+    size_t count;
+
+    // Slots keep their hash, so growing never has to touch the vertex data
+    void rehash(size_t newCapacity);
+};
+
+#endif // VERTEX_DEDUP_H
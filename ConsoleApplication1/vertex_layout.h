@@ -0,0 +1,164 @@
+#pragma once
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "mesh_file.h"
+#include "vertex.h"
+
+// Compile-time vertex layouts. A vertex type describes its attributes once by specializing VertexTraits:
+//
+//   template <> struct VertexTraits<MyVertex> {
+//       using Layout = VertexLayout<
+//           VertexAttribute<0, float, 3, offsetof(MyVertex, position)>,
+//           VertexAttribute<1, int16_t, 2, offsetof(MyVertex, normal), true>>;
+//   };
+//
+// and the stride, attribute table, GL setup (vertex_layout_gl.h) and CPU conversion follow from it.
+// Every attribute feeds a float shader input; integer components are converted, normalized or not.
+
+// IEEE half-precision float, distinct from uint16_t so layouts can tell them apart
+struct Half {
+    uint16_t bits;
+};
+
+uint16_t floatToHalf(float value);  // Rounds to nearest even
+float halfToFloat(uint16_t value);
+
+template <typename T> struct ComponentTraits;
+template <> struct ComponentTraits<float> { static constexpr MeshComponentType type = MESH_COMPONENT_FLOAT; };
+template <> struct ComponentTraits<Half> { static constexpr MeshComponentType type = MESH_COMPONENT_HALF_FLOAT; };
+template <> struct ComponentTraits<int8_t> { static constexpr MeshComponentType type = MESH_COMPONENT_BYTE; };
+template <> struct ComponentTraits<uint8_t> { static constexpr MeshComponentType type = MESH_COMPONENT_UNSIGNED_BYTE; };
+template <> struct ComponentTraits<int16_t> { static constexpr MeshComponentType type = MESH_COMPONENT_SHORT; };
+template <> struct ComponentTraits<uint16_t> { static constexpr MeshComponentType type = MESH_COMPONENT_UNSIGNED_SHORT; };
+
+template <uint32_t Location, typename Component, uint32_t Components, size_t Offset, bool Normalized = false>
+struct VertexAttribute {
+    static_assert(Components >= 1 && Components <= 4, "Attributes have 1 to 4 components");
+
+    using ComponentType = Component;
+    static constexpr uint32_t location = Location;
+    static constexpr uint32_t components = Components;
+    static constexpr size_t offset = Offset;
+    static constexpr bool normalized = Normalized;
+
+    static constexpr MeshFileAttribute describe() {
+        return { Location, Components, ComponentTraits<Component>::type, Normalized ? 1u : 0u, static_cast<uint32_t>(Offset) };
+    }
+};
+
+template <typename... Attributes>
+struct VertexLayout {
+    static constexpr size_t attributeCount = sizeof...(Attributes);
+
+    static constexpr std::array<MeshFileAttribute, sizeof...(Attributes)> attributes() {
+        return { { Attributes::describe()... } };
+    }
+
+    // Calls f(Attribute()) for every attribute in declaration order
+    template <typename F>
+    static void forEach(F&& f) {
+        (f(Attributes()), ...);
+    }
+};
+
+template <typename V> struct VertexTraits;
+
+template <> struct VertexTraits<Vertex> {
+    using Layout = VertexLayout<
+        VertexAttribute<0, float, 3, offsetof(Vertex, position)>,
+        VertexAttribute<1, float, 3, offsetof(Vertex, normal)>,
+        VertexAttribute<2, float, 2, offsetof(Vertex, texCoord)>>;
+};
+
+// Tightly packed positions for depth-only passes
+struct PositionVertex {
+    glm::vec3 position;
+};
+
+template <> struct VertexTraits<PositionVertex> {
+    using Layout = VertexLayout<VertexAttribute<0, float, 3, offsetof(PositionVertex, position)>>;
+};
+
+template <typename V>
+std::vector<MeshFileAttribute> vertexAttributes() {
+    auto attributes = VertexTraits<V>::Layout::attributes();
+    return std::vector<MeshFileAttribute>(attributes.begin(), attributes.end());
+}
+
+namespace vertex_layout_detail {
+
+inline float decodeComponent(float value, bool) { return value; }
+inline float decodeComponent(Half value, bool) { return halfToFloat(value.bits); }
+
+// Integer components: GL's post-4.2 rules when normalized, plain conversion otherwise
+template <typename I>
+float decodeComponent(I value, bool normalized) {
+    if (!normalized) {
+        return static_cast<float>(value);
+    }
+    float scaled = static_cast<float>(value) / static_cast<float>(std::numeric_limits<I>::max());
+    return scaled < -1.0f ? -1.0f : scaled;
+}
+
+inline void encodeComponent(float value, bool, float& out) { out = value; }
+inline void encodeComponent(float value, bool, Half& out) { out.bits = floatToHalf(value); }
+
+template <typename I>
+void encodeComponent(float value, bool normalized, I& out) {
+    float maxValue = static_cast<float>(std::numeric_limits<I>::max());
+    float minValue = std::is_signed<I>::value ? (normalized ? -maxValue : static_cast<float>(std::numeric_limits<I>::min())) : 0.0f;
+    float scaled = normalized ? value * maxValue : value;
+    scaled = scaled < minValue ? minValue : (scaled > maxValue ? maxValue : scaled);
+    out = static_cast<I>(std::lround(scaled));
+}
+
+} // namespace vertex_layout_detail
+
+// Converts between any two described layouts attribute by attribute, matching on location. Components
+// missing from the source read as GL does (0, 0, 0, 1); source attributes the target lacks are dropped.
+// Conversion is numeric only: bounds-relative or octahedral encodings need VertexQuantizer.
+template <typename From, typename To>
+void convertVertices(const From* source, size_t count, To* destination) {
+    using namespace vertex_layout_detail;
+
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* in = reinterpret_cast<const uint8_t*>(source + i);
+        uint8_t* out = reinterpret_cast<uint8_t*>(destination + i);
+        std::memset(out, 0, sizeof(To));
+
+        VertexTraits<To>::Layout::forEach([&](auto target) {
+            using Target = decltype(target);
+            float values[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+            VertexTraits<From>::Layout::forEach([&](auto from) {
+                using Source = decltype(from);
+                using SourceComponent = typename Source::ComponentType;
+                if (Source::location == Target::location) {
+                    for (uint32_t c = 0; c < Source::components; ++c) {
+                        SourceComponent component;
+                        std::memcpy(&component, in + Source::offset + c * sizeof(SourceComponent), sizeof(component));
+                        values[c] = decodeComponent(component, Source::normalized);
+                    }
+                }
+            });
+
+            using TargetComponent = typename Target::ComponentType;
+            for (uint32_t c = 0; c < Target::components; ++c) {
+                TargetComponent component;
+                encodeComponent(values[c], Target::normalized, component);
+                std::memcpy(out + Target::offset + c * sizeof(TargetComponent), &component, sizeof(component));
+            }
+        });
+    }
+}
+
+#endif // VERTEX_LAYOUT_H
@@ -0,0 +1,29 @@
+#pragma once
+#ifndef VERTEX_LAYOUT_GL_H
+#define VERTEX_LAYOUT_GL_H
+
+#include <cstdint>
+#include <GL/glew.h>
+#include "vertex_layout.h"
+
+// Points the bound VAO's attributes at the bound GL_ARRAY_BUFFER, starting baseOffset bytes in,
+// using V's compile-time layout (component types double as GL enums)
+template <typename V>
+void applyVertexLayout(size_t baseOffset = 0) {
+    VertexTraits<V>::Layout::forEach([baseOffset](auto attribute) {
+        using Attribute = decltype(attribute);
+        glVertexAttribPointer(Attribute::location, static_cast<GLint>(Attribute::components),
+            ComponentTraits<typename Attribute::ComponentType>::type, Attribute::normalized ? GL_TRUE : GL_FALSE,
+            static_cast<GLsizei>(sizeof(V)), reinterpret_cast<const void*>(static_cast<uintptr_t>(baseOffset + Attribute::offset)));
+        glEnableVertexAttribArray(Attribute::location);
+    });
+}
+
+// Fills the bound GL_ARRAY_BUFFER with vertices and sets up the bound VAO for them
+template <typename V>
+void uploadVertices(const V* vertices, size_t count, GLenum usage = GL_STATIC_DRAW) {
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(count * sizeof(V)), vertices, usage);
+    applyVertexLayout<V>();
+}
+
+#endif // VERTEX_LAYOUT_GL_H
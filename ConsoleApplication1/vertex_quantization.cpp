@@ -0,0 +1,129 @@
+#include "vertex_quantization.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+glm::vec2 VertexQuantizer::octahedralEncode(const glm::vec3& normal) {
+    float sum = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+    if (sum <= 0.0f) {
+        return glm::vec2(0.0f, 0.0f);
+    }
+    glm::vec2 encoded(normal.x / sum, normal.y / sum);
+    if (normal.z < 0.0f) {
+        // Fold the lower hemisphere over the diagonals
+        glm::vec2 folded((1.0f - std::fabs(encoded.y)) * (encoded.x >= 0.0f ? 1.0f : -1.0f),
+            (1.0f - std::fabs(encoded.x)) * (encoded.y >= 0.0f ? 1.0f : -1.0f));
+        encoded = folded;
+    }
+    return encoded;
+}
+
+glm::vec3 VertexQuantizer::octahedralDecode(const glm::vec2& encoded) {
+    // Same arithmetic as octahedralDecode() in vertex_shader.glsl
+    glm::vec3 normal(encoded.x, encoded.y, 1.0f - std::fabs(encoded.x) - std::fabs(encoded.y));
+    float t = std::max(-normal.z, 0.0f);
+    normal.x += normal.x >= 0.0f ? -t : t;
+    normal.y += normal.y >= 0.0f ? -t : t;
+    return glm::normalize(normal);
+}
+
+static uint16_t quantizeUnorm16(float value) {
+    return static_cast<uint16_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f));
+}
+
+// Picks the rounding of each octahedral coordinate that decodes closest to the input, which matters
+// most at 8 bits
+static void quantizeNormal(const glm::vec3& normal, float maxValue, int32_t out[2]) {
+    glm::vec3 unit = glm::length(normal) > 0.0f ? glm::normalize(normal) : glm::vec3(0.0f, 0.0f, 1.0f);
+    glm::vec2 encoded = VertexQuantizer::octahedralEncode(unit);
+    float baseX = std::floor(encoded.x * maxValue);
+    float baseY = std::floor(encoded.y * maxValue);
+
+    float bestDot = -2.0f;
+    for (int dy = 0; dy < 2; ++dy) {
+        for (int dx = 0; dx < 2; ++dx) {
+            float qx = std::min(std::max(baseX + dx, -maxValue), maxValue);
+            float qy = std::min(std::max(baseY + dy, -maxValue), maxValue);
+            float d = glm::dot(unit, VertexQuantizer::octahedralDecode(glm::vec2(qx / maxValue, qy / maxValue)));
+            if (d > bestDot) {
+                bestDot = d;
+                out[0] = static_cast<int32_t>(qx);
+                out[1] = static_cast<int32_t>(qy);
+            }
+        }
+    }
+}
+
+template <typename CompactVertex>
+static VertexDecode quantizeVertices(const Vertex* vertices, size_t count, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+    std::vector<CompactVertex>& out, QuantizationError* error) {
+    using NormalComponent = typename std::remove_extent<decltype(CompactVertex::normal)>::type;
+    const float normalMax = static_cast<float>(std::numeric_limits<NormalComponent>::max());
+
+    glm::vec3 extent = boundsMax - boundsMin;
+    VertexDecode decode;
+    decode.positionOffset = boundsMin;
+    decode.positionScale = extent;
+    decode.octahedralNormals = true;
+    decode.normalScale = 1.0f / normalMax;
+
+    out.assign(count, CompactVertex{});
+    if (error != nullptr) {
+        *error = QuantizationError();
+    }
+    double positionErrorSum = 0.0, normalErrorSum = 0.0;
+
+    for (size_t i = 0; i < count; ++i) {
+        const Vertex& vertex = vertices[i];
+        CompactVertex& compact = out[i];
+
+        for (int axis = 0; axis < 3; ++axis) {
+            compact.position[axis] = extent[axis] > 0.0f ? quantizeUnorm16((vertex.position[axis] - boundsMin[axis]) / extent[axis]) : 0;
+        }
+
+        int32_t normal[2] = { 0, 0 };
+        quantizeNormal(vertex.normal, normalMax, normal);
+        compact.normal[0] = static_cast<NormalComponent>(normal[0]);
+        compact.normal[1] = static_cast<NormalComponent>(normal[1]);
+
+        compact.texCoord[0].bits = floatToHalf(vertex.texCoord.x);
+        compact.texCoord[1].bits = floatToHalf(vertex.texCoord.y);
+
+        if (error != nullptr) {
+            glm::vec3 decodedPosition = boundsMin + glm::vec3(compact.position[0] / 65535.0f, compact.position[1] / 65535.0f,
+                compact.position[2] / 65535.0f) * extent;
+            float positionError = glm::length(decodedPosition - vertex.position);
+            error->maxPosition = std::max(error->maxPosition, positionError);
+            positionErrorSum += positionError;
+
+            if (glm::length(vertex.normal) > 0.0f) {
+                glm::vec3 decodedNormal = VertexQuantizer::octahedralDecode(glm::vec2(normal[0] / normalMax, normal[1] / normalMax));
+                float cosine = std::min(std::max(glm::dot(decodedNormal, glm::normalize(vertex.normal)), -1.0f), 1.0f);
+                float degrees = std::acos(cosine) * 57.2957795f;
+                error->maxNormalDegrees = std::max(error->maxNormalDegrees, degrees);
+                normalErrorSum += degrees;
+            }
+
+            for (int axis = 0; axis < 2; ++axis) {
+                error->maxTexCoord = std::max(error->maxTexCoord, std::fabs(halfToFloat(compact.texCoord[axis].bits) - vertex.texCoord[axis]));
+            }
+        }
+    }
+
+    if (error != nullptr && count != 0) {
+        error->averagePosition = static_cast<float>(positionErrorSum / count);
+        error->averageNormalDegrees = static_cast<float>(normalErrorSum / count);
+    }
+    return decode;
+}
+
+VertexDecode VertexQuantizer::quantize(const Vertex* vertices, size_t count, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+    std::vector<CompactVertex16>& out, QuantizationError* error) {
+    return quantizeVertices(vertices, count, boundsMin, boundsMax, out, error);
+}
+
+VertexDecode VertexQuantizer::quantize(const Vertex* vertices, size_t count, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+    std::vector<CompactVertex12>& out, QuantizationError* error) {
+    return quantizeVertices(vertices, count, boundsMin, boundsMax, out, error);
+}
@@ -0,0 +1,84 @@
+#pragma once
+#ifndef VERTEX_QUANTIZATION_H
+#define VERTEX_QUANTIZATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "vertex.h"
+#include "vertex_layout.h"
+
+// GPU vertex layouts a model can be uploaded with
+enum class VertexFormat {
+    Float,      // Vertex as-is, 32 bytes
+    Compact16,  // CompactVertex16, 16 bytes
+    Compact12,  // CompactVertex12, 12 bytes
+};
+
+// Position in the mesh bounds (w unused), octahedral normal, UV
+struct CompactVertex16 {
+    uint16_t position[4];
+    int16_t normal[2];
+    Half texCoord[2];
+};
+
+// As CompactVertex16 with an 8-bit normal; the normal is only 2-byte aligned
+struct CompactVertex12 {
+    uint16_t position[3];
+    int8_t normal[2];
+    Half texCoord[2];
+};
+
+// Octahedral normals go in as unnormalized integers and are scaled in the shader, because GL 3.3 and
+// 4.2+ disagree on how signed integers normalize
+template <> struct VertexTraits<CompactVertex16> {
+    using Layout = VertexLayout<
+        VertexAttribute<0, uint16_t, 3, offsetof(CompactVertex16, position), true>,
+        VertexAttribute<1, int16_t, 2, offsetof(CompactVertex16, normal)>,
+        VertexAttribute<2, Half, 2, offsetof(CompactVertex16, texCoord)>>;
+};
+
+template <> struct VertexTraits<CompactVertex12> {
+    using Layout = VertexLayout<
+        VertexAttribute<0, uint16_t, 3, offsetof(CompactVertex12, position), true>,
+        VertexAttribute<1, int8_t, 2, offsetof(CompactVertex12, normal)>,
+        VertexAttribute<2, Half, 2, offsetof(CompactVertex12, texCoord)>>;
+};
+
+static_assert(sizeof(CompactVertex16) == 16, "CompactVertex16 layout changed");
+static_assert(sizeof(CompactVertex12) == 12, "CompactVertex12 layout changed");
+
+struct QuantizationError {
+    float maxPosition = 0.0f;      // Object-space units
+    float averagePosition = 0.0f;
+    float maxNormalDegrees = 0.0f;
+    float averageNormalDegrees = 0.0f;
+    float maxTexCoord = 0.0f;
+};
+
+// What the vertex shader needs to decode quantized vertices: positions are positionOffset +
+// attribute * positionScale, normals octahedralDecode(attribute * normalScale). The defaults describe
+// float vertices.
+struct VertexDecode {
+    glm::vec3 positionOffset{ 0.0f };
+    glm::vec3 positionScale{ 1.0f };
+    bool octahedralNormals = false;
+    float normalScale = 1.0f;
+};
+
+class VertexQuantizer {
+public:
+    // Positions are quantized relative to [boundsMin, boundsMax], which must contain every vertex.
+    // Measures the round-trip error when error is not null.
+    static VertexDecode quantize(const Vertex* vertices, size_t count, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+        std::vector<CompactVertex16>& out, QuantizationError* error = nullptr);
+    static VertexDecode quantize(const Vertex* vertices, size_t count, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+        std::vector<CompactVertex12>& out, QuantizationError* error = nullptr);
+
+    // Octahedral mapping of a unit vector to [-1, 1]^2 and back
+    static glm::vec2 octahedralEncode(const glm::vec3& normal);
+    static glm::vec3 octahedralDecode(const glm::vec2& encoded);
+};
+
+#endif // VERTEX_QUANTIZATION_H
@@ -1,15 +1,41 @@
 #version 330 core
 layout(location = 0) in vec3 aPos;
-layout(location = 1) in vec3 aNormal;
+layout(location = 1) in vec3 aNormal;  // Only .xy carries data for octahedral normals
 layout(location = 2) in vec2 aTexCoord;
+// Per instance (see InstanceBuffer), only read when u_Instanced is set
+layout(location = 3) in mat4 aInstanceMatrix;
+layout(location = 7) in vec4 aInstanceColor;
 
 uniform mat4 u_ModelMatrix;
 uniform mat4 u_ViewMatrix;
 uniform mat4 u_ProjectionMatrix;
+uniform bool u_Instanced = false;  // Take the model matrix and tint from the instance attributes
+
+// Quantized vertex decode (see VertexQuantizer); the defaults leave float vertices untouched
+uniform vec3 u_PositionOffset = vec3(0.0);
+uniform vec3 u_PositionScale = vec3(1.0);
+uniform bool u_OctahedralNormals = false;
+uniform float u_NormalScale = 1.0;  // Octahedral normals arrive as raw integers
 
 out vec2 TexCoord;
+out vec3 Normal;
+out vec4 InstanceColor;
+
+vec3 octahedralDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
 
 void main() {
-    gl_Position = u_ProjectionMatrix * u_ViewMatrix * u_ModelMatrix * vec4(aPos, 1.0);
+    vec3 position = u_PositionOffset + aPos * u_PositionScale;
+    vec3 normal = u_OctahedralNormals ? octahedralDecode(aNormal.xy * u_NormalScale) : aNormal;
+
+    mat4 model = u_Instanced ? aInstanceMatrix : u_ModelMatrix;
+    gl_Position = u_ProjectionMatrix * u_ViewMatrix * model * vec4(position, 1.0);
     TexCoord = aTexCoord;
+    Normal = mat3(model) * normal;
+    InstanceColor = u_Instanced ? aInstanceColor : vec4(1.0);
 }